@@ -0,0 +1,40 @@
+#include <ssoa/benchmark.h>
+#include <ssoa/service/servicesignature.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace ssoa;
+
+namespace
+{
+    /// Measures the throughput of an operation, in millions of calls per second.
+    template<typename F>
+    double measure(F operation)
+    {
+        return benchmark::measure(200000, operation) / 1e6;
+    }
+}
+
+int main()
+{
+    const std::string signature("RotateImage(in int, in buffer, out buffer)");
+    std::size_t sink = 0;
+
+    ServiceSignature::Parser original = ServiceSignature::getParser();
+    ServiceSignature::setParser(ServiceSignature::HANDWRITTEN_PARSER);
+    double handwritten = measure([&]() { sink += ServiceSignature::parse(signature).getInputParams().size(); });
+#ifndef SSOA_NO_REGEX
+    ServiceSignature::setParser(ServiceSignature::REGEX_PARSER);
+    double regex = measure([&]() { sink += ServiceSignature::parse(signature).getInputParams().size(); });
+    std::cout << "Signatures: regex parser " << regex << " M/s" << std::endl;
+#endif
+    ServiceSignature::setParser(original);
+    double cached = measure([&]() { sink += ServiceSignature(signature).getInputParams().size(); });
+
+    std::cout << "Signatures: hand-written parser " << handwritten << " M/s, cached " << cached
+              << " M/s" << std::endl;
+    // Keeps the parsing from being optimized away.
+    return sink > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,119 @@
+#include <ssoa/service/computepool.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using namespace ssoa;
+
+BOOST_AUTO_TEST_SUITE(computepool)
+
+    BOOST_AUTO_TEST_CASE( submit_test )
+    {
+        std::atomic<int> executed(0);
+        {
+            ComputePool pool(3);
+            for (int i = 0; i < 1000; i++) {
+                pool.submit([&executed]() { executed++; });
+            }
+            // Exceptions are logged, and do not stop the threads.
+            pool.submit([]() { throw std::runtime_error("Task failure"); });
+            pool.stop();
+            BOOST_CHECK_EQUAL(executed, 1000);
+            BOOST_CHECK_EQUAL(pool.getStatistics().submitted, 1001);
+            BOOST_CHECK_EQUAL(pool.getStatistics().queued, 0);
+
+            // Once stopped, tasks run on the calling thread.
+            pool.submit([&executed]() { executed++; });
+            BOOST_CHECK_EQUAL(executed, 1001);
+        }
+
+        ComputePool inlinePool(0);
+        inlinePool.submit([&executed]() { executed++; });
+        BOOST_CHECK_EQUAL(executed, 1002);
+    }
+
+    BOOST_AUTO_TEST_CASE( run_test )
+    {
+        ComputePool pool(4);
+        BOOST_CHECK(ComputePool::current() == NULL);
+
+        // Nested runs, from pool threads, must not deadlock even when all threads are busy.
+        const int outer = 50, inner = 64;
+        std::vector<std::atomic<int>> counts(outer);
+        std::atomic<int> onPool(0);
+        for (int i = 0; i < outer; i++) {
+            counts[i] = 0;
+            pool.submit([&, i]() {
+                ComputePool *current = ComputePool::current();
+                if (current == &pool) {
+                    onPool++;
+                    current->run(inner, [&, i](int) { counts[i]++; });
+                }
+            });
+        }
+        pool.stop();
+        BOOST_CHECK_EQUAL(onPool, outer);
+        for (int i = 0; i < outer; i++) {
+            BOOST_CHECK_EQUAL(counts[i], inner);
+        }
+
+        // The first error is reported to the caller, after all indices have been processed.
+        ComputePool failing(2);
+        std::atomic<int> processed(0);
+        BOOST_CHECK_THROW(failing.run(10, [&processed](int i) {
+            processed++;
+            if (i == 3) {
+                throw std::invalid_argument("Band failure");
+            }
+        }), std::runtime_error);
+        BOOST_CHECK_EQUAL(processed, 10);
+    }
+
+    BOOST_AUTO_TEST_CASE( try_submit_test )
+    {
+        ComputePool pool(1);
+        pool.setMaxQueued(2);
+
+        // Keep the only thread busy, so that the following tasks wait.
+        boost::mutex mutex;
+        boost::condition_variable condition;
+        bool started = false, released = false;
+        pool.submit([&]() {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            started = true;
+            condition.notify_all();
+            while (!released) {
+                condition.wait(lock);
+            }
+        });
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            while (!started) {
+                condition.wait(lock);
+            }
+        }
+
+        std::atomic<int> executed(0);
+        BOOST_CHECK(pool.trySubmit([&executed]() { executed++; }));
+        BOOST_CHECK(pool.trySubmit([&executed]() { executed++; }));
+        BOOST_CHECK(!pool.trySubmit([&executed]() { executed++; }));
+        // submit() ignores the limit.
+        pool.submit([&executed]() { executed++; });
+        BOOST_CHECK_EQUAL(pool.getStatistics().rejected, 1);
+
+        {
+            boost::lock_guard<boost::mutex> lock(mutex);
+            released = true;
+            condition.notify_all();
+        }
+        pool.stop();
+        BOOST_CHECK_EQUAL(executed, 3);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
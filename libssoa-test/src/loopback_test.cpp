@@ -0,0 +1,283 @@
+#include <ssoa/service/servicelistener.h>
+#include <ssoa/service/typedserviceskeleton.h>
+#include <ssoa/service/typedservicestub.h>
+#include <ssoa/utils.h>
+
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <atomic>
+#include <csignal>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+
+using namespace ssoa;
+using boost::asio::ip::tcp;
+using boost::posix_time::microsec_clock;
+using boost::posix_time::milliseconds;
+using boost::posix_time::ptime;
+using std::string;
+
+namespace
+{
+    struct LoopbackEchoName {
+        static const char * name() {
+            return "LoopbackEcho";
+        }
+    };
+
+    struct LoopbackSleepName {
+        static const char * name() {
+            return "LoopbackSleep";
+        }
+    };
+
+    typedef Signature<LoopbackEchoName, In<string>, Out<string>> EchoSignature;
+    typedef Signature<LoopbackSleepName, In<int>, Out<int>> SleepSignature;
+
+    /// The number of times EchoSkeleton has been invoked.
+    std::atomic<int> echoCalls(0);
+
+    class EchoSkeleton: public TypedServiceSkeleton<EchoSignature>
+    {
+    public:
+        EchoSkeleton(arg_deque arguments) :
+            TypedServiceSkeleton<EchoSignature>(std::move(arguments))
+        {
+        }
+
+        static ServiceSkeleton* create(arg_deque&& arguments) {
+            return new EchoSkeleton(std::move(arguments));
+        }
+
+        static void install() {
+            factory().install(serviceSignature(), create);
+        }
+
+        Response * invoke() {
+            echoCalls++;
+            return respond(inputArgument<0>().getValue());
+        }
+    };
+
+    /// Sleeps for the given number of milliseconds.
+    class SleepSkeleton: public TypedServiceSkeleton<SleepSignature>
+    {
+    public:
+        SleepSkeleton(arg_deque arguments) :
+            TypedServiceSkeleton<SleepSignature>(std::move(arguments))
+        {
+        }
+
+        static ServiceSkeleton* create(arg_deque&& arguments) {
+            return new SleepSkeleton(std::move(arguments));
+        }
+
+        static void install() {
+            factory().install(serviceSignature(), create);
+        }
+
+        Response * invoke() {
+            int duration = inputArgument<0>().getValue();
+            boost::this_thread::sleep(milliseconds(duration));
+            return respond(duration);
+        }
+    };
+
+    class SleepStub: public TypedServiceStub<SleepSignature>
+    {
+    public:
+        SleepStub(string port) :
+            TypedServiceStub<SleepSignature>("127.0.0.1", std::move(port))
+        {
+        }
+
+        int sleep(int duration) {
+            std::unique_ptr<Response> response(call(duration));
+            if (!response->isSuccessful()) {
+                throw std::runtime_error(response->getStatus());
+            }
+            return outputArgument<0>(*response).getValue();
+        }
+    };
+
+    /// A request sent by hand on a socket, with any timeout.
+    class RawRequest: public Service
+    {
+    public:
+        RawRequest(ServiceSignature signature) :
+            Service(std::move(signature))
+        {
+        }
+
+        std::vector<boost::asio::const_buffer> getConstBuffers(long timeout) {
+            return Service::getConstBuffers(headerTemplate(getSignature()), timeout);
+        }
+    };
+
+    /// Runs a ServiceListener on a free port of the loopback interface, and drains it on
+    /// destruction.
+    struct LoopbackServer
+    {
+        LoopbackServer(size_t computeThreads = 0, size_t maxConnections = 0) :
+            port(installServices()), listener("127.0.0.1", port, 2, SHARED_IO_SERVICE, computeThreads)
+        {
+            listener.setLimits(maxConnections, 0);
+            listener.setDrainTimeout(100);
+            thread = boost::thread(&ServiceListener::run, &listener);
+        }
+
+        ~LoopbackServer() {
+            // Handled by the listener, as in production.
+            std::raise(SIGTERM);
+            thread.join();
+        }
+
+        tcp::endpoint endpoint() const {
+            return tcp::endpoint(boost::asio::ip::address_v4::loopback(), boost::lexical_cast<unsigned short>(port));
+        }
+
+        /// Installs the services and the arguments once, before the first request, and finds a
+        /// free port.
+        static string installServices() {
+            static bool installed = []() {
+                ServiceArgumentInstaller arguments;
+                (void)arguments;
+                EchoSkeleton::install();
+                SleepSkeleton::install();
+                return true;
+            }();
+            (void)installed;
+
+            boost::asio::io_service ioService;
+            tcp::acceptor acceptor(ioService, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+            return boost::lexical_cast<string>(acceptor.local_endpoint().port());
+        }
+
+        string port;
+        ServiceListener listener;
+        boost::thread thread;
+        boost::asio::io_service client;
+    };
+
+    /// Sets the idle timeout of the skeletons for the scope of a test.
+    struct IdleTimeoutScope
+    {
+        IdleTimeoutScope(long milliseconds) {
+            ServiceSkeleton::setIdleTimeout(milliseconds);
+        }
+
+        ~IdleTimeoutScope() {
+            ServiceSkeleton::setIdleTimeout(30000);
+        }
+    };
+
+    /// Waits for the socket to have data to read, or to be closed by the peer.
+    bool readable(tcp::socket& socket, int timeout)
+    {
+        pollfd fd = { socket.native_handle(), POLLIN, 0 };
+        return ::poll(&fd, 1, timeout) == 1;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(loopback)
+
+    BOOST_AUTO_TEST_CASE( idle_timeout_test )
+    {
+        IdleTimeoutScope scope(200);
+        LoopbackServer server;
+
+        // A client stalled in the middle of its header is dropped without any response.
+        tcp::socket stalled(server.client);
+        stalled.connect(server.endpoint());
+        boost::asio::write(stalled, boost::asio::buffer("service: ", 9));
+        ptime start = microsec_clock::universal_time();
+        BOOST_REQUIRE(readable(stalled, 5000));
+        BOOST_CHECK_GE((microsec_clock::universal_time() - start).total_milliseconds(), 150);
+
+        char c;
+        boost::system::error_code ec;
+        BOOST_CHECK_EQUAL(stalled.read_some(boost::asio::buffer(&c, 1), ec), 0);
+        BOOST_CHECK(ec);
+
+        // The others are still served.
+        BOOST_CHECK_EQUAL(SleepStub(server.port).sleep(1), 1);
+    }
+
+    BOOST_AUTO_TEST_CASE( deadline_expired_test )
+    {
+        LoopbackServer server(1);
+        echoCalls = 0;
+
+        // Keep the only compute thread busy, so that the next request waits past its deadline.
+        boost::thread busy([&server]() { SleepStub(server.port).sleep(500); });
+        boost::this_thread::sleep(milliseconds(100));
+
+        RawRequest request(EchoSignature::get());
+        request.pushArgument(new ServiceStringArgument("late"));
+        tcp::socket socket(server.client);
+        socket.connect(server.endpoint());
+        boost::asio::write(socket, request.getConstBuffers(100));
+
+        std::unique_ptr<Response> response(Response::deserialize(socket));
+        BOOST_CHECK(!response->isSuccessful());
+        BOOST_CHECK_EQUAL(response->getStatus(), "Deadline expired.");
+        BOOST_CHECK_EQUAL(echoCalls, 0);
+        busy.join();
+    }
+
+    BOOST_AUTO_TEST_CASE( accept_pause_test )
+    {
+        // Pauses at 8 connections, and resumes at 6.
+        LoopbackServer server(0, 8);
+
+        std::vector<std::unique_ptr<tcp::socket>> idle;
+        for (int i = 0; i < 8; i++) {
+            idle.emplace_back(new tcp::socket(server.client));
+            idle.back()->connect(server.endpoint());
+        }
+
+        // The next connection waits in the backlog, with its request.
+        RawRequest request(EchoSignature::get());
+        request.pushArgument(new ServiceStringArgument("waiting"));
+        tcp::socket waiting(server.client);
+        waiting.connect(server.endpoint());
+        boost::asio::write(waiting, request.getConstBuffers(0));
+        BOOST_CHECK(!readable(waiting, 300));
+
+        idle[0].reset();
+        BOOST_CHECK(!readable(waiting, 300));
+
+        idle[1].reset();
+        BOOST_REQUIRE(readable(waiting, 5000));
+        std::unique_ptr<Response> response(Response::deserialize(waiting));
+        BOOST_REQUIRE(response->isSuccessful());
+        BOOST_CHECK_EQUAL(static_cast<ServiceStringArgument&>(response->getArgument(0)).getValue(), "waiting");
+    }
+
+    BOOST_AUTO_TEST_CASE( stub_timeout_test )
+    {
+        LoopbackServer server;
+        SleepStub stub(server.port);
+        stub.setTimeout(100);
+
+        ptime start = microsec_clock::universal_time();
+        try {
+            stub.sleep(500);
+            BOOST_ERROR("The stub has not timed out.");
+        }
+        catch (const boost::system::system_error& e) {
+            BOOST_CHECK(e.code() == boost::asio::error::timed_out);
+        }
+        BOOST_CHECK_LT((microsec_clock::universal_time() - start).total_milliseconds(), 400);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,8 +1,10 @@
 #include <ssoa/service/service.h>
 #include <ssoa/service/serviceargument.h>
+#include <ssoa/service/serviceargumentlist.h>
 
 #include <boost/test/unit_test.hpp>
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -22,6 +24,11 @@ public:
     void getConstBuffers() {
         Service::getConstBuffers();
     }
+    using Service::headerTemplate;
+    string getHeader(const string& headerTemplate, long timeout) {
+        boost::asio::const_buffer header = Service::getConstBuffers(headerTemplate, timeout)[0];
+        return string(boost::asio::buffer_cast<const char*>(header));
+    }
 };
 
 BOOST_AUTO_TEST_SUITE(service)
@@ -218,4 +225,82 @@ BOOST_AUTO_TEST_SUITE(service)
         BOOST_CHECK_NO_THROW(m.getConstBuffers());
     }
 
+    BOOST_AUTO_TEST_CASE( header_test )
+    {
+        MyService m("RotateImage(in int, in string)");
+        m.pushArgument(new ServiceIntArgument(90));
+        m.pushArgument(new ServiceStringArgument("hello"));
+
+        string byName = MyService::headerTemplate(ServiceSignature("RotateImage (in int, in string)"));
+        BOOST_CHECK_EQUAL(byName, "service: \"RotateImage(in int, in string)\"\n");
+        BOOST_CHECK_EQUAL(m.getHeader(byName, 0), byName + "blocks: [4, 5]\n");
+        BOOST_CHECK_EQUAL(m.getHeader(byName, 500), byName + "blocks: [4, 5]\ntimeout: 500\n");
+
+        string byId = MyService::headerTemplate(3, 12345);
+        BOOST_CHECK_EQUAL(byId, "id: 3\nepoch: 12345\n");
+        BOOST_CHECK_EQUAL(m.getHeader(byId, 0), byId + "blocks: [4, 5]\n");
+
+        // Signatures which are not valid are still sent as YAML strings.
+        BOOST_CHECK_EQUAL(MyService::headerTemplate(ServiceSignature::any), "service: \"*\"\n");
+    }
+
+    BOOST_AUTO_TEST_CASE( serviceargument_pool_test )
+    {
+        // The memory of a deleted argument is used again for the next one, of any type.
+        ServiceArgument *i = ServiceIntArgument::prepare(sizeof(int32_t));
+        void *block = i;
+        delete i;
+        ServiceArgument *d = new ServiceDoubleArgument(2.5);
+        BOOST_CHECK_EQUAL(static_cast<void*>(d), block);
+        delete d;
+        ServiceArgument *s = new ServiceStringArgument("short");
+        BOOST_CHECK_EQUAL(static_cast<void*>(s), block);
+
+        // Arguments are moved in and out of the list without being copied, also after the list
+        // has outgrown its inline storage.
+        MyService m("RotateImage(in string, in int, in double, in buffer, in int)");
+        m.pushArgument(static_cast<ServiceStringArgument*>(s));
+        m.pushArgument(new ServiceIntArgument(1));
+        m.pushArgument(new ServiceDoubleArgument(2.0));
+        m.pushArgument(new ServiceBufferArgument(vector<byte>(3)));
+        m.pushArgument(new ServiceIntArgument(5));
+        BOOST_CHECK_NO_THROW(m.getConstBuffers());
+        std::unique_ptr<ServiceStringArgument> first(m.popArgument<ServiceStringArgument>());
+        BOOST_CHECK_EQUAL(first.get(), s);
+        BOOST_CHECK_EQUAL(first->getValue(), "short");
+        delete m.popArgument<ServiceIntArgument>();
+        delete m.popArgument<ServiceDoubleArgument>();
+        delete m.popArgument<ServiceBufferArgument>();
+        std::unique_ptr<ServiceIntArgument> last(m.popArgument<ServiceIntArgument>());
+        BOOST_CHECK_EQUAL(last->getValue(), 5);
+    }
+
+    BOOST_AUTO_TEST_CASE( serviceargumentlist_test )
+    {
+        ServiceArgumentList list;
+        for (int i = 0; i < 10; i++) {
+            list.emplace_back(new ServiceIntArgument(i));
+            if (i % 3 == 2) {
+                list.pop_front();
+            }
+        }
+        BOOST_CHECK_EQUAL(list.size(), 7);
+        BOOST_CHECK_EQUAL(static_cast<ServiceIntArgument&>(*list.front()).getValue(), 3);
+        BOOST_CHECK_EQUAL(static_cast<ServiceIntArgument&>(*list[6]).getValue(), 9);
+
+        ServiceArgumentList moved(std::move(list));
+        BOOST_CHECK(list.empty());
+        BOOST_CHECK_EQUAL(moved.size(), 7);
+        BOOST_CHECK_EQUAL(static_cast<ServiceIntArgument&>(*moved.back()).getValue(), 9);
+
+        // Assigning inline arguments to a list which had grown.
+        ServiceArgumentList small;
+        small.emplace_back(new ServiceDoubleArgument(0.5));
+        moved = std::move(small);
+        BOOST_CHECK_EQUAL(moved.size(), 1);
+        BOOST_CHECK_EQUAL(static_cast<ServiceDoubleArgument&>(*moved.front()).getValue(), 0.5);
+        moved.emplace_back(new ServiceIntArgument(1));
+        BOOST_CHECK_EQUAL(moved.size(), 2);
+    }
+
     BOOST_AUTO_TEST_SUITE_END()
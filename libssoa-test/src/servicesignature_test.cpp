@@ -58,3 +58,60 @@ BOOST_AUTO_TEST_CASE( params_test )
     BOOST_CHECK_EQUAL(sigd.getOutputParams().size(), 1);
     BOOST_CHECK_EQUAL(sigd.getOutputParams()[0], "buffers");
 }
+
+BOOST_AUTO_TEST_CASE( cache_test )
+{
+    // Equal strings share the same parsed signature.
+    ServiceSignature siga("Thumbnail(in int, in buffer, out buffer)");
+    ServiceSignature sigb("Thumbnail(in int, in buffer, out buffer)");
+    BOOST_CHECK_EQUAL(&siga.getName(), &sigb.getName());
+
+    ServiceSignature sigc = ServiceSignature::parse("Thumbnail(in int, in buffer, out buffer)");
+    BOOST_CHECK(&siga.getName() != &sigc.getName());
+    BOOST_CHECK_EQUAL(siga, sigc);
+}
+
+#ifndef SSOA_NO_REGEX
+BOOST_AUTO_TEST_CASE( parsers_test )
+{
+    const char * signatures[] = {
+        "RotateImage(in int, in buffer, out buffer)",
+        "  RotateImage   (   in   int  ,  in  buffer  ,  out  buffer  )  ",
+        "RotateImage(in int,)",
+        "RotateImage(out int)",
+        "Rotate_Image2(in\tstring,out double)",
+        "RotateImage()",
+        "RotateImage( )",
+        "RotateImage(,)",
+        "RotateImage(in int",
+        "Rotate Image(in int, in buffer)",
+        "RotateImage(int int, in buffer)",
+        "RotateImage(in int in buffer)",
+        "RotateImage(in int, int buffer)",
+        "RotateImage(input int)",
+        "RotateImage(in int) x",
+        "(in int)",
+        "*",
+        ""
+    };
+
+    ServiceSignature::Parser original = ServiceSignature::getParser();
+    for (const char * s : signatures) {
+        ServiceSignature::setParser(ServiceSignature::HANDWRITTEN_PARSER);
+        ServiceSignature handwritten = ServiceSignature::parse(s);
+        ServiceSignature::setParser(ServiceSignature::REGEX_PARSER);
+        ServiceSignature regex = ServiceSignature::parse(s);
+
+        // Invalid signatures may be reported differently, but are invalid for both.
+        BOOST_CHECK_MESSAGE(handwritten.isValid() == regex.isValid(), s);
+        if (regex.isValid()) {
+            BOOST_CHECK_EQUAL(handwritten, regex);
+            BOOST_CHECK_EQUAL(handwritten.getName(), regex.getName());
+            BOOST_CHECK(handwritten.getInputParams() == regex.getInputParams());
+            BOOST_CHECK(handwritten.getOutputParams() == regex.getOutputParams());
+        }
+    }
+    BOOST_CHECK_EQUAL(ServiceSignature::parse("*"), ServiceSignature("*"));
+    ServiceSignature::setParser(original);
+}
+#endif
@@ -0,0 +1,93 @@
+#include <ssoa/service/typedsignature.h>
+#include <ssoa/service/typedserviceskeleton.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace ssoa;
+using std::string;
+using std::vector;
+
+typedef unsigned char byte;
+
+struct RotateImageName {
+    static const char * name() {
+        return "RotateImage";
+    }
+};
+
+struct EchoName {
+    static const char * name() {
+        return "Echo";
+    }
+};
+
+typedef Signature<RotateImageName, In<int>, In<Buffer>, Out<Buffer>> RotateImageSignature;
+typedef Signature<EchoName, In<int>, In<string>, Out<double>, Out<Buffer>> EchoSignature;
+
+class EchoSkeleton: public TypedServiceSkeleton<EchoSignature>
+{
+public:
+    EchoSkeleton(int value, string text) :
+        TypedServiceSkeleton<EchoSignature>(prepare(value, std::move(text)))
+    {
+    }
+
+    Response * invoke() {
+        const string& text = inputArgument<1>().getValue();
+        return respond(inputArgument<0>().getValue() / 2.0, vector<byte>(text.begin(), text.end()));
+    }
+
+private:
+    static arg_deque prepare(int value, string text) {
+        arg_deque result;
+        result.emplace_back(new ServiceIntArgument(value));
+        result.emplace_back(new ServiceStringArgument(std::move(text)));
+        return result;
+    }
+};
+
+BOOST_AUTO_TEST_SUITE(typedsignature)
+
+    BOOST_AUTO_TEST_CASE( signature_test )
+    {
+        BOOST_CHECK_EQUAL(RotateImageSignature::str(), string("RotateImage(in int, in buffer, out buffer)"));
+        BOOST_CHECK_EQUAL(EchoSignature::str(), string("Echo(in int, in string, out double, out buffer)"));
+
+        // The string form is the one parsed at run time.
+        const ServiceSignature& signature = RotateImageSignature::get();
+        BOOST_CHECK(signature.isValid());
+        BOOST_CHECK(signature == ServiceSignature("RotateImage(in int, in buffer, out buffer)"));
+        BOOST_CHECK_EQUAL(&signature, &RotateImageSignature::get());
+
+        BOOST_CHECK_EQUAL(RotateImageSignature::Inputs::size, 2);
+        BOOST_CHECK_EQUAL(RotateImageSignature::Outputs::size, 1);
+        BOOST_CHECK((std::is_same<RotateImageSignature::Input<0>::type, ServiceIntArgument>::value));
+        BOOST_CHECK((std::is_same<RotateImageSignature::Input<1>::type, ServiceBufferArgument>::value));
+        BOOST_CHECK((std::is_same<RotateImageSignature::Output<0>::type, ServiceBufferArgument>::value));
+        BOOST_CHECK((std::is_same<EchoSignature::Input<1>::type, ServiceStringArgument>::value));
+        BOOST_CHECK((std::is_same<EchoSignature::Output<0>::type, ServiceDoubleArgument>::value));
+    }
+
+    BOOST_AUTO_TEST_CASE( skeleton_test )
+    {
+        EchoSkeleton skeleton(5, "abc");
+        BOOST_CHECK_EQUAL(EchoSkeleton::serviceSignature(), EchoSignature::str());
+
+        std::unique_ptr<Response> response(skeleton.invoke());
+        BOOST_CHECK(response->isSuccessful());
+        BOOST_CHECK(response->getSignature() == EchoSignature::get());
+
+        // The results are those stated by the signature, so the checked accessors accept them.
+        std::unique_ptr<ServiceDoubleArgument> half(response->popArgument<ServiceDoubleArgument>());
+        std::unique_ptr<ServiceBufferArgument> bytes(response->popArgument<ServiceBufferArgument>());
+        BOOST_CHECK_EQUAL(half->getValue(), 2.5);
+        BOOST_CHECK_EQUAL(bytes->getValue().size(), 3);
+        BOOST_CHECK_EQUAL(bytes->getValue()[0], 'a');
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
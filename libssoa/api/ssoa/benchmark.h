@@ -0,0 +1,30 @@
+/*
+ * benchmark.h
+ */
+
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+#include <chrono>
+
+namespace ssoa
+{
+    namespace benchmark
+    {
+        /// Runs an operation the given number of times.
+        ///
+        /// @return The number of runs per second.
+        template<typename F>
+        double measure(int repetitions, F operation)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < repetitions; i++) {
+                operation();
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            return repetitions / elapsed.count();
+        }
+    }
+}
+
+#endif
@@ -7,16 +7,22 @@
 
 #include <ssoa/logger.h>
 
+#include <cstddef>
 #include <map>
+#include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace ssoa
 {
     /// Support for synchronous serialization of a class hierarchy.
     ///
+    /// Each installed class is given a small integer identifier, its position in the order of
+    /// installation, so that it can also be created through a lookup in a flat array.
+    ///
     /// Methods of this class should never be called from inside the destructor of a static
-    /// object.
+    /// object. Classes should be installed before instances are created concurrently.
     template<class T, typename ... Args>
     class FactoryBase
     {
@@ -32,12 +38,40 @@ namespace ssoa
         /// an exception @c std::runtime_error should be thrown.
         typedef T * (*CreatorMethod)(Args ... args);
 
+        /// The identifier returned by find() for classes which are not installed.
+        static const std::size_t npos = static_cast<std::size_t>(-1);
+
         /// Checks if a handler for the specified class is installed.
         ///
         /// @param className A null-terminated string identifying the class.
         bool contains(const std::string className)
         {
-            return mappings().find(className) != mappings().end();
+            return find(className) != npos;
+        }
+
+        /// Gets the identifier of the specified class.
+        ///
+        /// @param className A null-terminated string identifying the class.
+        ///
+        /// @return The identifier, or npos if no handler is installed for the class.
+        std::size_t find(const std::string& className)
+        {
+            auto iter = mappings().ids.find(className);
+            return iter != mappings().ids.end() ? iter->second : npos;
+        }
+
+        /// Gets the number of installed classes, whose identifiers are in [0, size()).
+        std::size_t size()
+        {
+            return mappings().creators.size();
+        }
+
+        /// Gets the name of the class with the specified identifier.
+        ///
+        /// @throws std::out_of_range No class has the given identifier.
+        const std::string& name(std::size_t id)
+        {
+            return mappings().creators.at(id).first;
         }
 
         /// Installs the creation handler for the specified class belonging to the hierarchy of @c T.
@@ -50,8 +84,8 @@ namespace ssoa
         /// @see CreatorMethod
         void install(const std::string className, CreatorMethod creator)
         {
-            auto iter = mappings().find(className);
-            if (iter != mappings().end()) {
+            auto iter = mappings().ids.find(className);
+            if (iter != mappings().ids.end()) {
                 throw std::logic_error(hierarchyName +
                                        std::string(": Duplicate initialization for identifier \"")
                                        + className + "\".");
@@ -59,7 +93,8 @@ namespace ssoa
             Logger::debug("FactoryBase: in hierarchy '%1%' added factory method for '%2%'.",
                           hierarchyName,
                           className);
-            mappings()[className] = creator;
+            mappings().ids[className] = mappings().creators.size();
+            mappings().creators.push_back(std::make_pair(className, creator));
         }
 
         /// Constructs a new instance of the proper class in the @c T hierarchy from the given @c args.
@@ -73,29 +108,50 @@ namespace ssoa
         /// @throws std::runtime_error No handler is installed for the specified class.
         T * create(const std::string className, Args ... args)
         {
-            auto iter = mappings().find(className);
-            if (iter == mappings().end()) {
+            auto iter = mappings().ids.find(className);
+            if (iter == mappings().ids.end()) {
                 throw std::runtime_error(hierarchyName +
                                          std::string(": Unknown message type: \"")
                                          + className + "\".");
             }
-            return (iter->second)(std::forward<Args>(args)...);
+            return (mappings().creators[iter->second].second)(std::forward<Args>(args)...);
+        }
+
+        /// Constructs a new instance of the class with the specified identifier (see find()).
+        ///
+        /// @throws std::runtime_error No class has the given identifier.
+        T * create(std::size_t id, Args ... args)
+        {
+            if (id >= mappings().creators.size()) {
+                throw std::runtime_error(hierarchyName + ": Unknown message identifier.");
+            }
+            return (mappings().creators[id].second)(std::forward<Args>(args)...);
         }
 
     private:
         std::string hierarchyName;
 
+        /// The installed classes, indexed by identifier, and the identifiers of their names.
+        struct Mappings
+        {
+            std::vector<std::pair<std::string, CreatorMethod>> creators;
+            std::map<std::string, std::size_t> ids;
+        };
+
         /// Contains mappings between a class and its "named constructor"
-        std::map<std::string, CreatorMethod>& mappings()
+        Mappings& mappings()
         {
             // Construct-on-first-use to avoid the static initialization order problem
-            static std::map<std::string, CreatorMethod> m;
+            static Mappings m;
             // Using static: many instances with equal template arguments will share the same m;
             // Using static object instead of static pointer: be careful not to call this method
             // from the destructor of a static object.
             return m;
         }
     };
+
+    template<class T, typename ... Args>
+    const std::size_t FactoryBase<T, Args...>::npos;
 }
 
 #ifndef stringify
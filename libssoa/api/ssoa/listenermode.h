@@ -0,0 +1,25 @@
+/*
+ * listenermode.h
+ */
+
+#ifndef _LISTENERMODE_H_
+#define _LISTENERMODE_H_
+
+namespace ssoa
+{
+    /// How the threads of a listener share the incoming connections.
+    enum ListenerMode
+    {
+        /// All threads run a single io_service, accepting connections on a single socket.
+        /// Handlers of the same connection may run on any thread.
+        SHARED_IO_SERVICE,
+
+        /// Each thread runs its own io_service, is pinned to a core and accepts connections on
+        /// its own SO_REUSEPORT socket, so that the kernel balances connections among threads and
+        /// each connection stays on one thread for its whole lifetime. Not available on systems
+        /// without SO_REUSEPORT.
+        IO_SERVICE_PER_THREAD
+    };
+}
+
+#endif
@@ -5,11 +5,14 @@
 #ifndef _REGISTRYLISTENER_H_
 #define _REGISTRYLISTENER_H_
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <boost/asio.hpp>
 #include <boost/noncopyable.hpp>
 
+#include <ssoa/listenermode.h>
 #include <ssoa/registry/iregistry.h>
 
 namespace ssoa
@@ -28,20 +31,39 @@ namespace ssoa
         /// @param port A string containing the port number.
         /// @param thread_pool_size The number of threads allocated in the pool.
         /// @param registry The actual registry implementation.
+        /// @param mode How the threads share the connections.
         ///
         /// @throws boost::system::system_error Thrown on failure.
         explicit RegistryListener(const std::string& host, const std::string& port, std::size_t thread_pool_size,
-            IRegistry& registry);
+            IRegistry& registry, ListenerMode mode = SHARED_IO_SERVICE);
 
-        /// Runs the server's io_service loop.
+        /// Runs the server's io_service loops.
         void run();
 
     private:
+        /// An io_service with its own acceptor.
+        struct Worker
+        {
+            Worker() :
+                acceptor(ioService)
+            {
+            }
+
+            /// The io_service used to perform asynchronous operations.
+            boost::asio::io_service ioService;
+
+            /// Acceptor used to listen for incoming connections.
+            boost::asio::ip::tcp::acceptor acceptor;
+
+            /// The next connection to be accepted.
+            std::shared_ptr<ClientHandler> clientHandler;
+        };
+
         /// Initiates an asynchronous accept operation.
-        void startAccept();
+        void startAccept(Worker& worker);
 
         /// Handles completion of an asynchronous accept operation.
-        void handleAccept(const boost::system::error_code& e);
+        void handleAccept(Worker& worker, const boost::system::error_code& e);
 
         /// Handles a request to stop the server.
         void handleStop();
@@ -49,17 +71,14 @@ namespace ssoa
         /// The number of threads that will call io_service::run().
         std::size_t threadPoolSize;
 
-        /// The io_service used to perform asynchronous operations.
-        boost::asio::io_service ioService;
+        /// How the threads share the connections.
+        ListenerMode mode;
 
-        /// The signal_set is used to register for process termination notifications.
-        boost::asio::signal_set signals;
-
-        /// Acceptor used to listen for incoming connections.
-        boost::asio::ip::tcp::acceptor acceptor;
+        /// A single worker run by all threads, or one worker per thread.
+        std::vector<std::unique_ptr<Worker>> workers;
 
-        /// The next connection to be accepted.
-        std::shared_ptr<ClientHandler> clientHandler;
+        /// The signal_set is used to register for process termination notifications.
+        std::unique_ptr<boost::asio::signal_set> signals;
 
         /// An instance of the actual registry implementation.
         IRegistry& registry;
@@ -0,0 +1,143 @@
+/*
+ * computepool.h
+ */
+
+#ifndef _COMPUTEPOOL_H_
+#define _COMPUTEPOOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace ssoa
+{
+    /// A work-stealing pool of threads executing CPU-bound tasks, such as service invocations,
+    /// away from the threads performing network I/O.
+    ///
+    /// Tasks submitted from outside the pool, such as the requests received by the network
+    /// threads, are queued in FIFO order. Every thread also has its own deque: tasks submitted
+    /// by a pool thread go to the back of its deque and are taken back in LIFO order, while
+    /// idle threads steal them from the front. Services may split their work with run(), on
+    /// the pool returned by current().
+    class ComputePool: private boost::noncopyable
+    {
+    public:
+        /// Counters describing the activity of the pool.
+        struct Statistics
+        {
+            /// The number of tasks submitted to the threads.
+            std::size_t submitted;
+
+            /// The number of tasks taken from the deque of another thread.
+            std::size_t steals;
+
+            /// The number of tasks waiting to be executed.
+            std::size_t queued;
+
+            /// The number of tasks rejected by trySubmit().
+            std::size_t rejected;
+        };
+
+        /// Starts the threads of the pool.
+        ///
+        /// @param threads The number of threads. If 0, tasks are executed by the thread which
+        ///        submits them.
+        explicit ComputePool(std::size_t threads);
+
+        /// Stops the pool (see stop()).
+        ~ComputePool();
+
+        /// Schedules a task. Exceptions thrown by tasks are logged and ignored.
+        void submit(std::function<void()> task);
+
+        /// Schedules a task like submit(), unless it is submitted from outside the pool and
+        /// the tasks submitted from outside which wait to be executed are already as many as
+        /// the limit set by setMaxQueued().
+        ///
+        /// @return false if the task has been rejected.
+        bool trySubmit(std::function<void()> task);
+
+        /// Limits the tasks waiting in trySubmit(); 0 means no limit (the default).
+        void setMaxQueued(std::size_t maxQueued);
+
+        /// Calls @c task for each index in [0, count), possibly in parallel on the pool, and
+        /// returns when all of them have been processed. The calling thread processes indices
+        /// too, so that the call completes even when all the threads are busy.
+        ///
+        /// @throws std::runtime_error The message of the first exception thrown by @c task.
+        void run(int count, const std::function<void(int)>& task);
+
+        /// Executes the tasks already submitted, then stops the threads and waits for them.
+        /// Tasks submitted afterwards are executed by the submitting thread.
+        void stop();
+
+        /// Gets the number of threads of the pool.
+        std::size_t size() const {
+            return threadCount;
+        }
+
+        /// Gets the counters of the pool.
+        Statistics getStatistics() const;
+
+        /// Gets the pool owning the calling thread, or NULL if it is not a pool thread.
+        static ComputePool *current();
+
+    private:
+        /// A deque of tasks.
+        struct Queue
+        {
+            boost::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        /// The body of the thread owning queues[index].
+        void work(std::size_t index);
+
+        /// Takes a task from the back of queues[index], else from the tasks submitted from
+        /// outside the pool, else from the front of the deque of another thread.
+        bool take(std::size_t index, std::function<void()>& task);
+
+        /// Schedules a task, unless it would exceed the given limit of tasks from outside the
+        /// pool (0 for none).
+        bool enqueue(std::function<void()>& task, std::size_t limit);
+
+        /// Executes a task, logging its exceptions.
+        static void execute(const std::function<void()>& task);
+
+        std::size_t threadCount;
+        boost::thread_group threads;
+        std::vector<std::unique_ptr<Queue>> queues;
+
+        /// The tasks submitted from outside the pool.
+        Queue injected;
+
+        /// The number of tasks in all the deques.
+        std::atomic<std::size_t> pending;
+
+        /// The number of submit() calls in progress, which stop() waits for.
+        std::atomic<std::size_t> submitting;
+
+        /// The limit of trySubmit().
+        std::atomic<std::size_t> maxQueued;
+
+        std::atomic<std::size_t> submitted;
+        std::atomic<std::size_t> steals;
+        std::atomic<std::size_t> rejected;
+        std::atomic<bool> stopping;
+
+        /// Idle threads sleep on this condition until tasks are available.
+        boost::mutex mutex;
+        boost::condition_variable available;
+        std::atomic<std::size_t> sleeping;
+    };
+}
+
+#endif
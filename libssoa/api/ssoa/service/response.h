@@ -7,8 +7,8 @@
 
 #include <ssoa/service/servicesignature.h>
 #include <ssoa/service/serviceargument.h>
+#include <ssoa/service/serviceargumentlist.h>
 
-#include <deque>
 #include <stdexcept>
 #include <string>
 #include <sstream>
@@ -30,7 +30,7 @@ namespace ssoa
         ///
         /// @param signature The signature of the requested service.
         Response(ServiceSignature signature) :
-            signature(std::move(signature)), successful(true), status("OK"), pushed(0)
+            signature(std::move(signature)), successful(true), status("OK"), pushed(0), serviceId(-1), epoch(0)
         {
         }
 
@@ -40,7 +40,8 @@ namespace ssoa
         /// @param successful A value indicating whether the operation is successful.
         /// @param status A string representing the status of the operation.
         Response(ServiceSignature signature, bool successful, std::string status) :
-            signature(std::move(signature)), successful(successful), status(std::move(status)), pushed(0)
+            signature(std::move(signature)), successful(successful), status(std::move(status)), pushed(0),
+            serviceId(-1), epoch(0)
         {
         }
 
@@ -59,6 +60,27 @@ namespace ssoa
             return status;
         }
 
+        /// Gets the identifier which the provider has assigned to the service, which the
+        /// client may send instead of the signature in the next requests; -1 if not sent.
+        long getServiceId() const {
+            return serviceId;
+        }
+
+        /// Gets the epoch of the provider, which changes each time it is started, so that
+        /// identifiers of services obtained from a previous run are not used; 0 if not sent.
+        unsigned long getEpoch() const {
+            return epoch;
+        }
+
+        /// Sets the identifier of the service and the epoch of the provider.
+        ///
+        /// @param serviceId The identifier of the service, or -1 not to send it.
+        /// @param epoch The epoch of the provider.
+        void setServiceId(long serviceId, unsigned long epoch) {
+            this->serviceId = serviceId;
+            this->epoch = epoch;
+        }
+
         /// Adds an argument to the list of output arguments.
         ///
         /// @tparam ServArg The actual type of the argument (derived of ServiceArgument).
@@ -83,6 +105,27 @@ namespace ssoa
             pushed++;
         }
 
+        /// Adds an argument to the list of output arguments, without checking its type: for
+        /// typed signatures, whose argument types are checked at compile time.
+        ///
+        /// @throws std::logic_error If all arguments have already been pushed.
+        void pushArgumentUnchecked(ServiceArgument *arg)
+        {
+            if (pushed == signature.getOutputParams().size()) {
+                delete arg;
+                throw std::logic_error("All arguments already pushed.");
+            }
+            arguments.emplace_back(arg);
+            pushed++;
+        }
+
+        /// Gets an output argument, without removing it from the list nor checking it: for
+        /// typed signatures, whose argument types are checked at compile time.
+        ServiceArgument& getArgument(size_t index)
+        {
+            return *arguments[index];
+        }
+
         /// Gets an argument from the list of output arguments and removes it from the list.
         ///
         /// @tparam ServArg The actual type of the argument (derived of ServiceArgument).
@@ -139,6 +182,14 @@ namespace ssoa
             ServiceSignature signature = node["service"].to<std::string>();
             bool successful = node["successful"].to<bool>();
             std::string status = node["status"].to<std::string>();
+            long serviceId = -1;
+            unsigned long epoch = 0;
+            if (const YAML::Node *epochNode = node.FindValue("epoch")) {
+                epoch = epochNode->to<unsigned long>();
+                if (const YAML::Node *idNode = node.FindValue("id")) {
+                    serviceId = idNode->to<long>();
+                }
+            }
 
             std::vector<unsigned int> blocks;
             const YAML::Node & blocksNode = node["blocks"];
@@ -149,7 +200,9 @@ namespace ssoa
             }
 
             if (successful == false) {
-                return new Response(signature, false, status);
+                Response *response = new Response(signature, false, status);
+                response->setServiceId(serviceId, epoch);
+                return response;
             }
 
             const auto& params = signature.getOutputParams();
@@ -165,6 +218,7 @@ namespace ssoa
             headerBuffer.consume(bytes_transferred);
 
             Response *response = new Response(signature, successful, status);
+            response->setServiceId(serviceId, epoch);
 
             std::vector<boost::asio::mutable_buffer> payloadBuffers;
             for (unsigned i = 0; i < params.size(); i++) {
@@ -172,7 +226,7 @@ namespace ssoa
                 response->arguments.emplace_back(arg);
                 response->pushed++;
                 auto bufdata = arg->getData();
-                int fetched_size = headerBuffer.size();
+                std::size_t fetched_size = headerBuffer.size();
                 if (fetched_size > 0) {
                     boost::asio::buffer_copy(bufdata, headerBuffer.data());
                     payloadBuffers.push_back(bufdata + fetched_size);
@@ -202,8 +256,8 @@ namespace ssoa
         }
 
     protected:
-        /// Just a shortcut.
-        typedef std::deque<std::unique_ptr<ServiceArgument>> arg_deque;
+        /// Just a shortcut (named after the std::deque that used to hold the arguments).
+        typedef ServiceArgumentList arg_deque;
 
         /// Builds a ConstBufferSequence which can be used to serialize this Response.
         ///
@@ -216,7 +270,9 @@ namespace ssoa
         bool successful;
         std::string status;
         arg_deque arguments;
-        int pushed;
+        std::size_t pushed;
+        long serviceId;
+        unsigned long epoch;
         mutable std::string header;    // Temporarily keeps the header
     };
 }
@@ -6,9 +6,9 @@
 #define _SERVICE_H_
 
 #include <ssoa/service/serviceargument.h>
+#include <ssoa/service/serviceargumentlist.h>
 #include <ssoa/service/servicesignature.h>
 
-#include <deque>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -98,14 +98,54 @@ namespace ssoa
         /// Just a shortcut for derived classes.
         typedef unsigned char byte;
 
-        /// Just a shortcut.
-        typedef std::deque<std::unique_ptr<ServiceArgument>> arg_deque;
+        /// Adds an argument to the list of input arguments, without checking its type: for
+        /// typed signatures, whose argument types are checked at compile time.
+        ///
+        /// @throws std::logic_error If all arguments have already been pushed.
+        void pushArgumentUnchecked(ServiceArgument *arg)
+        {
+            if (pushed == signature.getInputParams().size()) {
+                delete arg;
+                throw std::logic_error("All arguments already pushed.");
+            }
+            arguments.emplace_back(arg);
+            pushed++;
+        }
+
+        /// Gets an input argument, without removing it from the list nor checking it: for
+        /// typed signatures, whose argument types are checked at compile time.
+        ServiceArgument& getArgument(size_t index)
+        {
+            return *arguments[index];
+        }
+
+        /// Just a shortcut (named after the std::deque that used to hold the arguments).
+        typedef ServiceArgumentList arg_deque;
 
         /// Builds a ConstBufferSequence which can be used to serialize this Service.
         ///
         /// The Service keeps ownership of memory referred to by all buffers, which can
         /// can be invalidated by any non-const method invoked on this instance.
-        std::vector<boost::asio::const_buffer> getConstBuffers() const;
+        ///
+        /// @param timeout The time left to the provider to answer, in milliseconds; 0 for none.
+        std::vector<boost::asio::const_buffer> getConstBuffers(long timeout = 0) const {
+            return getConstBuffers(headerTemplate(signature), timeout);
+        }
+
+        /// Builds a ConstBufferSequence which can be used to serialize this Service.
+        ///
+        /// @param headerTemplate The fields identifying the service, as built by one of the
+        ///        headerTemplate() methods, which the rest of the header is appended to.
+        /// @param timeout The time left to the provider to answer, in milliseconds; 0 for none.
+        std::vector<boost::asio::const_buffer> getConstBuffers(const std::string& headerTemplate,
+                                                               long timeout) const;
+
+        /// Builds the fields of the request header which identify the service by its signature.
+        static std::string headerTemplate(const ServiceSignature& signature);
+
+        /// Builds the fields of the request header which identify the service by the identifier
+        /// assigned by the provider (see Response::getServiceId()).
+        static std::string headerTemplate(long serviceId, unsigned long epoch);
 
         Service(ServiceSignature signature, arg_deque arguments) :
             signature(std::move(signature)), arguments(std::move(arguments)), pushed(0)
@@ -116,7 +156,7 @@ namespace ssoa
     private:
         ServiceSignature signature;
         arg_deque arguments;
-        int pushed;
+        std::size_t pushed;
         mutable std::string header; // Temporarily keeps the header
     };
 }
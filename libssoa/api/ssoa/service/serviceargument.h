@@ -7,6 +7,7 @@
 
 #include <ssoa/factorybase.h>
 
+#include <cstddef>
 #include <map>
 #include <string>
 
@@ -30,6 +31,14 @@ namespace ssoa
         virtual ~ServiceArgument() {
         }
 
+        /// Allocates an argument. Arguments are created for each request and are small (the
+        /// contents of buffers and long strings are stored apart), so they are taken from a
+        /// per-thread pool of fixed-size blocks instead of the heap.
+        static void* operator new(std::size_t size);
+
+        /// Returns the memory of an argument to the pool of the calling thread.
+        static void operator delete(void* p, std::size_t size);
+
     public:
         /// Constructs a new argument of the given type allocating a buffer of the size specified.
         ///
@@ -0,0 +1,170 @@
+/*
+ * serviceargumentlist.h
+ */
+
+#ifndef _SERVICEARGUMENTLIST_H_
+#define _SERVICEARGUMENTLIST_H_
+
+#include <ssoa/service/serviceargument.h>
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace ssoa
+{
+    /// The arguments of a service request or response, owned by the list.
+    ///
+    /// Most services have a few arguments, so the first ones are kept inside the list itself
+    /// and no memory is allocated for them; only longer lists are moved to the heap. The
+    /// interface is the subset of std::deque used by Service and Response.
+    class ServiceArgumentList
+    {
+    public:
+        typedef std::unique_ptr<ServiceArgument> value_type;
+        typedef value_type* iterator;
+        typedef const value_type* const_iterator;
+
+        /// The number of arguments kept inside the list.
+        enum { inlineCapacity = 4 };
+
+        ServiceArgumentList() :
+            data(local), capacity(inlineCapacity), first(0), last(0)
+        {
+        }
+
+        ServiceArgumentList(ServiceArgumentList&& other) :
+            ServiceArgumentList()
+        {
+            *this = std::move(other);
+        }
+
+        ServiceArgumentList& operator=(ServiceArgumentList&& other) {
+            if (this == &other) {
+                return *this;
+            }
+            clear();
+            heap.reset();
+            data = local;
+            capacity = inlineCapacity;
+            if (other.data == other.local) {
+                for (std::size_t i = other.first; i < other.last; i++) {
+                    local[last++] = std::move(other.local[i]);
+                }
+            }
+            else {
+                heap = std::move(other.heap);
+                data = heap.get();
+                capacity = other.capacity;
+                first = other.first;
+                last = other.last;
+                other.data = other.local;
+                other.capacity = inlineCapacity;
+            }
+            other.first = other.last = 0;
+            return *this;
+        }
+
+        ServiceArgumentList(const ServiceArgumentList&) = delete;
+        ServiceArgumentList& operator=(const ServiceArgumentList&) = delete;
+
+        std::size_t size() const {
+            return last - first;
+        }
+
+        bool empty() const {
+            return first == last;
+        }
+
+        value_type& operator[](std::size_t index) {
+            return data[first + index];
+        }
+
+        const value_type& operator[](std::size_t index) const {
+            return data[first + index];
+        }
+
+        value_type& front() {
+            return data[first];
+        }
+
+        value_type& back() {
+            return data[last - 1];
+        }
+
+        iterator begin() {
+            return data + first;
+        }
+
+        iterator end() {
+            return data + last;
+        }
+
+        const_iterator begin() const {
+            return data + first;
+        }
+
+        const_iterator end() const {
+            return data + last;
+        }
+
+        /// Appends an argument, e.g. from a pointer whose ownership is transferred to the list.
+        template<typename... Args>
+        void emplace_back(Args&&... args) {
+            // Take ownership first, so that the argument is deleted if growing fails.
+            value_type arg(std::forward<Args>(args)...);
+            if (last == capacity) {
+                grow();
+            }
+            data[last++] = std::move(arg);
+        }
+
+        /// Deletes the first argument.
+        void pop_front() {
+            data[first++].reset();
+            if (first == last) {
+                first = last = 0;
+            }
+        }
+
+        /// Deletes all arguments, keeping the memory allocated.
+        void clear() {
+            for (std::size_t i = first; i < last; i++) {
+                data[i].reset();
+            }
+            first = last = 0;
+        }
+
+    private:
+        /// Makes room for one more argument at the end.
+        void grow() {
+            std::size_t n = size();
+            if (first > 0) {
+                // Reuse the room left by popped arguments.
+                for (std::size_t i = 0; i < n; i++) {
+                    data[i] = std::move(data[first + i]);
+                }
+            }
+            else {
+                std::unique_ptr<value_type[]> storage(new value_type[2 * capacity]);
+                for (std::size_t i = 0; i < n; i++) {
+                    storage[i] = std::move(data[i]);
+                }
+                heap = std::move(storage);
+                data = heap.get();
+                capacity *= 2;
+            }
+            first = 0;
+            last = n;
+        }
+
+        value_type local[inlineCapacity];
+        std::unique_ptr<value_type[]> heap;
+        value_type *data;
+        std::size_t capacity;
+        std::size_t first;
+        std::size_t last;
+    };
+}
+
+#endif
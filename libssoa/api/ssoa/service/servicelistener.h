@@ -5,58 +5,186 @@
 #ifndef _SERVICELISTENER_H_
 #define _SERVICELISTENER_H_
 
+#include <ssoa/listenermode.h>
+#include <ssoa/service/computepool.h>
 #include <ssoa/service/service.h>
 
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
+#include <boost/asio/deadline_timer.hpp>
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/signal_set.hpp>
 #include <boost/noncopyable.hpp>
 
+#include <sys/types.h>
+
 namespace ssoa
 {
+    // Forward declaration.
+    class ConnectionTracker;
+
     /// Represents a server listening for service requests.
+    ///
+    /// On SIGINT, SIGTERM or SIGQUIT, the server drains: it calls the drain handler (which
+    /// usually deregisters the services), stops accepting connections, and stops once the
+    /// requests in progress are completed, or the drain timeout expires. A second signal
+    /// stops it immediately. With hot restart enabled, SIGHUP first executes a new instance of
+    /// the program, which takes over the listening sockets, so that no connection is refused.
+    /// The server drains once the new instance is listening; if it fails to start, the server
+    /// goes on serving.
+    ///
+    /// When the connections or payload bytes in progress reach their limits, the server stops
+    /// accepting connections, which wait in the backlog of the socket, until they fall to three
+    /// quarters of the limits.
     class ServiceListener: private boost::noncopyable
     {
     public:
+        /// Called when the server starts draining.
+        ///
+        /// @param handover Whether a new process keeps serving on the same endpoint.
+        typedef std::function<void(bool handover)> DrainHandler;
+
         /// Initializes an instance of the server and starts listening for incoming connections.
         ///
         /// @param host A string identifying a host. May be a descriptive name or a numeric
         ///        address string. If empty, the loopback address will be used.
         /// @param port A string containing the port number.
         /// @param thread_pool_size The number of threads allocated in the pool.
+        /// @param mode How the threads share the connections.
+        /// @param compute_pool_size The number of threads invoking the services. If 0, services are
+        ///        invoked by the I/O threads.
         ///
         /// @throws boost::system::system_error Thrown on failure.
-        explicit ServiceListener(const std::string& host, const std::string& port, std::size_t thread_pool_size);
+        explicit ServiceListener(const std::string& host, const std::string& port, std::size_t thread_pool_size,
+            ListenerMode mode = SHARED_IO_SERVICE, std::size_t compute_pool_size = 0);
 
-        /// Runs the server's io_service loop.
+        /// Destructor.
+        ~ServiceListener();
+
+        /// Runs the server's io_service loops.
         void run();
 
+        /// Limits the requests in progress.
+        ///
+        /// @param maxConnections The maximum number of connections; 0 means no limit.
+        /// @param maxPayloadBytes The maximum size of the payloads received; requests whose payload
+        ///        does not fit fail before receiving it. 0 means no limit.
+        /// @param maxQueued The maximum number of requests waiting for a compute thread, above
+        ///        which new ones fail right away with the status "Busy"; 0 means no limit.
+        void setLimits(std::size_t maxConnections, std::size_t maxPayloadBytes, std::size_t maxQueued = 0);
+
+        /// Sets the function called when the server starts draining.
+        void setDrainHandler(DrainHandler handler);
+
+        /// Sets how long the requests in progress may take to complete once the server drains
+        /// (30 seconds by default).
+        void setDrainTimeout(long milliseconds);
+
+        /// Enables hot restart on SIGHUP. Must be called before the current directory changes:
+        /// the program is found from argv[0], so that a new build deployed at the same path
+        /// is executed.
+        ///
+        /// @param argv The command line used to execute the new process, terminated by NULL.
+        void enableHotRestart(char *argv[]);
+
     private:
+        /// An io_service with its own acceptor.
+        struct Worker
+        {
+            Worker() :
+                work(ioService), acceptor(ioService), paused(false)
+            {
+            }
+
+            /// The io_service used to perform asynchronous operations.
+            boost::asio::io_service ioService;
+
+            /// Keeps the io_service running while draining, until it is stopped explicitly:
+            /// services running on the compute pool post their responses to it.
+            boost::asio::io_service::work work;
+
+            /// Acceptor used to listen for incoming connections.
+            boost::asio::ip::tcp::acceptor acceptor;
+
+            /// The next client socket.
+            std::unique_ptr<boost::asio::ip::tcp::socket> clientSocket;
+
+            /// Whether accepting is paused, because of the limits.
+            std::atomic<bool> paused;
+        };
+
         /// Initiates an asynchronous accept operation.
-        void startAccept();
+        void startAccept(Worker& worker);
 
         /// Handles completion of an asynchronous accept operation.
-        void handleAccept(const boost::system::error_code& e);
+        void handleAccept(Worker& worker, const boost::system::error_code& e);
+
+        /// Resumes accepting on the paused workers.
+        void resume();
+
+        /// Handles a request to stop or restart the server.
+        void handleStop(const boost::system::error_code& e, int signalNumber);
 
-        /// Handles a request to stop the server.
-        void handleStop();
+        /// Drains the server once the new process started on hot restart is ready, or goes on
+        /// serving if it fails to start.
+        void checkSuccessor(const boost::system::error_code& e);
+
+        /// Starts draining the server.
+        void drain(bool handover);
+
+        /// Stops the server once drained, or when the drain timeout expires.
+        void checkDrained(const boost::system::error_code& e);
+
+        /// Stops all io_services, abandoning the requests in progress.
+        void stop();
 
         /// The number of threads that will call io_service::run().
         std::size_t threadPoolSize;
 
-        /// The io_service used to perform asynchronous operations.
-        boost::asio::io_service ioService;
+        /// How the threads share the connections.
+        ListenerMode mode;
+
+        /// A single worker run by all threads, or one worker per thread.
+        std::vector<std::unique_ptr<Worker>> workers;
 
         /// The signal_set is used to register for process termination notifications.
-        boost::asio::signal_set signals;
+        std::unique_ptr<boost::asio::signal_set> signals;
+
+        /// The threads invoking the services, keeping the I/O threads free for network work.
+        /// Services may split their work on it, through ComputePool::current().
+        std::unique_ptr<ComputePool> computePool;
+
+        /// Counts the requests in progress; shared with the requests, which may outlive the
+        /// server when it is stopped.
+        std::shared_ptr<ConnectionTracker> tracker;
+
+        /// Whether the server is draining.
+        std::atomic<bool> draining;
+
+        DrainHandler drainHandler;
+        long drainTimeout;
+        boost::posix_time::ptime drainDeadline;
+        std::unique_ptr<boost::asio::deadline_timer> drainTimer;
+
+        /// The command line executing a new instance on hot restart; empty if disabled.
+        std::vector<std::string> restartArguments;
+
+        /// The absolute path of the program executed on hot restart.
+        std::string restartProgram;
+
+        /// The process started on hot restart, or -1.
+        pid_t successor;
 
-        /// Acceptor used to listen for incoming connections.
-        boost::asio::ip::tcp::acceptor acceptor;
+        /// The pipe through which the successor tells that it is ready, while it starts.
+        int successorReadyFd;
 
-        /// The next client socket.
-        std::unique_ptr<boost::asio::ip::tcp::socket> clientSocket;
+        boost::posix_time::ptime successorDeadline;
+        std::unique_ptr<boost::asio::deadline_timer> successorTimer;
     };
 }
 
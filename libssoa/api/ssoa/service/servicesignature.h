@@ -5,24 +5,34 @@
 #ifndef _SERVICESIGNATURE_H_
 #define _SERVICESIGNATURE_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace ssoa
 {
+    /// The signature of a service, e.g. "RotateImage(in int, in buffer, out buffer)".
+    ///
+    /// Parsed signatures are immutable and shared: they are kept in a cache keyed by the string
+    /// they are constructed from, so that copying or constructing again a signature does not
+    /// parse it again.
     class ServiceSignature
     {
-    private:
-        static std::string sigPattern;
-        static std::string argPattern;
-
     public:
+        /// The implementations of the parser.
+        enum Parser
+        {
+            /// A hand-written parser, which does not need Boost.Regex.
+            HANDWRITTEN_PARSER,
+
+            /// A parser based on regular expressions; not available if the library is built
+            /// with SSOA_NO_REGEX defined.
+            REGEX_PARSER
+        };
+
         static ServiceSignature any;
 
-        ServiceSignature() :
-            name("*"), signature("*"), is_valid(false)
-        {
-        }
+        ServiceSignature();
 
         ServiceSignature(const char *signature) :
             ServiceSignature(std::string(signature))
@@ -31,32 +41,53 @@ namespace ssoa
 
         ServiceSignature(const std::string & signature);
 
+        /// Parses a signature, without looking it up in the cache nor adding it.
+        static ServiceSignature parse(const std::string & signature);
+
+        /// Selects the parser used from now on (REGEX_PARSER by default, if available).
+        ///
+        /// @throws std::logic_error If the parser is not available.
+        static void setParser(Parser parser);
+
+        /// Gets the parser in use.
+        static Parser getParser();
+
         const std::string & getName() const {
-            return name;
+            return data->name;
         }
 
         const std::vector<std::string> & getInputParams() const {
-            return inputParams;
+            return data->inputParams;
         }
 
         const std::vector<std::string> & getOutputParams() const {
-            return outputParams;
+            return data->outputParams;
         }
 
         bool isValid() const {
-            return is_valid;
+            return data->is_valid;
         }
 
         operator std::string() const {
-            return signature;
+            return data->signature;
         }
 
     private:
-        std::string name;
-        std::string signature;
-        std::vector<std::string> inputParams;
-        std::vector<std::string> outputParams;
-        bool is_valid;
+        struct Data
+        {
+            std::string name;
+            std::string signature;
+            std::vector<std::string> inputParams;
+            std::vector<std::string> outputParams;
+            bool is_valid;
+        };
+
+        explicit ServiceSignature(std::shared_ptr<const Data> data) :
+            data(std::move(data))
+        {
+        }
+
+        std::shared_ptr<const Data> data;
 
         friend bool operator==(const ServiceSignature& a, const ServiceSignature& b);
         friend bool operator!=(const ServiceSignature& a, const ServiceSignature& b);
@@ -64,15 +95,15 @@ namespace ssoa
     };
 
     inline bool operator==(const ServiceSignature& a, const ServiceSignature& b) {
-        return a.signature == b.signature;
+        return a.data == b.data || a.data->signature == b.data->signature;
     }
 
     inline bool operator!=(const ServiceSignature& a, const ServiceSignature& b) {
-        return a.signature != b.signature;
+        return !(a == b);
     }
 
     inline bool operator<(const ServiceSignature& a, const ServiceSignature& b) {
-        return a.signature < b.signature;
+        return a.data->signature < b.data->signature;
     }
 }
 
@@ -10,16 +10,58 @@
 #include <ssoa/factorybase.h>
 #include <ssoa/logger.h>
 
+#include <cstddef>
+#include <memory>
+
+#include <boost/asio/io_service.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 
 namespace ssoa
 {
+    // Forward declaration.
+    class ComputePool;
+
+    /// Observes the requests processed by ServiceSkeleton::start(). Methods may be called
+    /// from any thread.
+    class RequestTracker
+    {
+    public:
+        /// Called when the header of a request has been parsed, before its payload is received.
+        ///
+        /// @param bytes The size of the payload.
+        /// @return false if the payload does not fit in the bytes still available, in which
+        ///         case the request fails without receiving it.
+        virtual bool onPayload(std::size_t bytes) = 0;
+
+        /// Called once the request is completed or abandoned.
+        ///
+        /// @param bytes The size of the payload, as accepted by onPayload(); 0 otherwise.
+        virtual void onFinished(std::size_t bytes) = 0;
+
+        /// Virtual destructor.
+        virtual ~RequestTracker() {
+        }
+    };
+
     /// Represents a service from the server perspective.
     class ServiceSkeleton: public Service
     {
     public:
         /// Accepts a service request from a socket and processes it.
-        static void start(std::unique_ptr<boost::asio::ip::tcp::socket> socket);
+        ///
+        /// @param socket The connected socket.
+        /// @param ioService The io_service of the socket, where all network I/O happens.
+        /// @param computePool The pool where the service is invoked; the response is sent back
+        ///        from the io_service. If NULL, the service is invoked on the io_service.
+        /// @param tracker Notified of the progress of the request; may be NULL.
+        static void start(std::unique_ptr<boost::asio::ip::tcp::socket> socket,
+                          boost::asio::io_service& ioService, ComputePool *computePool,
+                          std::shared_ptr<RequestTracker> tracker = std::shared_ptr<RequestTracker>());
+
+        /// Sets how long a client may take to send a request, and to receive the response
+        /// (30 seconds by default). Connections exceeding it are closed.
+        static void setIdleTimeout(long milliseconds);
 
         /// Executes the service.
         virtual Response * invoke() = 0;
@@ -45,8 +87,17 @@ namespace ssoa
             return f;
         }
 
+        /// Gets the time left before the deadline of the request, in milliseconds, so that it
+        /// can be passed on to the services invoked in turn (see ServiceStub::setTimeout()).
+        ///
+        /// @return The time left, at least 1; 0 if the request has no deadline.
+        long getTimeout() const;
+
     private:
         friend class ServiceSkeletonSerializationHelper;
+
+        /// The deadline of the request, or not_a_date_time.
+        boost::posix_time::ptime deadline;
     };
 }
 
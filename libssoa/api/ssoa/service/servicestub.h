@@ -22,7 +22,7 @@ namespace ssoa
         /// @param host The remote address of the service provider.
         /// @param port The remote port on which the service is provided.
         ServiceStub(ServiceSignature signature, std::string host, std::string port) :
-            Service(std::move(signature)), host(std::move(host)), port(std::move(port))
+            Service(std::move(signature)), host(std::move(host)), port(std::move(port)), timeout(defaultTimeout())
         {
         }
 
@@ -36,14 +36,39 @@ namespace ssoa
             return port;
         }
 
+        /// Gets the time given to the provider to answer, in milliseconds; 0 means no limit.
+        long getTimeout() const {
+            return timeout;
+        }
+
+        /// Sets the time given to the provider to answer, in milliseconds; 0 means no limit.
+        /// The provider drops the request if it cannot start processing it in time.
+        void setTimeout(long milliseconds) {
+            timeout = milliseconds;
+        }
+
+        /// Sets the timeout of the stubs constructed afterwards.
+        static void setDefaultTimeout(long milliseconds) {
+            defaultTimeout() = milliseconds;
+        }
+
         /// Submits a service request and waits for the corresponding response.
         ///
         /// @returns The Response received from the remote server.
+        ///
+        /// @throws boost::system::system_error With boost::asio::error::timed_out if the timeout
+        ///         expires, or on any network error.
         Response * submit() const;
 
     private:
+        static long& defaultTimeout() {
+            static long t = 0;
+            return t;
+        }
+
         std::string host;
         std::string port;
+        long timeout;
     };
 }
 
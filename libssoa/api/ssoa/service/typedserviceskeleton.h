@@ -0,0 +1,68 @@
+/*
+ * typedserviceskeleton.h
+ */
+
+#ifndef _TYPEDSERVICESKELETON_H_
+#define _TYPEDSERVICESKELETON_H_
+
+#include <ssoa/service/serviceskeleton.h>
+#include <ssoa/service/typedsignature.h>
+
+#include <string>
+#include <utility>
+
+namespace ssoa
+{
+    /// A ServiceSkeleton whose signature is known at compile time. The arguments received are
+    /// prepared from the same signature, so they are read and the results are pushed without
+    /// any run-time check.
+    ///
+    /// @tparam Sig The Signature of the service.
+    template<typename Sig>
+    class TypedServiceSkeleton: public ServiceSkeleton
+    {
+    public:
+        /// Gets the signature of this type of service.
+        static const char * serviceSignature() {
+            return Sig::str();
+        }
+
+    protected:
+        /// Constructs a new instance of TypedServiceSkeleton from the given arguments.
+        TypedServiceSkeleton(arg_deque arguments) :
+            ServiceSkeleton(Sig::get(), std::move(arguments))
+        {
+        }
+
+        /// Gets the I-th input argument.
+        template<std::size_t I>
+        typename Sig::template Input<I>::type& inputArgument() {
+            return static_cast<typename Sig::template Input<I>::type&>(getArgument(I));
+        }
+
+        /// Creates a successful response from the output values, in order.
+        template<typename... Values>
+        static Response * respond(Values&&... values) {
+            static_assert(sizeof...(Values) == Sig::Outputs::size, "Wrong number of output arguments.");
+            Response * response = new Response(Sig::get(), true, "OK");
+            push(*response, typename typedsignature::MakeIndices<sizeof...(Values)>::type(),
+                 std::forward<Values>(values)...);
+            return response;
+        }
+
+        /// Creates a failed response.
+        static Response * fail(std::string status) {
+            return new Response(Sig::get(), false, std::move(status));
+        }
+
+    private:
+        template<std::size_t... I, typename... Values>
+        static void push(Response& response, typedsignature::Indices<I...>, Values&&... values) {
+            int expand[] = { 0, (response.pushArgumentUnchecked(new typename Sig::template Output<I>::type(
+                static_cast<typename Sig::template Output<I>::value_type>(std::forward<Values>(values)))), 0)... };
+            (void)expand;
+        }
+    };
+}
+
+#endif
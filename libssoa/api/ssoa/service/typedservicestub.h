@@ -0,0 +1,77 @@
+/*
+ * typedservicestub.h
+ */
+
+#ifndef _TYPEDSERVICESTUB_H_
+#define _TYPEDSERVICESTUB_H_
+
+#include <ssoa/service/servicestub.h>
+#include <ssoa/service/typedsignature.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace ssoa
+{
+    /// A ServiceStub whose signature is known at compile time: the types of the arguments are
+    /// checked by the compiler, so that they are marshalled without any run-time check.
+    ///
+    /// @tparam Sig The Signature of the remote service.
+    template<typename Sig>
+    class TypedServiceStub: public ServiceStub
+    {
+    public:
+        /// Constructs a new instance of TypedServiceStub.
+        ///
+        /// @param host The remote address of the service provider.
+        /// @param port The remote port on which the service is provided.
+        TypedServiceStub(std::string host, std::string port) :
+            ServiceStub(Sig::get(), std::move(host), std::move(port))
+        {
+        }
+
+        /// Gets the signature of this type of service.
+        static const char * serviceSignature() {
+            return Sig::str();
+        }
+
+    protected:
+        /// Pushes the input arguments, in order, and submits the request.
+        ///
+        /// @returns The Response received from the remote server; if successful, its output
+        ///          arguments can be read with outputArgument().
+        ///
+        /// @throws std::runtime_error If the provider answers successfully for a different service.
+        template<typename... Values>
+        std::unique_ptr<Response> call(Values&&... values) {
+            static_assert(sizeof...(Values) == Sig::Inputs::size, "Wrong number of input arguments.");
+            push(typename typedsignature::MakeIndices<sizeof...(Values)>::type(), std::forward<Values>(values)...);
+
+            std::unique_ptr<Response> response(ServiceStub::submit());
+            // Failures detected before parsing the request carry no signature.
+            if (response->isSuccessful() && response->getSignature() != Sig::get()) {
+                throw std::runtime_error("Response to a different service: "
+                                         + static_cast<std::string>(response->getSignature()));
+            }
+            return response;
+        }
+
+        /// Gets the I-th output argument of a successful response returned by call().
+        template<std::size_t I>
+        static typename Sig::template Output<I>::type& outputArgument(Response& response) {
+            return static_cast<typename Sig::template Output<I>::type&>(response.getArgument(I));
+        }
+
+    private:
+        template<std::size_t... I, typename... Values>
+        void push(typedsignature::Indices<I...>, Values&&... values) {
+            int expand[] = { 0, (pushArgumentUnchecked(new typename Sig::template Input<I>::type(
+                static_cast<typename Sig::template Input<I>::value_type>(std::forward<Values>(values)))), 0)... };
+            (void)expand;
+        }
+    };
+}
+
+#endif
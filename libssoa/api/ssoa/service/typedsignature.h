@@ -0,0 +1,170 @@
+/*
+ * typedsignature.h
+ */
+
+#ifndef _TYPEDSIGNATURE_H_
+#define _TYPEDSIGNATURE_H_
+
+#include <ssoa/service/serviceargument.h>
+#include <ssoa/service/servicesignature.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace ssoa
+{
+    /// The type of "buffer" arguments in typed signatures.
+    struct Buffer;
+
+    /// An input parameter of a typed signature.
+    template<typename T> struct In;
+
+    /// An output parameter of a typed signature.
+    template<typename T> struct Out;
+
+    /// Maps the types of typed signatures to the classes of the arguments, and to the types
+    /// of their values.
+    template<typename T> struct ArgumentOf;
+
+    template<> struct ArgumentOf<int> {
+        typedef ServiceIntArgument type;
+        typedef int value_type;
+    };
+
+    template<> struct ArgumentOf<double> {
+        typedef ServiceDoubleArgument type;
+        typedef double value_type;
+    };
+
+    template<> struct ArgumentOf<std::string> {
+        typedef ServiceStringArgument type;
+        typedef std::string value_type;
+    };
+
+    template<> struct ArgumentOf<Buffer> {
+        typedef ServiceBufferArgument type;
+        typedef std::vector<unsigned char> value_type;
+    };
+
+    namespace typedsignature
+    {
+        template<typename... Ts> struct TypeList {
+            enum { size = sizeof...(Ts) };
+        };
+
+        template<typename List, typename T> struct Append;
+
+        template<typename... Ts, typename T> struct Append<TypeList<Ts...>, T> {
+            typedef TypeList<Ts..., T> type;
+        };
+
+        /// Splits the parameters into the lists of input and output types.
+        template<typename Inputs, typename Outputs, typename... Params> struct Split {
+            typedef Inputs inputs;
+            typedef Outputs outputs;
+        };
+
+        template<typename Inputs, typename Outputs, typename T, typename... Params>
+        struct Split<Inputs, Outputs, In<T>, Params...>:
+            Split<typename Append<Inputs, T>::type, Outputs, Params...> {
+        };
+
+        template<typename Inputs, typename Outputs, typename T, typename... Params>
+        struct Split<Inputs, Outputs, Out<T>, Params...>:
+            Split<Inputs, typename Append<Outputs, T>::type, Params...> {
+        };
+
+        template<std::size_t I, typename List> struct At;
+
+        template<typename T, typename... Ts> struct At<0, TypeList<T, Ts...>> {
+            typedef T type;
+        };
+
+        template<std::size_t I, typename T, typename... Ts> struct At<I, TypeList<T, Ts...>>:
+            At<I - 1, TypeList<Ts...>> {
+        };
+
+        template<std::size_t... I> struct Indices {
+        };
+
+        /// Generates Indices<0, 1, ..., N - 1>.
+        template<std::size_t N, std::size_t... I> struct MakeIndices: MakeIndices<N - 1, N - 1, I...> {
+        };
+
+        template<std::size_t... I> struct MakeIndices<0, I...> {
+            typedef Indices<I...> type;
+        };
+
+        /// Builds the string form of the parameters.
+        template<typename... Params> struct Describe {
+            static std::string str() {
+                return "";
+            }
+        };
+
+        template<typename T, typename... Params> struct Describe<In<T>, Params...> {
+            static std::string str() {
+                return std::string("in ") + ArgumentOf<T>::type::type()
+                    + (sizeof...(Params) > 0 ? ", " : "") + Describe<Params...>::str();
+            }
+        };
+
+        template<typename T, typename... Params> struct Describe<Out<T>, Params...> {
+            static std::string str() {
+                return std::string("out ") + ArgumentOf<T>::type::type()
+                    + (sizeof...(Params) > 0 ? ", " : "") + Describe<Params...>::str();
+            }
+        };
+    }
+
+    /// A service signature known at compile time, from which TypedServiceStub and
+    /// TypedServiceSkeleton generate the marshalling of the arguments. For example:
+    ///
+    /// @code
+    /// struct RotateImageName {
+    ///     static const char * name() { return "RotateImage"; }
+    /// };
+    /// typedef Signature<RotateImageName, In<int>, In<Buffer>, Out<Buffer>> RotateImageSignature;
+    /// @endcode
+    ///
+    /// @tparam Name A class whose static name() method returns the name of the service.
+    /// @tparam Params The parameters, each one either In<T> or Out<T>, where T is int, double,
+    ///         std::string or Buffer.
+    template<typename Name, typename... Params>
+    class Signature
+    {
+        typedef typedsignature::Split<typedsignature::TypeList<>, typedsignature::TypeList<>, Params...> Split;
+
+    public:
+        /// The types of the input parameters.
+        typedef typename Split::inputs Inputs;
+
+        /// The types of the output parameters.
+        typedef typename Split::outputs Outputs;
+
+        /// The argument class, and the type of the value, of the I-th input parameter.
+        template<std::size_t I> struct Input: ArgumentOf<typename typedsignature::At<I, Inputs>::type> {
+        };
+
+        /// The argument class, and the type of the value, of the I-th output parameter.
+        template<std::size_t I> struct Output: ArgumentOf<typename typedsignature::At<I, Outputs>::type> {
+        };
+
+        /// Gets the string form of the signature, as used by the registry, for example
+        /// "RotateImage(in int, in buffer, out buffer)".
+        static const char * str() {
+            static const std::string s =
+                std::string(Name::name()) + "(" + typedsignature::Describe<Params...>::str() + ")";
+            return s.c_str();
+        }
+
+        /// Gets the signature, parsed just once.
+        static const ServiceSignature& get() {
+            static const ServiceSignature signature(str());
+            return signature;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,267 @@
+/*
+ * listenerhelpers.h
+ */
+
+#ifndef _LISTENERHELPERS_H_
+#define _LISTENERHELPERS_H_
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/socket_base.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace ssoa
+{
+    namespace listenerhelpers
+    {
+#if defined(SO_REUSEPORT)
+        /// Socket option letting many sockets listen on the same address and port.
+        typedef boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> reuse_port;
+#endif
+
+        /// Opens an acceptor on the given endpoint and starts listening.
+        ///
+        /// @param reusePort Whether other sockets may listen on the same endpoint.
+        ///
+        /// @throws boost::system::system_error Thrown on failure.
+        /// @throws std::runtime_error SO_REUSEPORT is requested, but not supported.
+        inline void listen(boost::asio::ip::tcp::acceptor& acceptor, const boost::asio::ip::tcp::endpoint& endpoint,
+                           bool reusePort)
+        {
+            acceptor.open(endpoint.protocol());
+            acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+            if (reusePort) {
+#if defined(SO_REUSEPORT)
+                acceptor.set_option(reuse_port(true));
+#else
+                throw std::runtime_error("SO_REUSEPORT is not supported on this system.");
+#endif
+            }
+            acceptor.bind(endpoint);
+            acceptor.listen();
+        }
+
+        /// The environment variable listing the listening sockets inherited from the process
+        /// which executed the current one (see spawnSuccessor()).
+        const char * const listenFdsVariable = "SSOA_LISTEN_FDS";
+
+        /// Gets the listening sockets inherited from the previous process, and clears the
+        /// environment variable, so that they are not adopted again by other children.
+        inline std::vector<int> inheritedSockets()
+        {
+            std::vector<int> fds;
+            const char *value = std::getenv(listenFdsVariable);
+            if (value == NULL) {
+                return fds;
+            }
+            std::vector<std::string> items;
+            std::string list(value);
+            boost::algorithm::split(items, list, boost::algorithm::is_any_of(","));
+            for (const std::string& item : items) {
+                try {
+                    fds.push_back(boost::lexical_cast<int>(item));
+                }
+                catch (const boost::bad_lexical_cast&) {
+                    // Ignore garbage: the sockets are opened again
+                }
+            }
+            unsetenv(listenFdsVariable);
+            return fds;
+        }
+
+        /// The environment variable holding the pipe through which a process executed by
+        /// spawnSuccessor() tells that it is listening (see notifyReady()).
+        const char * const readyFdVariable = "SSOA_READY_FD";
+
+        /// Tells the process which executed the current one that its sockets are listening,
+        /// if any, and clears the environment variable.
+        inline void notifyReady()
+        {
+            const char *value = std::getenv(readyFdVariable);
+            if (value == NULL) {
+                return;
+            }
+            try {
+                int fd = boost::lexical_cast<int>(value);
+                char ready = 1;
+                if (write(fd, &ready, 1) != 1) {
+                    // The previous process goes on serving
+                }
+                close(fd);
+            }
+            catch (const boost::bad_lexical_cast&) {
+                // Ignore garbage
+            }
+            unsetenv(readyFdVariable);
+        }
+
+        /// Checks, without blocking, whether the process started by spawnSuccessor() is ready.
+        ///
+        /// @return 1 if it is, -1 if it has exited or closed the pipe without being ready,
+        ///         0 if it is still starting.
+        inline int successorState(int readyFd)
+        {
+            pollfd p;
+            p.fd = readyFd;
+            p.events = POLLIN;
+            p.revents = 0;
+            int n = poll(&p, 1, 0);
+            if (n == 0 || (n < 0 && errno == EINTR)) {
+                return 0;
+            }
+            char ready;
+            return n > 0 && read(readyFd, &ready, 1) == 1 ? 1 : -1;
+        }
+
+        /// Resolves the name a program has been executed with, as found in argv[0], to an
+        /// absolute path: relative to the current directory if it contains a slash, else
+        /// searched in PATH like the shell does. Resolved at startup, before the directory
+        /// changes, the path names the program as deployed, rather than the image running.
+        ///
+        /// @return The resolved path, or the name itself if it cannot be resolved.
+        inline std::string programPath(const std::string& name)
+        {
+            if (name.empty() || name[0] == '/') {
+                return name;
+            }
+            if (name.find('/') != std::string::npos) {
+                std::vector<char> cwd(4096);
+                if (getcwd(cwd.data(), cwd.size()) == NULL) {
+                    return name;
+                }
+                return std::string(cwd.data()) + "/" + name;
+            }
+            const char *path = std::getenv("PATH");
+            if (path == NULL) {
+                return name;
+            }
+            std::vector<std::string> folders;
+            std::string list(path);
+            boost::algorithm::split(folders, list, boost::algorithm::is_any_of(":"));
+            for (const std::string& folder : folders) {
+                // An empty entry stands for the current directory.
+                std::string candidate = (folder.empty() ? std::string(".") : folder) + "/" + name;
+                if (access(candidate.c_str(), X_OK) == 0) {
+                    return candidate[0] == '/' ? candidate : programPath(candidate);
+                }
+            }
+            return name;
+        }
+
+        /// Executes a new instance of the program, which inherits the given listening sockets
+        /// and starts accepting connections on them right away. Every other descriptor is
+        /// closed in the new process, so that it does not keep the current connections open.
+        ///
+        /// @param program The path of the program.
+        /// @param arguments The command line of the new process, starting with its name.
+        /// @param readyFd Set to the pipe whose state is checked by successorState(); the
+        ///        caller closes it.
+        /// @return The identifier of the new process, or -1 if it cannot be started.
+        inline pid_t spawnSuccessor(const std::string& program, const std::vector<std::string>& arguments,
+                                    const std::vector<int>& fds, int& readyFd)
+        {
+            int ready[2];
+            if (pipe(ready) != 0) {
+                return -1;
+            }
+            // Only the write end is inherited; the read end sees the end of file once the new
+            // process has exited, or failed to be executed.
+            fcntl(ready[0], F_SETFD, FD_CLOEXEC);
+
+            // Everything the child needs is prepared before fork(): only async-signal-safe
+            // calls are allowed in the child of a multi-threaded process.
+            std::string variable = listenFdsVariable + std::string("=");
+            for (size_t i = 0; i < fds.size(); i++) {
+                variable += (i > 0 ? "," : "") + boost::lexical_cast<std::string>(fds[i]);
+            }
+            std::string readyVariable = readyFdVariable + std::string("=") +
+                boost::lexical_cast<std::string>(ready[1]);
+            std::vector<char *> argv;
+            for (const std::string& argument : arguments) {
+                argv.push_back(const_cast<char *>(argument.c_str()));
+            }
+            argv.push_back(NULL);
+            std::vector<char *> envp;
+            size_t prefix = std::strlen(listenFdsVariable) + 1;
+            size_t readyPrefix = std::strlen(readyFdVariable) + 1;
+            for (char **e = environ; *e != NULL; e++) {
+                if (std::strncmp(*e, variable.c_str(), prefix) != 0
+                    && std::strncmp(*e, readyVariable.c_str(), readyPrefix) != 0) {
+                    envp.push_back(*e);
+                }
+            }
+            envp.push_back(const_cast<char *>(variable.c_str()));
+            envp.push_back(const_cast<char *>(readyVariable.c_str()));
+            envp.push_back(NULL);
+            long maxFd = sysconf(_SC_OPEN_MAX);
+            if (maxFd < 0) {
+                maxFd = 1024;
+            }
+
+            pid_t pid = fork();
+            if (pid == 0) {
+                for (int fd = 3; fd < maxFd; fd++) {
+                    bool keep = fd == ready[1];
+                    for (size_t i = 0; i < fds.size() && !keep; i++) {
+                        keep = fds[i] == fd;
+                    }
+                    if (keep) {
+                        fcntl(fd, F_SETFD, 0); // Clear FD_CLOEXEC
+                    }
+                    else {
+                        close(fd);
+                    }
+                }
+                execve(program.c_str(), argv.data(), envp.data());
+                _exit(127);
+            }
+            close(ready[1]);
+            if (pid < 0) {
+                close(ready[0]);
+                return -1;
+            }
+            readyFd = ready[0];
+            return pid;
+        }
+
+        /// Pins a thread to a core, chosen round-robin by index. Does nothing where thread
+        /// affinity is not supported, or if it fails: pinning is just an optimization.
+        inline void pinToCore(boost::thread& thread, unsigned index)
+        {
+#if defined(__linux__)
+            unsigned cores = boost::thread::hardware_concurrency();
+            if (cores == 0) {
+                return;
+            }
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(index % cores, &set);
+            pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+            (void)thread;
+            (void)index;
+#endif
+        }
+    }
+}
+
+#endif
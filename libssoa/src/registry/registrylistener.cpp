@@ -6,6 +6,10 @@
 
 #include "clienthandler.h"
 
+#include <listenerhelpers.h>
+
+#include <algorithm>
+
 #include <boost/bind.hpp>
 #include <boost/thread/thread.hpp>
 
@@ -18,34 +22,51 @@ namespace ssoa
     /// and let the server quit gracefully. Notice that it is safe to register for the same signal multiple
     /// times in a program, provided all registrations for the specified signal are made through Asio.
     RegistryListener::RegistryListener(
-        const string& host, const string& port, size_t thread_pool_size, IRegistry& registry) :
-        threadPoolSize(thread_pool_size), signals(ioService), acceptor(ioService), clientHandler(), registry(registry)
+        const string& host, const string& port, size_t thread_pool_size, IRegistry& registry, ListenerMode mode) :
+        threadPoolSize(thread_pool_size), mode(mode), registry(registry)
     {
-        signals.add(SIGINT);
-        signals.add(SIGTERM);
+        size_t workerCount = mode == IO_SERVICE_PER_THREAD ? std::max<size_t>(1, thread_pool_size) : 1;
+        for (size_t i = 0; i < workerCount; ++i) {
+            workers.emplace_back(new Worker());
+        }
+
+        signals.reset(new boost::asio::signal_set(workers[0]->ioService));
+        signals->add(SIGINT);
+        signals->add(SIGTERM);
 #if defined(SIGQUIT)
-        signals.add(SIGQUIT);
+        signals->add(SIGQUIT);
 #endif
-        signals.async_wait(boost::bind(&RegistryListener::handleStop, this));
+        signals->async_wait(boost::bind(&RegistryListener::handleStop, this));
 
         using namespace boost::asio::ip;
-        tcp::resolver resolver(ioService);
+        tcp::resolver resolver(workers[0]->ioService);
         tcp::resolver::query query(host, port);
         tcp::endpoint endpoint = *resolver.resolve(query);
-        acceptor.open(endpoint.protocol());
-        acceptor.set_option(tcp::acceptor::reuse_address(true));
-        acceptor.bind(endpoint);
-        acceptor.listen();
-
-        startAccept();
+        for (auto& worker : workers) {
+            // With one io_service per thread, every thread has its own socket listening on the
+            // same port, and the kernel distributes connections among them.
+            listenerhelpers::listen(worker->acceptor, endpoint, mode == IO_SERVICE_PER_THREAD);
+            startAccept(*worker);
+        }
     }
 
     void RegistryListener::run()
     {
-        // Create a pool of threads executing io_service::run().
         boost::thread_group threads;
+        if (mode == IO_SERVICE_PER_THREAD) {
+            // Each thread runs the io_service of its own worker, on its own core.
+            for (size_t i = 0; i < workers.size(); ++i) {
+                boost::thread *thread = threads.create_thread(
+                    boost::bind(&boost::asio::io_service::run, &workers[i]->ioService));
+                listenerhelpers::pinToCore(*thread, i);
+            }
+            threads.join_all();
+            return;
+        }
+
+        // Create a pool of threads executing io_service::run().
         for (size_t i = 0; i < threadPoolSize; ++i) {
-            threads.create_thread(boost::bind(&boost::asio::io_service::run, &ioService));
+            threads.create_thread(boost::bind(&boost::asio::io_service::run, &workers[0]->ioService));
         }
 
         // By calling io_service::run() from all threads in the pool, we let the io_service to post
@@ -61,30 +82,32 @@ namespace ssoa
         threads.join_all();
     }
 
-    void RegistryListener::startAccept()
+    void RegistryListener::startAccept(Worker& worker)
     {
         // We can reset a shared_ptr to a ClientHandler since it registers its callbacks by using a
         // shared_from_this() pointer.
-        clientHandler.reset(new ClientHandler(ioService, registry));
+        worker.clientHandler.reset(new ClientHandler(worker.ioService, registry));
 
         // Registers for an asynchronous accept
-        acceptor.async_accept(clientHandler->getSocket(),
-            boost::bind(&RegistryListener::handleAccept, this, boost::asio::placeholders::error));
+        worker.acceptor.async_accept(worker.clientHandler->getSocket(),
+            boost::bind(&RegistryListener::handleAccept, this, boost::ref(worker), boost::asio::placeholders::error));
     }
 
-    void RegistryListener::handleAccept(const boost::system::error_code& e)
+    void RegistryListener::handleAccept(Worker& worker, const boost::system::error_code& e)
     {
         if (!e) {
-            clientHandler->start();
+            worker.clientHandler->start();
         }
 
         // Every time a new connection is accepted, we start listening again, so that
         // the io_service's queue doesn't get empty and threads keep being executed.
-        startAccept();
+        startAccept(worker);
     }
 
     void RegistryListener::handleStop()
     {
-        ioService.stop();
+        for (auto& worker : workers) {
+            worker->ioService.stop();
+        }
     }
 }
@@ -0,0 +1,245 @@
+/*
+ * computepool.cpp
+ */
+
+#include <ssoa/service/computepool.h>
+#include <ssoa/logger.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include <boost/bind.hpp>
+
+namespace ssoa
+{
+    namespace
+    {
+        /// The pool owning the calling thread, and the index of its deque.
+        thread_local ComputePool *currentPool = NULL;
+        thread_local std::size_t currentIndex = 0;
+
+        /// The indices of a single run() call.
+        struct Job
+        {
+            Job(int count, const std::function<void(int)>& task) :
+                count(count), task(task), next(0), finished(0)
+            {
+            }
+
+            /// Processes indices until none is left.
+            void work()
+            {
+                for (int i = next++; i < count; i = next++) {
+                    try {
+                        task(i);
+                    }
+                    catch (const std::exception& e) {
+                        boost::lock_guard<boost::mutex> lock(mutex);
+                        if (error.empty()) {
+                            error = e.what();
+                        }
+                    }
+                    if (++finished == count) {
+                        boost::lock_guard<boost::mutex> lock(mutex);
+                        done.notify_all();
+                    }
+                }
+            }
+
+            const int count;
+            const std::function<void(int)>& task;
+            std::atomic<int> next;
+            std::atomic<int> finished;
+            boost::mutex mutex;
+            boost::condition_variable done;
+            std::string error;
+        };
+    }
+
+    ComputePool::ComputePool(std::size_t threads) :
+        threadCount(threads), pending(0), submitting(0), maxQueued(0), submitted(0), steals(0), rejected(0),
+        stopping(false), sleeping(0)
+    {
+        for (std::size_t i = 0; i < threads; i++) {
+            queues.emplace_back(new Queue());
+        }
+        for (std::size_t i = 0; i < threads; i++) {
+            this->threads.create_thread(boost::bind(&ComputePool::work, this, i));
+        }
+    }
+
+    ComputePool::~ComputePool()
+    {
+        stop();
+    }
+
+    void ComputePool::submit(std::function<void()> task)
+    {
+        enqueue(task, 0);
+    }
+
+    bool ComputePool::trySubmit(std::function<void()> task)
+    {
+        return enqueue(task, maxQueued);
+    }
+
+    void ComputePool::setMaxQueued(std::size_t maxQueued)
+    {
+        this->maxQueued = maxQueued;
+    }
+
+    bool ComputePool::enqueue(std::function<void()>& task, std::size_t limit)
+    {
+        submitting++;
+        if (threadCount == 0 || stopping) {
+            submitting--;
+            execute(task);
+            return true;
+        }
+
+        Queue& queue = currentPool == this ? *queues[currentIndex] : injected;
+        {
+            boost::lock_guard<boost::mutex> lock(queue.mutex);
+            if (limit > 0 && &queue == &injected && queue.tasks.size() >= limit) {
+                submitting--;
+                rejected++;
+                return false;
+            }
+            // Count the task first, so that pending never underflows when it is taken right away.
+            pending++;
+            submitted++;
+            queue.tasks.push_back(std::move(task));
+        }
+        submitting--;
+
+        if (sleeping > 0) {
+            boost::lock_guard<boost::mutex> lock(mutex);
+            available.notify_one();
+        }
+        return true;
+    }
+
+    void ComputePool::run(int count, const std::function<void(int)>& task)
+    {
+        std::shared_ptr<Job> job = std::make_shared<Job>(count, task);
+
+        // Idle threads steal these from the caller's deque; the ones started after all the
+        // indices have been taken return immediately.
+        int helpers = std::min<int>(count - 1, static_cast<int>(threadCount));
+        for (int i = 0; i < helpers; i++) {
+            submit([job]() { job->work(); });
+        }
+
+        job->work();
+
+        boost::unique_lock<boost::mutex> lock(job->mutex);
+        while (job->finished < count) {
+            job->done.wait(lock);
+        }
+        if (!job->error.empty()) {
+            throw std::runtime_error(job->error);
+        }
+    }
+
+    void ComputePool::stop()
+    {
+        stopping = true;
+        while (submitting > 0) {
+            boost::this_thread::yield();
+        }
+        {
+            boost::lock_guard<boost::mutex> lock(mutex);
+            available.notify_all();
+        }
+        threads.join_all();
+    }
+
+    ComputePool::Statistics ComputePool::getStatistics() const
+    {
+        Statistics statistics;
+        statistics.submitted = submitted;
+        statistics.steals = steals;
+        statistics.queued = pending;
+        statistics.rejected = rejected;
+        return statistics;
+    }
+
+    ComputePool *ComputePool::current()
+    {
+        return currentPool;
+    }
+
+    void ComputePool::work(std::size_t index)
+    {
+        currentPool = this;
+        currentIndex = index;
+
+        std::function<void()> task;
+        while (true) {
+            if (take(index, task)) {
+                execute(task);
+                task = nullptr;
+                continue;
+            }
+
+            boost::unique_lock<boost::mutex> lock(mutex);
+            sleeping++;
+            while (pending == 0 && !stopping) {
+                available.wait(lock);
+            }
+            sleeping--;
+            if (pending == 0) {
+                return; // Stopping, and nothing left to do
+            }
+        }
+    }
+
+    bool ComputePool::take(std::size_t index, std::function<void()>& task)
+    {
+        if (pending == 0) {
+            return false;
+        }
+        {
+            Queue& own = *queues[index];
+            boost::lock_guard<boost::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                pending--;
+                return true;
+            }
+        }
+        {
+            boost::lock_guard<boost::mutex> lock(injected.mutex);
+            if (!injected.tasks.empty()) {
+                task = std::move(injected.tasks.front());
+                injected.tasks.pop_front();
+                pending--;
+                return true;
+            }
+        }
+        for (std::size_t i = 1; i < threadCount; i++) {
+            Queue& victim = *queues[(index + i) % threadCount];
+            boost::lock_guard<boost::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                pending--;
+                steals++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void ComputePool::execute(const std::function<void()>& task)
+    {
+        try {
+            task();
+        }
+        catch (const std::exception& e) {
+            Logger::error("Exception in compute task: %1%", e.what());
+        }
+    }
+}
@@ -29,6 +29,12 @@ namespace ssoa
             e << (int)boost::asio::buffer_size(arguments[i]->getData());
         }
         e << YAML::EndSeq;
+        if (epoch != 0) {
+            e << YAML::Key << "epoch" << YAML::Value << epoch;
+            if (serviceId >= 0) {
+                e << YAML::Key << "id" << YAML::Value << serviceId;
+            }
+        }
         e << YAML::EndMap;
 
         vector<boost::asio::const_buffer> buffers;
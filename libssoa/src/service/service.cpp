@@ -5,34 +5,36 @@
 #include <ssoa/service/service.h>
 
 #include <boost/asio/buffer.hpp>
-#include <yaml-cpp/yaml.h>
+#include <boost/lexical_cast.hpp>
 
 using std::string;
 using std::vector;
 
 namespace ssoa
 {
-    vector<boost::asio::const_buffer> Service::getConstBuffers() const
+    vector<boost::asio::const_buffer> Service::getConstBuffers(const string& headerTemplate, long timeout) const
     {
         if (arguments.size() < signature.getInputParams().size()) {
             int n = signature.getInputParams().size() - arguments.size();
             throw std::logic_error("Still missing " + boost::lexical_cast<string>(n) + " argument(s).");
         }
 
-        // Construct the YAML header
-        YAML::Emitter e;
-        e << YAML::BeginMap;
-        e << YAML::Key << "service" << YAML::Value << signature;
-        e << YAML::Key << "blocks";
-        e << YAML::Value << YAML::BeginSeq;
+        // Complete the YAML header: the fields identifying the service do not change from a
+        // request to another, and the others are just numbers, so no YAML::Emitter is needed.
+        header = headerTemplate;
+        header += "blocks: [";
         for (unsigned i = 0; i < arguments.size(); i++) {
-            e << (int)boost::asio::buffer_size(arguments[i]->getData());
+            if (i > 0) {
+                header += ", ";
+            }
+            header += boost::lexical_cast<string>(boost::asio::buffer_size(arguments[i]->getData()));
+        }
+        header += "]\n";
+        if (timeout > 0) {
+            header += "timeout: " + boost::lexical_cast<string>(timeout) + "\n";
         }
-        e << YAML::EndSeq;
-        e << YAML::EndMap;
 
         vector<boost::asio::const_buffer> buffers;
-        header = e.c_str(); // e.c_str() will be invalidated at the end of this method
         buffers.push_back(boost::asio::buffer(header.c_str(), header.size() + 1));
 
         // Add the payload with data blocks
@@ -42,4 +44,22 @@ namespace ssoa
 
         return buffers;
     }
+
+    string Service::headerTemplate(const ServiceSignature& signature)
+    {
+        // Double-quoted, since an invalid signature may contain YAML indicators, e.g. "*".
+        string quoted;
+        for (char c : static_cast<string>(signature)) {
+            if (c == '"' || c == '\\') {
+                quoted += '\\';
+            }
+            quoted += c;
+        }
+        return "service: \"" + quoted + "\"\n";
+    }
+
+    string Service::headerTemplate(long serviceId, unsigned long epoch)
+    {
+        return "id: " + boost::lexical_cast<string>(serviceId) + "\nepoch: " + boost::lexical_cast<string>(epoch) + "\n";
+    }
 }
@@ -4,4 +4,83 @@
 
 #include <ssoa/service/serviceargument.h>
 
-// Just check if header compiles fine
+#include <new>
+
+namespace ssoa
+{
+    namespace
+    {
+        /// The size of the blocks of the pool, enough for any of the standard arguments.
+        /// Larger classes derived from ServiceArgument are allocated from the heap.
+        const std::size_t blockSize = 64;
+
+        /// The blocks kept by each thread; further blocks are released to the heap. Arguments
+        /// are often deleted by a thread other than the one which created them (e.g. by the
+        /// compute pool), so without a limit a thread could collect them forever.
+        const std::size_t maxFreeBlocks = 256;
+
+        static_assert(sizeof(ServiceIntArgument) <= blockSize, "Block too small.");
+        static_assert(sizeof(ServiceDoubleArgument) <= blockSize, "Block too small.");
+        static_assert(sizeof(ServiceStringArgument) <= blockSize, "Block too small.");
+        static_assert(sizeof(ServiceBufferArgument) <= blockSize, "Block too small.");
+
+        /// A list of free blocks, linked through their first bytes.
+        struct FreeList
+        {
+            struct Block
+            {
+                Block *next;
+            };
+
+            Block *head;
+            std::size_t size;
+
+            FreeList() :
+                head(NULL), size(0)
+            {
+            }
+
+            ~FreeList() {
+                while (head != NULL) {
+                    Block *block = head;
+                    head = head->next;
+                    ::operator delete(block);
+                }
+                // Arguments deleted later, by destructors of other thread-local objects, go
+                // straight to the heap.
+                size = maxFreeBlocks;
+            }
+        };
+
+        thread_local FreeList freeList;
+    }
+
+    void* ServiceArgument::operator new(std::size_t size)
+    {
+        if (size > blockSize) {
+            return ::operator new(size);
+        }
+        if (freeList.head == NULL) {
+            return ::operator new(blockSize);
+        }
+        FreeList::Block *block = freeList.head;
+        freeList.head = block->next;
+        freeList.size--;
+        return block;
+    }
+
+    void ServiceArgument::operator delete(void* p, std::size_t size)
+    {
+        if (p == NULL) {
+            return;
+        }
+        if (size > blockSize || freeList.size >= maxFreeBlocks) {
+            ::operator delete(p);
+            return;
+        }
+        FreeList::Block *block = static_cast<FreeList::Block*>(p);
+        block->next = freeList.head;
+        freeList.head = block;
+        freeList.size++;
+    }
+}
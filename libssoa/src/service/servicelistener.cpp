@@ -4,66 +4,381 @@
 
 #include <ssoa/service/servicelistener.h>
 #include <ssoa/service/serviceskeleton.h>
+#include <ssoa/logger.h>
+
+#include <listenerhelpers.h>
+
+#include <algorithm>
+#include <csignal>
 
 #include <boost/asio/placeholders.hpp>
 #include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/thread/thread.hpp>
 
+#include <sys/wait.h>
+#include <unistd.h>
+
 using std::string;
 using namespace boost::asio::ip;
 
 namespace ssoa
 {
-    ServiceListener::ServiceListener(const string& host, const string& port, size_t thread_pool_size) :
-        threadPoolSize(thread_pool_size), signals(ioService), acceptor(ioService)
+    namespace
+    {
+        /// How long the process started on hot restart may take to listen, in milliseconds.
+        const long successorTimeout = 30000;
+    }
+
+    /// Counts the connections and payload bytes in progress, and resumes accepting when they
+    /// fall below the low-water mark.
+    class ConnectionTracker: public RequestTracker
+    {
+    public:
+        ConnectionTracker() :
+            connections(0), payloadBytes(0), maxConnections(0), maxPayloadBytes(0), paused(false)
+        {
+        }
+
+        void onAccepted() {
+            connections++;
+        }
+
+        bool onPayload(size_t bytes) {
+            size_t current = payloadBytes;
+            do {
+                if (maxPayloadBytes > 0 && current + bytes > maxPayloadBytes) {
+                    return false;
+                }
+            } while (!payloadBytes.compare_exchange_weak(current, current + bytes));
+            return true;
+        }
+
+        void onFinished(size_t bytes) {
+            payloadBytes -= bytes;
+            connections--;
+            if (paused && belowLowWater()) {
+                boost::lock_guard<boost::mutex> lock(mutex);
+                if (paused.exchange(false) && resume) {
+                    resume();
+                }
+            }
+        }
+
+        /// Whether accepting must be paused.
+        bool aboveHighWater() const {
+            return (maxConnections > 0 && connections >= maxConnections)
+                || (maxPayloadBytes > 0 && payloadBytes >= maxPayloadBytes);
+        }
+
+        /// Whether accepting may be resumed; the gap with the high-water mark avoids pausing
+        /// and resuming on every connection.
+        bool belowLowWater() const {
+            return (maxConnections == 0 || connections <= maxConnections * 3 / 4)
+                && (maxPayloadBytes == 0 || payloadBytes <= maxPayloadBytes * 3 / 4);
+        }
+
+        std::atomic<size_t> connections;
+        std::atomic<size_t> payloadBytes;
+        size_t maxConnections;
+        size_t maxPayloadBytes;
+
+        /// Whether any worker is paused.
+        std::atomic<bool> paused;
+
+        /// Resumes the paused workers; reset when the listener is destroyed.
+        boost::mutex mutex;
+        std::function<void()> resume;
+    };
+
+    ServiceListener::ServiceListener(const string& host, const string& port, size_t thread_pool_size,
+                                     ListenerMode mode, size_t compute_pool_size) :
+        threadPoolSize(thread_pool_size), mode(mode), computePool(new ComputePool(compute_pool_size)),
+        tracker(std::make_shared<ConnectionTracker>()), draining(false), drainTimeout(30000), successor(-1),
+        successorReadyFd(-1)
     {
-        signals.add(SIGINT);
-        signals.add(SIGTERM);
+        tracker->resume = boost::bind(&ServiceListener::resume, this);
+
+        size_t workerCount = mode == IO_SERVICE_PER_THREAD ? std::max<size_t>(1, thread_pool_size) : 1;
+        for (size_t i = 0; i < workerCount; ++i) {
+            workers.emplace_back(new Worker());
+        }
+
+        signals.reset(new boost::asio::signal_set(workers[0]->ioService));
+        signals->add(SIGINT);
+        signals->add(SIGTERM);
 #if defined(SIGQUIT)
-        signals.add(SIGQUIT);
+        signals->add(SIGQUIT);
 #endif
-        signals.async_wait(boost::bind(&ServiceListener::handleStop, this));
+        signals->async_wait(boost::bind(&ServiceListener::handleStop, this,
+                                        boost::asio::placeholders::error, boost::asio::placeholders::signal_number));
+        drainTimer.reset(new boost::asio::deadline_timer(workers[0]->ioService));
+        successorTimer.reset(new boost::asio::deadline_timer(workers[0]->ioService));
 
-        tcp::resolver resolver(ioService);
+        tcp::resolver resolver(workers[0]->ioService);
         tcp::resolver::query query(host, port);
         tcp::endpoint endpoint = *resolver.resolve(query);
-        acceptor.open(endpoint.protocol());
-        acceptor.set_option(tcp::acceptor::reuse_address(true));
-        acceptor.bind(endpoint);
-        acceptor.listen();
 
-        startAccept();
+        // Take over the sockets of the previous process on hot restart; any missing one is
+        // opened again, which is only possible with SO_REUSEPORT.
+        std::vector<int> inherited = listenerhelpers::inheritedSockets();
+        for (size_t i = 0; i < workers.size(); ++i) {
+            if (i < inherited.size()) {
+                workers[i]->acceptor.assign(endpoint.protocol(), inherited[i]);
+            }
+            else {
+                listenerhelpers::listen(workers[i]->acceptor, endpoint, mode == IO_SERVICE_PER_THREAD);
+            }
+            startAccept(*workers[i]);
+        }
+        for (size_t i = workers.size(); i < inherited.size(); ++i) {
+            ::close(inherited[i]);
+        }
+        if (!inherited.empty()) {
+            Logger::info("Took over %1% listening sockets from the previous process.", inherited.size());
+        }
+        listenerhelpers::notifyReady();
+    }
+
+    ServiceListener::~ServiceListener()
+    {
+        // Requests may be destroyed along with the io_services, and must not resume them.
+        boost::lock_guard<boost::mutex> lock(tracker->mutex);
+        tracker->resume = nullptr;
     }
 
     void ServiceListener::run()
     {
         boost::thread_group threads;
-        for (size_t i = 0; i < threadPoolSize; ++i) {
-            threads.create_thread(boost::bind(&boost::asio::io_service::run, &ioService));
+        if (mode == IO_SERVICE_PER_THREAD) {
+            for (size_t i = 0; i < workers.size(); ++i) {
+                boost::thread *thread = threads.create_thread(
+                    boost::bind(&boost::asio::io_service::run, &workers[i]->ioService));
+                listenerhelpers::pinToCore(*thread, i);
+            }
+        }
+        else {
+            for (size_t i = 0; i < threadPoolSize; ++i) {
+                threads.create_thread(boost::bind(&boost::asio::io_service::run, &workers[0]->ioService));
+            }
         }
 
         threads.join_all();
+
+        // Let the services still running finish; their responses are dropped with the io_services.
+        computePool->stop();
+        if (computePool->size() > 0) {
+            ComputePool::Statistics statistics = computePool->getStatistics();
+            Logger::info("Compute pool: %1% tasks submitted, %2% stolen, %3% rejected.",
+                         statistics.submitted, statistics.steals, statistics.rejected);
+        }
+    }
+
+    void ServiceListener::setLimits(size_t maxConnections, size_t maxPayloadBytes, size_t maxQueued)
+    {
+        tracker->maxConnections = maxConnections;
+        tracker->maxPayloadBytes = maxPayloadBytes;
+        computePool->setMaxQueued(maxQueued);
     }
 
-    void ServiceListener::startAccept()
+    void ServiceListener::setDrainHandler(DrainHandler handler)
     {
-        clientSocket.reset(new tcp::socket(ioService));
+        drainHandler = std::move(handler);
+    }
 
-        acceptor.async_accept(*clientSocket.get(), boost::bind(&ServiceListener::handleAccept, this,
-                                                               boost::asio::placeholders::error));
+    void ServiceListener::setDrainTimeout(long milliseconds)
+    {
+        drainTimeout = milliseconds;
+    }
+
+    void ServiceListener::enableHotRestart(char *argv[])
+    {
+        restartArguments.clear();
+        for (char **arg = argv; *arg != NULL; arg++) {
+            restartArguments.push_back(*arg);
+        }
+        if (!restartArguments.empty()) {
+            restartProgram = listenerhelpers::programPath(restartArguments[0]);
+        }
+        signals->add(SIGHUP);
     }
 
-    void ServiceListener::handleAccept(const boost::system::error_code& e)
+    void ServiceListener::startAccept(Worker& worker)
+    {
+        worker.clientSocket.reset(new tcp::socket(worker.ioService));
+
+        worker.acceptor.async_accept(*worker.clientSocket.get(),
+                                     boost::bind(&ServiceListener::handleAccept, this, boost::ref(worker),
+                                                 boost::asio::placeholders::error));
+    }
+
+    void ServiceListener::handleAccept(Worker& worker, const boost::system::error_code& e)
     {
         if (!e) {
-            ServiceSkeleton::start(std::move(clientSocket));
+            tracker->onAccepted();
+            ServiceSkeleton::start(std::move(worker.clientSocket), worker.ioService,
+                                   computePool->size() > 0 ? computePool.get() : NULL, tracker);
+        }
+
+        if (draining) {
+            return;
+        }
+        if (tracker->aboveHighWater()) {
+            worker.paused = true;
+            if (!tracker->paused.exchange(true)) {
+                Logger::info("Pausing accepts: %1% connections, %2% payload bytes in progress.",
+                             tracker->connections.load(), tracker->payloadBytes.load());
+            }
+            // Requests completed in the meantime may have found nothing to resume.
+            bool wasPaused = true;
+            if (!tracker->belowLowWater() || !worker.paused.compare_exchange_strong(wasPaused, false)) {
+                return;
+            }
+        }
+        startAccept(worker);
+    }
+
+    void ServiceListener::resume()
+    {
+        Logger::debug("Resuming accepts.");
+        for (auto& w : workers) {
+            Worker *worker = w.get();
+            worker->ioService.post([this, worker]() {
+                bool wasPaused = true;
+                if (worker->paused.compare_exchange_strong(wasPaused, false) && !draining) {
+                    startAccept(*worker);
+                }
+            });
+        }
+    }
+
+    void ServiceListener::handleStop(const boost::system::error_code& e, int signalNumber)
+    {
+        if (e) {
+            return;
+        }
+        if (draining) {
+            Logger::info("Stopping immediately.");
+            stop();
+            return;
         }
 
-        startAccept();
+        if (signalNumber != SIGHUP) {
+            drain(false);
+            return;
+        }
+        std::vector<int> fds;
+        for (auto& worker : workers) {
+            fds.push_back(worker->acceptor.native_handle());
+        }
+        successor = listenerhelpers::spawnSuccessor(restartProgram, restartArguments, fds, successorReadyFd);
+        if (successor < 0) {
+            Logger::error("Cannot start a new process: going on serving.");
+            signals->async_wait(boost::bind(&ServiceListener::handleStop, this,
+                                            boost::asio::placeholders::error,
+                                            boost::asio::placeholders::signal_number));
+            return;
+        }
+        Logger::info("Started a new process (%1%), waiting for it to listen.", successor);
+        successorDeadline = boost::posix_time::microsec_clock::universal_time() +
+            boost::posix_time::milliseconds(successorTimeout);
+        checkSuccessor(boost::system::error_code());
     }
 
-    void ServiceListener::handleStop()
+    void ServiceListener::checkSuccessor(const boost::system::error_code& e)
     {
-        ioService.stop();
+        if (e) {
+            return;
+        }
+        int state = listenerhelpers::successorState(successorReadyFd);
+        if (state == 0 && boost::posix_time::microsec_clock::universal_time() < successorDeadline) {
+            successorTimer->expires_from_now(boost::posix_time::milliseconds(20));
+            successorTimer->async_wait(boost::bind(&ServiceListener::checkSuccessor, this,
+                                                   boost::asio::placeholders::error));
+            return;
+        }
+        ::close(successorReadyFd);
+        successorReadyFd = -1;
+
+        if (state > 0) {
+            Logger::info("The new process is listening: handing over the listening sockets.");
+            drain(true);
+            return;
+        }
+        Logger::error("The new process failed to start: going on serving.");
+        ::kill(successor, SIGKILL);
+        ::waitpid(successor, NULL, 0);
+        successor = -1;
+        signals->async_wait(boost::bind(&ServiceListener::handleStop, this,
+                                        boost::asio::placeholders::error, boost::asio::placeholders::signal_number));
+    }
+
+    void ServiceListener::drain(bool handover)
+    {
+        draining = true;
+        if (drainHandler) {
+            try {
+                drainHandler(handover);
+            }
+            catch (const std::exception& e) {
+                Logger::error("Exception while draining: %1%", e.what());
+            }
+        }
+
+        // Close the acceptors from their own io_services. On handover, the new process keeps
+        // the sockets open, and connections waiting in the backlog are accepted by it.
+        for (auto& worker : workers) {
+            boost::asio::ip::tcp::acceptor *acceptor = &worker->acceptor;
+            worker->ioService.post([acceptor]() {
+                boost::system::error_code ignored;
+                acceptor->close(ignored);
+            });
+        }
+
+        Logger::info("Draining %1% requests in progress.", tracker->connections.load());
+        drainDeadline = boost::posix_time::microsec_clock::universal_time() +
+            boost::posix_time::milliseconds(drainTimeout);
+        checkDrained(boost::system::error_code());
+
+        // A second signal stops the server immediately.
+        signals->async_wait(boost::bind(&ServiceListener::handleStop, this,
+                                        boost::asio::placeholders::error, boost::asio::placeholders::signal_number));
+    }
+
+    void ServiceListener::checkDrained(const boost::system::error_code& e)
+    {
+        if (e) {
+            return;
+        }
+        // Reap the new process if it exits while this one drains.
+        if (successor > 0 && ::waitpid(successor, NULL, WNOHANG) == successor) {
+            Logger::error("The new process has exited.");
+            successor = -1;
+        }
+        size_t requests = tracker->connections;
+        if (requests == 0) {
+            Logger::info("Drained.");
+            stop();
+            return;
+        }
+        if (boost::posix_time::microsec_clock::universal_time() >= drainDeadline) {
+            Logger::info("Drain timeout expired: abandoning %1% requests.", requests);
+            stop();
+            return;
+        }
+        drainTimer->expires_from_now(boost::posix_time::milliseconds(20));
+        drainTimer->async_wait(boost::bind(&ServiceListener::checkDrained, this, boost::asio::placeholders::error));
+    }
+
+    void ServiceListener::stop()
+    {
+        if (computePool->size() > 0) {
+            Logger::info("Stopping with %1% compute tasks queued.", computePool->getStatistics().queued);
+        }
+        for (auto& worker : workers) {
+            worker->ioService.stop();
+        }
     }
 }
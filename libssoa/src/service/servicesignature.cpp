@@ -4,46 +4,236 @@
 
 #include <ssoa/service/servicesignature.h>
 
+#include <atomic>
+#include <cctype>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/mutex.hpp>
+
+#ifndef SSOA_NO_REGEX
 #include <boost/regex.hpp>
+#endif
 
 using std::string;
 
 namespace ssoa
 {
+    namespace
+    {
+        /// Signatures come from the network too, so the cache is bounded: once full, further
+        /// signatures are parsed each time.
+        const std::size_t maxCachedSignatures = 4096;
+
+#ifdef SSOA_NO_REGEX
+        std::atomic<int> parser(ServiceSignature::HANDWRITTEN_PARSER);
+#else
+        std::atomic<int> parser(ServiceSignature::REGEX_PARSER);
+#endif
+
+        bool isWord(char c)
+        {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+        }
+
+        bool isSpace(char c)
+        {
+            return std::isspace(static_cast<unsigned char>(c));
+        }
+
+        /// Fills @c inputParams and @c outputParams with the parameters in [p, end), a list of
+        /// "(in|out) <type>" separated by commas, and appends them in normal form to
+        /// @c arguments.
+        ///
+        /// @return false if the list is not valid; the parameters before the error are kept.
+        template<typename Data>
+        bool parseParams(const char *p, const char *end, Data& data, string& arguments)
+        {
+            while (p != end) {
+                const char *direction = p;
+                while (p != end && isWord(*p)) {
+                    p++;
+                }
+                string dir(direction, p);
+                if ((dir != "in" && dir != "out") || p == end || !isSpace(*p)) {
+                    return false;
+                }
+                while (p != end && isSpace(*p)) {
+                    p++;
+                }
+                const char *type = p;
+                while (p != end && isWord(*p)) {
+                    p++;
+                }
+                if (p == type) {
+                    return false;
+                }
+                string t(type, p);
+                while (p != end && isSpace(*p)) {
+                    p++;
+                }
+                if (p != end) {
+                    if (*p != ',') {
+                        return false;
+                    }
+                    p++;
+                    while (p != end && isSpace(*p)) {
+                        p++;
+                    }
+                }
+
+                if (!arguments.empty()) {
+                    arguments.append(", ");
+                }
+                arguments.append(dir + " " + t);
+                (dir == "in" ? data.inputParams : data.outputParams).push_back(t);
+            }
+            return true;
+        }
+
+        /// Parses "<name>(<params>)", surrounded by any whitespace, without regular expressions.
+        template<typename Data>
+        void parseHandwritten(const string& signature, Data& data)
+        {
+            const char *p = signature.data(), *end = p + signature.size();
+            while (p != end && isSpace(*p)) {
+                p++;
+            }
+            const char *name = p;
+            while (p != end && isWord(*p)) {
+                p++;
+            }
+            const char *nameEnd = p;
+            while (p != end && isSpace(*p)) {
+                p++;
+            }
+
+            // The parameters end at the last ')', which may only be followed by whitespace.
+            const char *close = end;
+            while (close != p && isSpace(close[-1])) {
+                close--;
+            }
+            bool valid = nameEnd != name && p != end && *p == '(' && close != p + 1 && close[-1] == ')';
+            if (!valid) {
+                // Not even the structure is right: keep the text, to report it.
+                data.name = signature;
+                data.signature = signature + "()";
+                data.is_valid = false;
+                return;
+            }
+            close--;
+            p++;
+            while (p != close && isSpace(*p)) {
+                p++;
+            }
+
+            data.name.assign(name, nameEnd);
+            string arguments;
+            data.is_valid = p != close && parseParams(p, close, data, arguments);
+            data.signature = data.name + "(" + arguments + ")";
+        }
+
+#ifndef SSOA_NO_REGEX
+        template<typename Data>
+        void parseRegex(const string& signature, Data& data)
+        {
+            using namespace boost;
+
+            // Compiled once: matching with a const regex is thread-safe.
+            static const regex sigRegex("\\s*(\\w+)\\s*\\(\\s*(.+)\\)\\s*");
+            static const regex argRegex("\\G(in|out)\\s+(\\w+)\\s*(,\\s*|$)|\\G(.+)");
+
+            data.is_valid = regex_match(signature, sigRegex);
+            data.name = regex_replace(signature, sigRegex, "\\1");
+
+            string arguments;
+            string args = regex_replace(signature, sigRegex, "\\2");
+            sregex_iterator i(args.begin(), args.end(), argRegex), j;
+            while (i != j)
+            {
+                if (!(*i).str(4).empty()) {
+                    data.is_valid = false;
+                    break;
+                }
+                string direction = (*i).str(1);
+                string type = (*i).str(2);
+                if (!arguments.empty())
+                    arguments.append(", ");
+                arguments.append(direction + " " + type);
+                if (direction == "in")
+                    data.inputParams.push_back(type);
+                else
+                    data.outputParams.push_back(type);
+                i++;
+            }
+            data.signature = data.name + "(" + arguments + ")";
+        }
+#endif
+    }
+
     ServiceSignature ServiceSignature::any;
 
-    string ServiceSignature::sigPattern = "\\s*(\\w+)\\s*\\(\\s*(.+)\\)\\s*";
-    string ServiceSignature::argPattern = "\\G(in|out)\\s+(\\w+)\\s*(,\\s*|$)|\\G(.+)";
+    ServiceSignature::ServiceSignature()
+    {
+        static const std::shared_ptr<const Data> anyData = []() {
+            std::shared_ptr<Data> d = std::make_shared<Data>();
+            d->name = "*";
+            d->signature = "*";
+            d->is_valid = false;
+            return d;
+        }();
+        data = anyData;
+    }
 
     ServiceSignature::ServiceSignature(const string & signature)
     {
-        using namespace boost;
-
-        regex sigRegex(sigPattern);
-        this->is_valid = regex_match(signature, sigRegex);
-        this->name = regex_replace(signature, sigRegex, "\\1");
+        // Construct-on-first-use, like FactoryBase::mappings().
+        static boost::mutex mutex;
+        static std::unordered_map<string, std::shared_ptr<const Data>> cache;
 
-        string arguments;
-        string args = regex_replace(signature, sigRegex, "\\2");
-        regex argRegex(argPattern);
-        sregex_iterator i(args.begin(), args.end(), argRegex), j;
-        while (i != j)
         {
-            if (!(*i).str(4).empty()) {
-                is_valid = false;
-                break;
-            }
-            string direction = (*i).str(1);
-            string type = (*i).str(2);
-            if (!arguments.empty())
-                arguments.append(", ");
-            arguments.append(direction + " " + type);
-            if (direction == "in")
-                inputParams.push_back(type);
-            else
-                outputParams.push_back(type);
-            i++;
-        }
-        this->signature = name + "(" + arguments + ")";
+            boost::lock_guard<boost::mutex> lock(mutex);
+            auto iter = cache.find(signature);
+            if (iter != cache.end()) {
+                data = iter->second;
+                return;
+            }
+        }
+
+        data = parse(signature).data;
+
+        boost::lock_guard<boost::mutex> lock(mutex);
+        if (cache.size() < maxCachedSignatures) {
+            cache.emplace(signature, data);
+        }
+    }
+
+    ServiceSignature ServiceSignature::parse(const string & signature)
+    {
+        std::shared_ptr<Data> d = std::make_shared<Data>();
+#ifndef SSOA_NO_REGEX
+        if (parser == REGEX_PARSER) {
+            parseRegex(signature, *d);
+            return ServiceSignature(std::shared_ptr<const Data>(std::move(d)));
+        }
+#endif
+        parseHandwritten(signature, *d);
+        return ServiceSignature(std::shared_ptr<const Data>(std::move(d)));
+    }
+
+    void ServiceSignature::setParser(Parser p)
+    {
+#ifdef SSOA_NO_REGEX
+        if (p == REGEX_PARSER) {
+            throw std::logic_error("The regular expression parser is not available.");
+        }
+#endif
+        parser = p;
+    }
+
+    ServiceSignature::Parser ServiceSignature::getParser()
+    {
+        return static_cast<Parser>(parser.load());
     }
 }
@@ -3,18 +3,24 @@
  */
 
 #include <ssoa/service/serviceskeleton.h>
+#include <ssoa/service/computepool.h>
 #include <ssoa/logger.h>
 #include <ssoa/registry/registry.h>
 
+#include <atomic>
 #include <memory>
+#include <random>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
 #include <boost/asio/buffers_iterator.hpp>
+#include <boost/asio/deadline_timer.hpp>
 #include <boost/asio/placeholders.hpp>
 #include <boost/asio/read.hpp>
 #include <boost/asio/streambuf.hpp>
+#include <boost/asio/strand.hpp>
 #include <boost/bind.hpp>
 #include <boost/noncopyable.hpp>
 #include <yaml-cpp/yaml.h>
@@ -25,64 +31,184 @@ using std::string;
 using std::vector;
 
 using boost::asio::buffers_begin;
+using boost::asio::deadline_timer;
 using boost::asio::ip::tcp;
 using boost::asio::mutable_buffer;
 using boost::asio::streambuf;
 using boost::system::error_code;
+using boost::posix_time::microsec_clock;
+using boost::posix_time::milliseconds;
+using boost::posix_time::ptime;
 
 namespace ssoa
 {
+    namespace
+    {
+        /// How long a client may take to send a request, and to receive the response.
+        std::atomic<long> idleTimeout(30000);
+
+        /// Gets the epoch of this process, sent along with the identifiers of the services so
+        /// that clients do not use them with another run of the provider, which may have
+        /// installed the services in another order.
+        unsigned long epoch()
+        {
+            static const unsigned long e = []() {
+                std::random_device random;
+                unsigned long value = 0;
+                while (value == 0) {
+                    value = (static_cast<unsigned long>(random()) << 16) ^ random();
+                }
+                return value;
+            }();
+            return e;
+        }
+    }
+
+    /// Reads a request, invokes the service and writes the response. All handlers run on a
+    /// strand, so that the deadline timer may close the socket at any moment.
     class ServiceSkeletonSerializationHelper:
         public std::enable_shared_from_this<ServiceSkeletonSerializationHelper>, private boost::noncopyable
     {
     public:
-        ServiceSkeletonSerializationHelper(std::unique_ptr<tcp::socket> socket) :
-            socket(std::move(socket)), signature(ServiceSignature::any)
+        ServiceSkeletonSerializationHelper(std::unique_ptr<tcp::socket> socket, boost::asio::io_service& ioService,
+                                           ComputePool *computePool, std::shared_ptr<RequestTracker> tracker) :
+            socket(std::move(socket)), strand(ioService), timer(ioService), timedOut(false),
+            computePool(computePool), tracker(std::move(tracker)), payloadBytes(0), headerBuffer(maxHeaderBytes),
+            signature(ServiceSignature::any), serviceId(ServiceSkeleton::Factory::npos), handshake(false)
         {
+            error_code ignored;
+            remote = this->socket->remote_endpoint(ignored);
+        }
+
+        ~ServiceSkeletonSerializationHelper() {
+            if (tracker) {
+                tracker->onFinished(payloadBytes);
+            }
         }
 
         void start() {
-            Logger::debug("%1% -- Accepted request.", socket->remote_endpoint());
+            Logger::debug("%1% -- Accepted request.", remote);
+            setTimer(microsec_clock::universal_time() + milliseconds(idleTimeout.load()));
             async_read_until(
                 *socket.get(),
                 headerBuffer,
                 '\0',
-                boost::bind(&ServiceSkeletonSerializationHelper::onHeaderReceived,
-                            shared_from_this(),
-                            boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred));
+                strand.wrap(boost::bind(&ServiceSkeletonSerializationHelper::onHeaderReceived,
+                                        shared_from_this(),
+                                        boost::asio::placeholders::error,
+                                        boost::asio::placeholders::bytes_transferred)));
         }
 
+        /// The largest header accepted; longer ones are not buffered further.
+        enum { maxHeaderBytes = 64 * 1024 };
+
         unique_ptr<tcp::socket> socket;
+        tcp::endpoint remote;
+        boost::asio::io_service::strand strand;
+        deadline_timer timer;
+        bool timedOut;
+        ComputePool *computePool;
+        std::shared_ptr<RequestTracker> tracker;
+        size_t payloadBytes;
         streambuf headerBuffer;
         vector<mutable_buffer> payloadBuffers;
 
         ServiceSignature signature;
+        std::size_t serviceId;
+        bool handshake;
         ServiceSkeleton::arg_deque arguments;
+        ptime deadline;
         unique_ptr<Response> response;
 
+        static const ServiceSignature& signatureOf(std::size_t id);
+        void setTimer(ptime expiry);
+        void onTimer(const error_code& e);
+        bool expired() const;
         void onHeaderReceived(const error_code& e, size_t bytes_transferred);
         void onPayloadReceived(const error_code& e, size_t bytes_transferred);
+        void invoke();
         void sendResponse(Response * r);
         void onWriteResponse(const error_code& e);
     };
 
-    void ServiceSkeleton::start(std::unique_ptr<tcp::socket> socket)
+    void ServiceSkeleton::start(std::unique_ptr<tcp::socket> socket, boost::asio::io_service& ioService,
+                                ComputePool *computePool, std::shared_ptr<RequestTracker> tracker)
     {
         std::shared_ptr<ServiceSkeletonSerializationHelper> helper(
-            new ServiceSkeletonSerializationHelper(std::move(socket)));
+            new ServiceSkeletonSerializationHelper(std::move(socket), ioService, computePool, std::move(tracker)));
         helper->start();
     }
 
+    void ServiceSkeleton::setIdleTimeout(long milliseconds)
+    {
+        idleTimeout = milliseconds;
+    }
+
+    long ServiceSkeleton::getTimeout() const
+    {
+        if (deadline.is_not_a_date_time()) {
+            return 0;
+        }
+        long left = (deadline - microsec_clock::universal_time()).total_milliseconds();
+        return left > 0 ? left : 1;
+    }
+
+    const ServiceSignature& ServiceSkeletonSerializationHelper::signatureOf(std::size_t id)
+    {
+        // Parsed once, on the first request. Services are installed before they are served,
+        // so the table is complete by then, and is read without a lock.
+        static const std::vector<ServiceSignature> signatures = []() {
+            ServiceSkeleton::Factory& factory = ServiceSkeleton::factory();
+            std::vector<ServiceSignature> s;
+            s.reserve(factory.size());
+            for (std::size_t i = 0; i < factory.size(); i++) {
+                s.emplace_back(factory.name(i));
+            }
+            return s;
+        }();
+        if (id >= signatures.size()) {
+            throw std::logic_error("Service installed after the first request.");
+        }
+        return signatures[id];
+    }
+
+    void ServiceSkeletonSerializationHelper::setTimer(ptime expiry)
+    {
+        timer.expires_at(expiry);
+        timer.async_wait(strand.wrap(boost::bind(&ServiceSkeletonSerializationHelper::onTimer,
+                                                 shared_from_this(), boost::asio::placeholders::error)));
+    }
+
+    void ServiceSkeletonSerializationHelper::onTimer(const error_code& e)
+    {
+        if (e == boost::asio::error::operation_aborted || timer.expires_at() > microsec_clock::universal_time()) {
+            return; // Cancelled or moved
+        }
+        // Closing the socket aborts the pending operation, whose handler just returns.
+        Logger::debug("%1% -- Timed out.", remote);
+        timedOut = true;
+        error_code ignored;
+        socket->close(ignored);
+    }
+
+    bool ServiceSkeletonSerializationHelper::expired() const
+    {
+        return !deadline.is_not_a_date_time() && microsec_clock::universal_time() >= deadline;
+    }
+
     void ServiceSkeletonSerializationHelper::onHeaderReceived(const error_code& e, size_t bytes_transferred)
     {
+        if (timedOut) {
+            return;
+        }
         if (e) {
             string message("Cannot receive header: " + e.message());
-            Logger::debug("%1% -- %2%", socket->remote_endpoint(), message);
+            Logger::debug("%1% -- %2%", remote, message);
             sendResponse(new Response(signature, false, message));
             return;
         }
 
-        Logger::debug("%1% -- Header received.", socket->remote_endpoint());
+        Logger::debug("%1% -- Header received.", remote);
 
         try {
             streambuf::const_buffers_type bufs = headerBuffer.data();
@@ -93,15 +219,48 @@ namespace ssoa
             YAML::Node node;
             parser.GetNextDocument(node);
 
-            signature = node["service"].to<string>();
+            ServiceSkeleton::Factory& factory = ServiceSkeleton::factory();
+            const YAML::Node *idNode = node.FindValue("id");
+            if (idNode != NULL) {
+                // The identifier assigned to the service in the response to a previous request.
+                std::size_t id = idNode->to<std::size_t>();
+                if (node["epoch"].to<unsigned long>() != epoch() || id >= factory.size()) {
+                    // The client retries with the signature.
+                    sendResponse(new Response(signature, false, "Unknown service identifier."));
+                    return;
+                }
+                serviceId = id;
+                signature = signatureOf(id);
+            }
+            else {
+                string name = node["service"].to<string>();
+                serviceId = factory.find(name);
+                if (serviceId == ServiceSkeleton::Factory::npos) {
+                    // Not in normal form, e.g. with extra spaces, or not supported at all.
+                    signature = name;
+                    serviceId = factory.find(signature);
+                }
+                else {
+                    signature = signatureOf(serviceId);
+                }
+
+                // Validate the signature by checking if the provider actually supports the service
+                if (serviceId == ServiceSkeleton::Factory::npos) {
+                    sendResponse(new Response(signature, false, "Service not available."));
+                    // Avoid reading all arguments when the service is unavailable.
+                    // With each connection, a single service request is serviced, so the we
+                    // immediately send a response and close the socket (automatically done on return).
+                    return;
+                }
+                // Tell the client the identifier to use in the next requests.
+                handshake = true;
+            }
 
-            // Validate the signature by checking if the provider actually supports the service
-            if (!ServiceSkeleton::factory().contains(signature)) {
-                sendResponse(new Response(signature, false, "Service not available."));
-                // Avoid reading all arguments when the service is unavailable.
-                // With each connection, a single service request is serviced, so the we
-                // immediately send a response and close the socket (automatically done on return).
-                return;
+            // The timeout is relative, since the clocks of client and provider may differ.
+            const YAML::Node *timeoutNode = node.FindValue("timeout");
+            if (timeoutNode != NULL) {
+                long timeout = timeoutNode->to<long>();
+                deadline = microsec_clock::universal_time() + milliseconds(timeout);
             }
 
             vector<unsigned int> blocks;
@@ -109,6 +268,9 @@ namespace ssoa
             for (unsigned i = 0; i < blocksNode.size(); i++) {
                 int block;
                 blocksNode[i] >> block;
+                if (block < 0) {
+                    throw std::runtime_error("Received an invalid request (negative argument block size).");
+                }
                 blocks.push_back(block);
             }
 
@@ -124,6 +286,18 @@ namespace ssoa
             // fetched by async_read_until().
             headerBuffer.consume(bytes_transferred);
 
+            // Check the size of the payload before allocating the arguments that receive it.
+            if (tracker) {
+                size_t bytes = 0;
+                for (unsigned i = 0; i < blocks.size(); i++) {
+                    bytes += blocks[i];
+                }
+                if (!tracker->onPayload(bytes)) {
+                    throw std::runtime_error("Payload too large for the memory available.");
+                }
+                payloadBytes = bytes;
+            }
+
             for (unsigned i = 0; i < params.size(); i++) {
                 ServiceArgument *arg = ServiceArgument::prepare(params[i], blocks[i]);
                 arguments.emplace_back(arg);
@@ -139,10 +313,17 @@ namespace ssoa
                 }
             }
 
+            // The payload must arrive before the deadline, if earlier than the idle timeout.
+            ptime expiry = microsec_clock::universal_time() + milliseconds(idleTimeout.load());
+            if (!deadline.is_not_a_date_time() && deadline < expiry) {
+                expiry = deadline;
+            }
+            setTimer(expiry);
             async_read(*socket.get(), payloadBuffers,
-                       boost::bind(&ServiceSkeletonSerializationHelper::onPayloadReceived,
-                                   shared_from_this(),
-                                   boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred));
+                       strand.wrap(boost::bind(&ServiceSkeletonSerializationHelper::onPayloadReceived,
+                                               shared_from_this(),
+                                               boost::asio::placeholders::error,
+                                               boost::asio::placeholders::bytes_transferred)));
         }
         catch (const std::exception &e) {
             sendResponse(new Response(signature, false, e.what()));
@@ -151,40 +332,87 @@ namespace ssoa
 
     void ServiceSkeletonSerializationHelper::onPayloadReceived(const error_code& e, size_t /* bytes_transferred */)
     {
+        if (timedOut) {
+            return;
+        }
         if (e) {
             string message("Cannot receive payload: " + e.message());
-            Logger::debug("%1% -- %2%", socket->remote_endpoint(), message);
+            Logger::debug("%1% -- %2%", remote, message);
             sendResponse(new Response(signature, false, message));
             return;
         }
 
-        Logger::debug("%1% -- Payload received.", socket->remote_endpoint());
+        Logger::debug("%1% -- Payload received.", remote);
+        // No timer while the service runs: it cannot be interrupted anyway.
+        timer.cancel();
 
-        Logger::debug("%1% -- Preparing response.", socket->remote_endpoint());
-        try {
-            unique_ptr<ServiceSkeleton> impl(ServiceSkeleton::factory().create(signature, std::move(arguments)));
-            sendResponse(impl->invoke());
+        if (computePool == NULL) {
+            invoke();
+            return;
         }
-        catch (const std::exception& e) {
-            sendResponse(new Response(signature, false, string("Internal server error: ") + e.what()));
+        // Run the service away from the I/O threads, which go on serving other connections.
+        // When too many requests are waiting already, fail right away, so that the client can
+        // retry on another provider instead of letting the overload pile up.
+        if (!computePool->trySubmit(boost::bind(&ServiceSkeletonSerializationHelper::invoke, shared_from_this()))) {
+            Logger::debug("%1% -- Compute pool full.", remote);
+            sendResponse(new Response(signature, false, "Busy"));
         }
     }
 
+    void ServiceSkeletonSerializationHelper::invoke()
+    {
+        Response *r;
+        if (expired()) {
+            // The client has given up: do not waste resources on the request, which would only
+            // delay the others, letting an overload spread.
+            Logger::debug("%1% -- Deadline expired before invocation.", remote);
+            r = new Response(signature, false, "Deadline expired.");
+        }
+        else {
+            Logger::debug("%1% -- Preparing response.", remote);
+            try {
+                unique_ptr<ServiceSkeleton> impl(ServiceSkeleton::factory().create(serviceId, std::move(arguments)));
+                impl->deadline = deadline;
+                r = impl->invoke();
+            }
+            catch (const std::exception& e) {
+                r = new Response(signature, false, string("Internal server error: ") + e.what());
+            }
+        }
+
+        if (computePool == NULL) {
+            sendResponse(r);
+            return;
+        }
+        // Send the response from the io_service. The response is owned by the helper right
+        // away, so that it is not leaked if the io_service is stopped in the meantime.
+        response.reset(r);
+        std::shared_ptr<ServiceSkeletonSerializationHelper> self(shared_from_this());
+        strand.post([self]() { self->sendResponse(self->response.release()); });
+    }
+
     void ServiceSkeletonSerializationHelper::sendResponse(Response * r)
     {
         if (r == NULL) {
             r = new Response(signature, false, "Internal server error: produced a NULL response.");
         }
         response.reset(r);
-        Logger::debug("%1% -- Sending response: %2%", socket->remote_endpoint(), response->getStatus());
+        response->setServiceId(handshake ? static_cast<long>(serviceId) : -1, epoch());
+        Logger::debug("%1% -- Sending response: %2%", remote, response->getStatus());
+        setTimer(microsec_clock::universal_time() + milliseconds(idleTimeout.load()));
         response->serialize(*socket.get(),
-                            boost::bind(&ServiceSkeletonSerializationHelper::onWriteResponse,
-                                        shared_from_this(),
-                                        boost::asio::placeholders::error));
+                            strand.wrap(boost::bind(&ServiceSkeletonSerializationHelper::onWriteResponse,
+                                                    shared_from_this(),
+                                                    boost::asio::placeholders::error)));
     }
 
     void ServiceSkeletonSerializationHelper::onWriteResponse(const error_code& e)
     {
+        // Release the helper right away, rather than when the timer expires.
+        timer.cancel();
+        if (timedOut) {
+            return;
+        }
         if (!e) {
             // Initiate graceful connection closure.
             error_code ignored_ec;
@@ -4,14 +4,136 @@
 
 #include <ssoa/service/servicestub.h>
 
+#include <map>
+#include <memory>
+#include <string>
+
 #include <boost/asio/connect.hpp>
+#include <boost/asio/deadline_timer.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/placeholders.hpp>
 #include <boost/asio/write.hpp>
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/lock_guard.hpp>
 
 using namespace boost::asio::ip;
+using boost::posix_time::microsec_clock;
+using boost::posix_time::milliseconds;
+using boost::posix_time::ptime;
+using boost::system::error_code;
+using std::string;
 
 namespace ssoa
 {
+    namespace
+    {
+        /// A socket whose synchronous operations fail with boost::asio::error::timed_out once
+        /// a deadline has expired. It supports the SyncReadStream and SyncWriteStream concepts,
+        /// so that it can be used with Response::deserialize().
+        class DeadlineSocket: private boost::noncopyable
+        {
+        public:
+            DeadlineSocket(boost::asio::io_service& ioService, ptime deadline) :
+                ioService(ioService), socket(ioService), timer(ioService), expired(false)
+            {
+                timer.expires_at(deadline);
+                timer.async_wait(boost::bind(&DeadlineSocket::onTimer, this, boost::asio::placeholders::error));
+            }
+
+            void connect(tcp::resolver::iterator endpoints) {
+                error_code ec = boost::asio::error::would_block;
+                boost::asio::async_connect(socket, endpoints,
+                                           [&ec](const error_code& e, tcp::resolver::iterator) { ec = e; });
+                wait(ec);
+                if (ec) {
+                    throw boost::system::system_error(ec);
+                }
+            }
+
+            template<typename MutableBufferSequence>
+            size_t read_some(const MutableBufferSequence& buffers, error_code& ec) {
+                ec = boost::asio::error::would_block;
+                size_t transferred = 0;
+                socket.async_read_some(buffers, [&](const error_code& e, size_t n) { ec = e; transferred = n; });
+                wait(ec);
+                return transferred;
+            }
+
+            template<typename MutableBufferSequence>
+            size_t read_some(const MutableBufferSequence& buffers) {
+                error_code ec;
+                size_t transferred = read_some(buffers, ec);
+                if (ec) {
+                    throw boost::system::system_error(ec);
+                }
+                return transferred;
+            }
+
+            template<typename ConstBufferSequence>
+            size_t write_some(const ConstBufferSequence& buffers, error_code& ec) {
+                ec = boost::asio::error::would_block;
+                size_t transferred = 0;
+                socket.async_write_some(buffers, [&](const error_code& e, size_t n) { ec = e; transferred = n; });
+                wait(ec);
+                return transferred;
+            }
+
+            template<typename ConstBufferSequence>
+            size_t write_some(const ConstBufferSequence& buffers) {
+                error_code ec;
+                size_t transferred = write_some(buffers, ec);
+                if (ec) {
+                    throw boost::system::system_error(ec);
+                }
+                return transferred;
+            }
+
+        private:
+            /// Runs the io_service until the pending operation sets @c ec.
+            void wait(error_code& ec) {
+                while (ec == boost::asio::error::would_block) {
+                    ioService.run_one();
+                }
+                if (ec && expired) {
+                    ec = boost::asio::error::timed_out;
+                }
+            }
+
+            void onTimer(const error_code& e) {
+                if (!e) {
+                    // Aborts the pending operation, and makes the next ones fail.
+                    expired = true;
+                    error_code ignored;
+                    socket.close(ignored);
+                }
+            }
+
+            boost::asio::io_service& ioService;
+            tcp::socket socket;
+            boost::asio::deadline_timer timer;
+            bool expired;
+        };
+
+        /// How a client identifies a service to a provider.
+        struct Binding
+        {
+            /// The fields of the request header identifying the service.
+            string headerTemplate;
+
+            /// The epoch of the provider which assigned the identifier of the service; 0 if the
+            /// service is identified by its signature.
+            unsigned long epoch;
+        };
+
+        /// The identifiers assigned to services by providers, keyed by provider address and
+        /// signature, obtained from the response to the first request sent to each provider.
+        boost::mutex bindingsMutex;
+        std::map<string, Binding> bindings;
+    }
+
     Response * ServiceStub::submit() const
     {
         boost::asio::io_service io_service;
@@ -19,11 +141,65 @@ namespace ssoa
         tcp::resolver resolver(io_service);
         tcp::resolver::query query(host, port);
 
-        tcp::socket socket(io_service);
-        boost::asio::connect(socket, resolver.resolve(query));
+        ptime deadline;
+        if (timeout > 0) {
+            deadline = microsec_clock::universal_time() + milliseconds(timeout);
+        }
+
+        auto exchange = [&](const string& headerTemplate) -> Response * {
+            if (deadline.is_not_a_date_time()) {
+                tcp::socket socket(io_service);
+                boost::asio::connect(socket, resolver.resolve(query));
+
+                boost::asio::write(socket, getConstBuffers(headerTemplate, 0));
+
+                return Response::deserialize(socket);
+            }
+
+            // Each exchange runs its own io_service: the handler of the timer of the socket may
+            // still be pending when the socket is destroyed, and must be discarded along with
+            // it rather than run by the next exchange.
+            boost::asio::io_service socketService;
+            DeadlineSocket socket(socketService, deadline);
+            socket.connect(resolver.resolve(query));
+
+            // Tell the provider how much time is left, after connecting.
+            long left = (deadline - microsec_clock::universal_time()).total_milliseconds();
+            boost::asio::write(socket, getConstBuffers(headerTemplate, left > 0 ? left : 1));
+
+            return Response::deserialize(socket);
+        };
+
+        string key = host + ":" + port + " " + static_cast<string>(getSignature());
+        Binding binding = { string(), 0 };
+        {
+            boost::lock_guard<boost::mutex> lock(bindingsMutex);
+            auto iter = bindings.find(key);
+            if (iter != bindings.end()) {
+                binding = iter->second;
+            }
+        }
+        if (binding.epoch == 0) {
+            binding.headerTemplate = headerTemplate(getSignature());
+        }
 
-        boost::asio::write(socket, getConstBuffers());
+        std::unique_ptr<Response> response(exchange(binding.headerTemplate));
+        if (binding.epoch != 0 && !response->isSuccessful() && response->getEpoch() != binding.epoch) {
+            // The provider has been restarted since the identifier was assigned, and rejected
+            // the request without processing it: send it again with the signature.
+            response.reset(exchange(headerTemplate(getSignature())));
+        }
 
-        return Response::deserialize(socket);
+        if (response->getServiceId() >= 0 && response->getEpoch() != 0) {
+            boost::lock_guard<boost::mutex> lock(bindingsMutex);
+            Binding& b = bindings[key];
+            b.headerTemplate = headerTemplate(response->getServiceId(), response->getEpoch());
+            b.epoch = response->getEpoch();
+        }
+        else if (binding.epoch != 0 && response->getEpoch() != binding.epoch) {
+            boost::lock_guard<boost::mutex> lock(bindingsMutex);
+            bindings.erase(key);
+        }
+        return response.release();
     }
 }
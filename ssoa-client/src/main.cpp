@@ -10,6 +10,7 @@
 #include <imagemanipulationprovider/rotateimageservice.h>
 #include <imagemanipulationprovider/horizontalflipimageservice.h>
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <fstream>
@@ -114,6 +115,7 @@ bool readRandomFileFromStorageProvider(string& name, vector<byte>& buffer)
 int main(int argc, char *argv[])
 {
     string registryAddress, registryPort;
+    int timeout;
 
     po::options_description description("Allowed options");
     description.add_options()
@@ -124,6 +126,8 @@ int main(int argc, char *argv[])
             "Specifies the port of the registry")
         ("image-folder,f", po::value<string>(&imageFolder),
             "Specifies the folder containing images")
+        ("timeout,t", po::value<int>(&timeout)->default_value(60),
+            "Specifies how long a service may take to answer, in seconds (0 waits forever)")
         ("log-marker,l", po::value<string>(&Logger::marker),
             "Specifies a string printed at the beginning of every log message");
 
@@ -154,6 +158,7 @@ int main(int argc, char *argv[])
     }
 
     srand(time(NULL));
+    ServiceStub::setDefaultTimeout(std::max(0, timeout) * 1000L);
 
     ssoa::setup();
     Registry::initialize(registryAddress, registryPort);
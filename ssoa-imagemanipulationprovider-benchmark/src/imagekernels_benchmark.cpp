@@ -0,0 +1,61 @@
+#include <bandpool.h>
+#include <imagekernels.h>
+
+#include <ssoa/benchmark.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/thread.hpp>
+
+using namespace imagemanipulationprovider;
+
+namespace
+{
+    /// Runs the BandPool while it exists.
+    struct BandPoolScope: private boost::noncopyable
+    {
+        explicit BandPoolScope(std::size_t threads) {
+            BandPool::initialize(threads);
+        }
+
+        ~BandPoolScope() {
+            BandPool::shutdown();
+        }
+    };
+
+    /// Measures the throughput of an operation, in megapixels (of the input) per second.
+    template<typename F>
+    double measure(const Image& input, F operation)
+    {
+        return ssoa::benchmark::measure(5, operation) * input.width * input.height / 1e6;
+    }
+}
+
+int main()
+{
+    static const char * names[] = { "scalar", "SSSE3", "AVX2" };
+
+    Image input(2048, 1536, 3), output;
+    for (auto& sample : input.pixels) {
+        sample = std::rand() % 256;
+    }
+
+    ImageKernels::InstructionSet original = ImageKernels::getInstructionSet();
+    for (int i = ImageKernels::SCALAR; i <= ImageKernels::getSupportedInstructionSet(); i++) {
+        ImageKernels::setInstructionSet(static_cast<ImageKernels::InstructionSet>(i));
+        double mirror = measure(input, [&]() { ImageKernels::mirrorX(input, output); });
+        double rotate = measure(input, [&]() { ImageKernels::rotate(input, output, 30); });
+        std::cout << "Kernels " << names[i] << ": mirror " << mirror << " MP/s, rotate(30) "
+                  << rotate << " MP/s" << std::endl;
+    }
+    ImageKernels::setInstructionSet(original);
+
+    BandPoolScope bandPool(std::max(1u, boost::thread::hardware_concurrency()) - 1);
+    double rotate = measure(input, [&]() { ImageKernels::rotate(input, output, 30); });
+    std::cout << "Kernels with " << BandPool::size() + 1 << " threads: rotate(30) "
+              << rotate << " MP/s" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,114 @@
+#include <admissioncontroller.h>
+#include <imagepipeline.h>
+#include <jpegcodec.h>
+
+#include <memory>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+using namespace imagemanipulationprovider;
+
+typedef AdmissionController::Ticket Ticket;
+
+/// Waits until the given number of operations had to wait since the beginning of the test.
+static void waitForWaiting(uint64_t base, uint64_t count)
+{
+    for (int i = 0; i < 1000 && AdmissionController::getStatistics().waited < base + count; i++) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(5));
+    }
+    BOOST_REQUIRE_EQUAL(AdmissionController::getStatistics().waited, base + count);
+}
+
+BOOST_AUTO_TEST_SUITE(admissioncontroller)
+
+    BOOST_AUTO_TEST_CASE( estimate_test )
+    {
+        std::vector<unsigned char> jpeg;
+        JpegCodec::encode(Image(40, 30, 3), jpeg);
+        BOOST_CHECK_EQUAL(AdmissionController::estimateCost(jpeg), 3 * 40 * 30 * 3);
+        BOOST_CHECK_EQUAL(AdmissionController::estimateCost(std::vector<unsigned char>(10)), 0);
+
+        // Pipelines count their largest image.
+        BOOST_CHECK_EQUAL(AdmissionController::estimateCost(jpeg, ImagePipeline("scale 80 60; scale 20 10")),
+                          3 * 80 * 60 * 3);
+        BOOST_CHECK_THROW(AdmissionController::estimateCost(jpeg, ImagePipeline("scale 9000 9000; rotate 30")),
+                          std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_CASE( priority_test )
+    {
+        AdmissionController::initialize(100, 2, 2);
+        const AdmissionController::Statistics before = AdmissionController::getStatistics();
+
+        boost::mutex mutex;
+        std::vector<int> order;
+        auto admit = [&](std::size_t cost) {
+            Ticket ticket(cost);
+            boost::lock_guard<boost::mutex> lock(mutex);
+            order.push_back(cost);
+        };
+
+        std::unique_ptr<Ticket> large(new Ticket(60));
+        std::unique_ptr<Ticket> medium(new Ticket(30));
+
+        // Both wait: only two operations may run at the same time.
+        boost::thread waitingLarge(admit, 50);
+        waitForWaiting(before.waited, 1);
+        boost::thread waitingSmall(admit, 10);
+        waitForWaiting(before.waited, 2);
+
+        // The queue is full.
+        BOOST_CHECK_THROW(Ticket(1), AdmissionController::BusyError);
+
+        // The small operation goes first, then the large one fits as well.
+        large.reset();
+        waitingSmall.join();
+        medium.reset();
+        waitingLarge.join();
+        BOOST_REQUIRE_EQUAL(order.size(), 2);
+        BOOST_CHECK_EQUAL(order[0], 10);
+        BOOST_CHECK_EQUAL(order[1], 50);
+
+        // Operations as large as the budget run alone.
+        {
+            Ticket whole(100);
+        }
+
+        const AdmissionController::Statistics after = AdmissionController::getStatistics();
+        BOOST_CHECK_EQUAL(after.admitted - before.admitted, 5);
+        BOOST_CHECK_EQUAL(after.rejected - before.rejected, 1);
+        AdmissionController::initialize(SIZE_MAX, SIZE_MAX, SIZE_MAX);
+    }
+
+    BOOST_AUTO_TEST_CASE( too_large_test )
+    {
+        AdmissionController::initialize(100, 2, 2);
+        const AdmissionController::Statistics before = AdmissionController::getStatistics();
+
+        // Rejected right away, even when nothing else runs.
+        BOOST_CHECK_THROW(Ticket(101), AdmissionController::TooLargeError);
+
+        // A small image whose header claims the largest size a JPEG may have.
+        std::vector<unsigned char> jpeg;
+        JpegCodec::encode(Image(8, 8, 3), jpeg);
+        for (std::size_t i = 0; i + 8 < jpeg.size(); i++) {
+            if (jpeg[i] == 0xFF && jpeg[i + 1] == 0xC0) {
+                // SOF0: marker, length, precision, height, width.
+                jpeg[i + 5] = jpeg[i + 7] = 0xFF;
+                jpeg[i + 6] = jpeg[i + 8] = 0xDC;
+                break;
+            }
+        }
+        AdmissionController::initialize(std::size_t(1) << 30, 2, 2);
+        BOOST_CHECK_THROW(Ticket(AdmissionController::estimateCost(jpeg)), AdmissionController::TooLargeError);
+
+        const AdmissionController::Statistics after = AdmissionController::getStatistics();
+        BOOST_CHECK_EQUAL(after.admitted - before.admitted, 0);
+        BOOST_CHECK_EQUAL(after.rejected - before.rejected, 2);
+        AdmissionController::initialize(SIZE_MAX, SIZE_MAX, SIZE_MAX);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
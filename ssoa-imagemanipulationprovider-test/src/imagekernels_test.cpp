@@ -0,0 +1,268 @@
+#define BOOST_TEST_MODULE imagekernels_test
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+
+#include <bandpool.h>
+#include <imagekernels.h>
+#include <jpegcodec.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+// CImg is only used as the reference implementation.
+#define cimg_display 0
+#include <CImg.h>
+
+using namespace imagemanipulationprovider;
+using cimg_library::CImg;
+using std::vector;
+
+typedef unsigned char byte;
+
+/// Creates an image filled with pseudo-random samples.
+static Image randomImage(int width, int height, int channels)
+{
+    Image image(width, height, channels);
+    std::srand(width * 1000 + height * 10 + channels);
+    for (auto& sample : image.pixels) {
+        sample = std::rand() % 256;
+    }
+    return image;
+}
+
+static CImg<float> toCImg(const Image& image)
+{
+    CImg<float> result(image.width, image.height, 1, image.channels);
+    for (int y = 0; y < image.height; y++) {
+        for (int x = 0; x < image.width; x++) {
+            for (int c = 0; c < image.channels; c++) {
+                result(x, y, 0, c) = image.pixels[(y * image.width + x) * image.channels + c];
+            }
+        }
+    }
+    return result;
+}
+
+/// Checks that an image is equal to a CImg one, converted as CImg::save_jpeg() does.
+static void checkEqual(const Image& image, const CImg<float>& expected)
+{
+    BOOST_REQUIRE_EQUAL(image.width, expected.width());
+    BOOST_REQUIRE_EQUAL(image.height, expected.height());
+    BOOST_REQUIRE_EQUAL(image.channels, expected.spectrum());
+
+    int mismatches = 0;
+    for (int y = 0; y < image.height; y++) {
+        for (int x = 0; x < image.width; x++) {
+            for (int c = 0; c < image.channels; c++) {
+                float value = expected(x, y, 0, c);
+                byte reference = static_cast<byte>(value < 0 ? 0 : value > 255 ? 255 : value);
+                if (image.pixels[(y * image.width + x) * image.channels + c] != reference) {
+                    mismatches++;
+                }
+            }
+        }
+    }
+    BOOST_CHECK_EQUAL(mismatches, 0);
+}
+
+/// Runs a test with the kernels of each instruction set supported by the CPU.
+template<typename F>
+static void forEachInstructionSet(F test)
+{
+    ImageKernels::InstructionSet original = ImageKernels::getInstructionSet();
+    for (int i = ImageKernels::SCALAR; i <= ImageKernels::getSupportedInstructionSet(); i++) {
+        ImageKernels::setInstructionSet(static_cast<ImageKernels::InstructionSet>(i));
+        BOOST_TEST_CHECKPOINT("Instruction set " << i);
+        test();
+    }
+    ImageKernels::setInstructionSet(original);
+}
+
+BOOST_AUTO_TEST_SUITE(imagekernels)
+
+    BOOST_AUTO_TEST_CASE( mirror_test )
+    {
+        forEachInstructionSet([]() {
+            for (int channels : { 1, 3 }) {
+                for (int width : { 1, 5, 6, 16, 31, 33, 100 }) {
+                    Image input = randomImage(width, 7, channels), output;
+                    ImageKernels::mirrorX(input, output);
+                    checkEqual(output, toCImg(input).get_mirror('x'));
+                }
+            }
+        });
+    }
+
+    BOOST_AUTO_TEST_CASE( rotate_test )
+    {
+        forEachInstructionSet([]() {
+            for (int channels : { 1, 3 }) {
+                for (float angle : { 0.0f, 90.0f, 180.0f, -90.0f, 450.0f, 30.0f, -17.5f, 200.0f }) {
+                    Image input = randomImage(67, 45, channels), output;
+                    ImageKernels::rotate(input, output, angle);
+                    checkEqual(output, toCImg(input).get_rotate(angle));
+                }
+            }
+        });
+    }
+
+    BOOST_AUTO_TEST_CASE( small_rotate_test )
+    {
+        forEachInstructionSet([]() {
+            for (int size : { 1, 2, 9 }) {
+                Image input = randomImage(size, 3, 3), output;
+                ImageKernels::rotate(input, output, 45);
+                checkEqual(output, toCImg(input).get_rotate(45));
+            }
+        });
+    }
+
+    BOOST_AUTO_TEST_CASE( parallel_test )
+    {
+        Image input = randomImage(1031, 769, 3), mirrored, rotated, rotated90;
+        ImageKernels::mirrorX(input, mirrored);
+        ImageKernels::rotate(input, rotated, 30);
+        ImageKernels::rotate(input, rotated90, 90);
+
+        BandPool::initialize(3);
+        Image output;
+        ImageKernels::mirrorX(input, output);
+        BOOST_CHECK(output.pixels == mirrored.pixels);
+        ImageKernels::rotate(input, output, 30);
+        BOOST_CHECK(output.pixels == rotated.pixels);
+        ImageKernels::rotate(input, output, 90);
+        BOOST_CHECK(output.pixels == rotated90.pixels);
+
+        BOOST_CHECK_THROW(BandPool::run(10, [](int band) {
+            if (band == 7) {
+                throw std::runtime_error("Band failed.");
+            }
+        }), std::runtime_error);
+        BandPool::shutdown();
+    }
+
+    BOOST_AUTO_TEST_CASE( instruction_set_test )
+    {
+        BOOST_CHECK_LE(ImageKernels::getInstructionSet(), ImageKernels::getSupportedInstructionSet());
+        if (ImageKernels::getSupportedInstructionSet() < ImageKernels::AVX2) {
+            BOOST_CHECK_THROW(ImageKernels::setInstructionSet(ImageKernels::AVX2), std::runtime_error);
+        }
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(jpegcodec)
+
+    BOOST_AUTO_TEST_CASE( roundtrip_test )
+    {
+        Image input(40, 24, 3), output;
+        for (size_t i = 0; i < input.pixels.size(); i++) {
+            input.pixels[i] = (i / 3) % 40 * 6;
+        }
+        vector<byte> jpeg;
+        JpegCodec::encode(input, jpeg);
+        JpegCodec::decode(jpeg, output);
+
+        BOOST_REQUIRE_EQUAL(output.width, 40);
+        BOOST_REQUIRE_EQUAL(output.height, 24);
+        BOOST_REQUIRE_EQUAL(output.channels, 3);
+        for (size_t i = 0; i < input.pixels.size(); i++) {
+            BOOST_REQUIRE_LE(std::abs(input.pixels[i] - output.pixels[i]), 8);
+        }
+
+        jpeg.resize(10);
+        BOOST_CHECK_THROW(JpegCodec::decode(jpeg, output), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_CASE( oversized_test )
+    {
+        // A small image whose header claims 65500x65500 pixels.
+        vector<byte> jpeg;
+        JpegCodec::encode(Image(8, 8, 3), jpeg);
+        for (size_t i = 0; i + 8 < jpeg.size(); i++) {
+            if (jpeg[i] == 0xFF && jpeg[i + 1] == 0xC0) {
+                // SOF0: marker, length, precision, height, width.
+                jpeg[i + 5] = jpeg[i + 7] = 0xFF;
+                jpeg[i + 6] = jpeg[i + 8] = 0xDC;
+                break;
+            }
+        }
+        int width, height, channels;
+        JpegCodec::readSize(jpeg, width, height, channels);
+        BOOST_REQUIRE_EQUAL(width, 65500);
+
+        // Rejected before allocating, unless decoded at a scale within the limit.
+        Image output;
+        BOOST_CHECK_THROW(JpegCodec::decode(jpeg, output), std::runtime_error);
+        BOOST_CHECK(output.pixels.empty());
+        BOOST_CHECK_THROW(JpegCodec::decode(jpeg, output, 20000), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_CASE( encode_profile_test )
+    {
+        Image input = randomImage(64, 48, 3), output;
+        for (size_t i = 0; i < input.pixels.size(); i++) {
+            input.pixels[i] = input.pixels[i] / 8 + (i / 3) % 64 * 3;
+        }
+
+        EncodeProfile profile;
+        profile.optimize = false;
+        vector<byte> plain, optimized, lowQuality, full, progressive, transformed;
+        JpegCodec::encode(input, plain, profile);
+        profile.optimize = true;
+        JpegCodec::encode(input, optimized, profile);
+        BOOST_CHECK_LT(optimized.size(), plain.size());
+
+        profile.quality = 50;
+        JpegCodec::encode(input, lowQuality, profile);
+        BOOST_CHECK_LT(lowQuality.size(), optimized.size());
+
+        profile.quality = 90;
+        profile.subsampling = EncodeProfile::SUBSAMPLING_444;
+        JpegCodec::encode(input, full, profile);
+        BOOST_CHECK_GT(full.size(), optimized.size());
+
+        profile.progressive = true;
+        JpegCodec::encode(input, progressive, profile);
+        JpegCodec::decode(progressive, output);
+        BOOST_CHECK_EQUAL(output.width, 64);
+        BOOST_CHECK_EQUAL(output.height, 48);
+
+        JpegCodec::Statistics before = JpegCodec::getStatistics();
+        BOOST_REQUIRE(JpegCodec::transform(plain, transformed, JpegCodec::ROTATE_180, profile));
+        BOOST_CHECK_LT(transformed.size(), plain.size());
+        JpegCodec::decode(transformed, output);
+        BOOST_CHECK_EQUAL(output.width, 64);
+        JpegCodec::Statistics after = JpegCodec::getStatistics();
+        BOOST_CHECK_EQUAL(after.transforms - before.transforms, 1);
+        BOOST_CHECK_EQUAL(after.outputBytes - before.outputBytes, transformed.size());
+    }
+
+    BOOST_AUTO_TEST_CASE( lossless_transform_test )
+    {
+        Image input = randomImage(32, 16, 3), decoded, expected, output;
+        vector<byte> jpeg, transformed;
+        JpegCodec::encode(input, jpeg);
+        JpegCodec::decode(jpeg, decoded);
+
+        BOOST_REQUIRE(JpegCodec::transform(jpeg, transformed, JpegCodec::ROTATE_90));
+        JpegCodec::decode(transformed, output);
+        ImageKernels::rotate(decoded, expected, 90);
+        BOOST_REQUIRE_EQUAL(output.width, expected.width);
+        BOOST_REQUIRE_EQUAL(output.height, expected.height);
+
+        // Only chroma upsampling may differ after the transformation.
+        int maxDifference = 0;
+        for (size_t i = 0; i < output.pixels.size(); i++) {
+            maxDifference = std::max(maxDifference, std::abs(output.pixels[i] - expected.pixels[i]));
+        }
+        BOOST_CHECK_LE(maxDifference, 16);
+
+        // Not a multiple of the MCU size.
+        JpegCodec::encode(randomImage(30, 16, 3), jpeg);
+        BOOST_CHECK(!JpegCodec::transform(jpeg, transformed, JpegCodec::FLIP_HORIZONTAL));
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,143 @@
+#include <imagehelper.h>
+#include <imagekernels.h>
+#include <imagepipeline.h>
+#include <jpegcodec.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace imagemanipulationprovider;
+using std::vector;
+
+typedef unsigned char byte;
+
+/// Creates a smooth RGB image, which survives JPEG compression almost unchanged.
+static Image gradientImage(int width, int height)
+{
+    Image image(width, height, 3);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            byte *pixel = image.pixels.data() + (y * width + x) * 3;
+            pixel[0] = x * 255 / width;
+            pixel[1] = y * 255 / height;
+            pixel[2] = 128;
+        }
+    }
+    return image;
+}
+
+BOOST_AUTO_TEST_SUITE(imagepipeline)
+
+    BOOST_AUTO_TEST_CASE( resize_test )
+    {
+        Image input(4, 2, 1), output;
+        input.pixels = { 0, 100, 200, 250, 50, 150, 250, 0 };
+
+        ImageKernels::resize(input, output, 2, 1);
+        BOOST_REQUIRE_EQUAL(output.width, 2);
+        BOOST_REQUIRE_EQUAL(output.height, 1);
+        BOOST_CHECK_EQUAL(output.pixels[0], 75);
+        BOOST_CHECK_EQUAL(output.pixels[1], 175);
+
+        ImageKernels::resize(input, output, 8, 2);
+        BOOST_REQUIRE_EQUAL(output.width, 8);
+        BOOST_CHECK_EQUAL(output.pixels[0], 0);
+        BOOST_CHECK_EQUAL(output.pixels[1], 25);
+        BOOST_CHECK_EQUAL(output.pixels[2], 75);
+        BOOST_CHECK_EQUAL(output.pixels[7], 250);
+
+        BOOST_CHECK_THROW(ImageKernels::resize(input, output, 0, 1), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_CASE( crop_test )
+    {
+        Image input = gradientImage(10, 8), output;
+        ImageKernels::crop(input, output, 2, 3, 4, 5);
+        BOOST_REQUIRE_EQUAL(output.width, 4);
+        BOOST_REQUIRE_EQUAL(output.height, 5);
+        for (int y = 0; y < 5; y++) {
+            for (int x = 0; x < 4; x++) {
+                for (int c = 0; c < 3; c++) {
+                    BOOST_CHECK_EQUAL(output.pixels[(y * 4 + x) * 3 + c],
+                                      input.pixels[((y + 3) * 10 + x + 2) * 3 + c]);
+                }
+            }
+        }
+        BOOST_CHECK_THROW(ImageKernels::crop(input, output, 7, 0, 4, 5), std::runtime_error);
+        BOOST_CHECK_THROW(ImageKernels::crop(input, output, -1, 0, 4, 5), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_CASE( parse_test )
+    {
+        BOOST_CHECK_NO_THROW(ImagePipeline("rotate 90; flip;scale 10 20 ; crop 0 0 1 1;"));
+        BOOST_CHECK_NO_THROW(ImagePipeline(""));
+        BOOST_CHECK_THROW(ImagePipeline("shear 10"), std::runtime_error);
+        BOOST_CHECK_THROW(ImagePipeline("rotate"), std::runtime_error);
+        BOOST_CHECK_THROW(ImagePipeline("flip 1"), std::runtime_error);
+        BOOST_CHECK_THROW(ImagePipeline("crop 0 0 x 1"), std::runtime_error);
+
+        // The results are limited in size.
+        BOOST_CHECK_THROW(ImagePipeline("scale 60000 60000"), std::runtime_error);
+        BOOST_CHECK_THROW(ImagePipeline("scale 70000 10"), std::runtime_error);
+        BOOST_CHECK_THROW(ImagePipeline("crop 0 0 10 70000"), std::runtime_error);
+        BOOST_CHECK_NO_THROW(ImagePipeline("scale 10000 10000"));
+    }
+
+    BOOST_AUTO_TEST_CASE( largest_image_test )
+    {
+        BOOST_CHECK_EQUAL(ImagePipeline("").getLargestImage(40, 30), 1200);
+        BOOST_CHECK_EQUAL(ImagePipeline("scale 80 60; crop 0 0 10 10; flip").getLargestImage(40, 30), 4800);
+        BOOST_CHECK_EQUAL(ImagePipeline("rotate 90; scale 20 10").getLargestImage(40, 30), 1200);
+
+        // Rotations by other angles enlarge the image, up to beyond the limits.
+        BOOST_CHECK(ImagePipeline("rotate 45").getLargestImage(40, 30) > 1200);
+        BOOST_CHECK_THROW(ImagePipeline("scale 10000 10000; rotate 45").getLargestImage(40, 30), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_CASE( apply_test )
+    {
+        vector<byte> jpeg, output, expected;
+        JpegCodec::encode(gradientImage(64, 48), jpeg);
+
+        // Compositions of flips and right angles are lossless, and equal to the composed transform.
+        ImagePipeline("flip; rotate 90; flip").apply(jpeg, output);
+        JpegCodec::transform(jpeg, expected, JpegCodec::ROTATE_270);
+        BOOST_CHECK(output == expected);
+        ImagePipeline("rotate 180; rotate -90; rotate 270").apply(jpeg, output);
+        BOOST_CHECK(output == jpeg);
+
+        Image image;
+        ImagePipeline("crop 8 0 40 48; scale 20 12; rotate 90").apply(jpeg, output);
+        JpegCodec::decode(output, image);
+        BOOST_CHECK_EQUAL(image.width, 12);
+        BOOST_CHECK_EQUAL(image.height, 20);
+
+        BOOST_CHECK_THROW(ImagePipeline("crop 0 0 100 100").apply(jpeg, output), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_CASE( thumbnail_test )
+    {
+        vector<byte> jpeg, output;
+        Image image;
+        JpegCodec::encode(gradientImage(640, 480), jpeg);
+
+        // Decoded at 1/4, as 160x120.
+        JpegCodec::decode(jpeg, image, 100);
+        BOOST_CHECK_EQUAL(image.width, 160);
+        BOOST_CHECK_EQUAL(image.height, 120);
+
+        ImageHelper::thumbnail(jpeg, output, 100);
+        JpegCodec::decode(output, image);
+        BOOST_CHECK_EQUAL(image.width, 100);
+        BOOST_CHECK_EQUAL(image.height, 75);
+        // Still a gradient from left to right.
+        BOOST_CHECK_LT(std::abs(image.pixels[(37 * 100 + 50) * 3] - 128), 8);
+
+        ImageHelper::thumbnail(jpeg, output, 1000);
+        BOOST_CHECK(output == jpeg);
+        BOOST_CHECK_THROW(ImageHelper::thumbnail(jpeg, output, 0), std::runtime_error);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
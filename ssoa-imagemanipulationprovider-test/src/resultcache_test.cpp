@@ -0,0 +1,78 @@
+#include <imagehelper.h>
+#include <jpegcodec.h>
+#include <resultcache.h>
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace imagemanipulationprovider;
+using std::vector;
+
+typedef unsigned char byte;
+
+BOOST_AUTO_TEST_SUITE(resultcache)
+
+    BOOST_AUTO_TEST_CASE( lru_test )
+    {
+        ResultCache::initialize(4000);
+        ResultCache::Statistics before = ResultCache::getStatistics();
+
+        vector<byte> a(10, 'a'), b(10, 'b'), output;
+        const std::string keyA = ResultCache::makeKey(a, "flip");
+        BOOST_CHECK_EQUAL(keyA, ResultCache::makeKey(vector<byte>(10, 'a'), "flip"));
+        BOOST_CHECK_NE(keyA, ResultCache::makeKey(a, "rotate 90"));
+        BOOST_CHECK_NE(keyA, ResultCache::makeKey(b, "flip"));
+
+        BOOST_CHECK(!ResultCache::lookup(keyA, output));
+        ResultCache::store(keyA, vector<byte>(900, 1));
+        BOOST_CHECK(ResultCache::lookup(keyA, output));
+        BOOST_CHECK(output == vector<byte>(900, 1));
+
+        // Too large for the cache.
+        const std::string keyB = ResultCache::makeKey(b, "flip");
+        ResultCache::store(keyB, vector<byte>(1001, 2));
+        BOOST_CHECK(!ResultCache::lookup(keyB, output));
+
+        // Fill the cache, using the first entry so that it is not the least recently used one.
+        for (int i = 0; i < 3; i++) {
+            ResultCache::store(ResultCache::makeKey(b, std::to_string(i)), vector<byte>(900, 3));
+        }
+        BOOST_CHECK(ResultCache::lookup(keyA, output));
+        ResultCache::store(keyB, vector<byte>(900, 2));
+        BOOST_CHECK(ResultCache::lookup(keyA, output));
+        BOOST_CHECK(ResultCache::lookup(keyB, output));
+        BOOST_CHECK(!ResultCache::lookup(ResultCache::makeKey(b, "0"), output));
+
+        ResultCache::Statistics after = ResultCache::getStatistics();
+        BOOST_CHECK_EQUAL(after.hits - before.hits, 4);
+        BOOST_CHECK_EQUAL(after.misses - before.misses, 3);
+        BOOST_CHECK_EQUAL(after.evictions - before.evictions, 1);
+        BOOST_CHECK_LE(after.bytes, 4000);
+
+        ResultCache::initialize(0);
+    }
+
+    BOOST_AUTO_TEST_CASE( helper_test )
+    {
+        Image image(32, 16, 3);
+        vector<byte> input, first, second;
+        JpegCodec::encode(image, input);
+
+        ResultCache::initialize(1 << 20);
+        ResultCache::Statistics before = ResultCache::getStatistics();
+        ImageHelper::rotate(input, first, 30);
+        ImageHelper::rotate(input, second, -330);
+        BOOST_CHECK(first == second);
+        ResultCache::Statistics after = ResultCache::getStatistics();
+        BOOST_CHECK_EQUAL(after.hits - before.hits, 1);
+        BOOST_CHECK_EQUAL(after.misses - before.misses, 1);
+
+        ImageHelper::transform(ImagePipeline("flip;rotate 30"), input, first);
+        ImageHelper::transform(ImagePipeline(" flip ; rotate  30 ;"), input, second);
+        BOOST_CHECK(first == second);
+        BOOST_CHECK_EQUAL(ResultCache::getStatistics().hits - after.hits, 1);
+        ResultCache::initialize(0);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
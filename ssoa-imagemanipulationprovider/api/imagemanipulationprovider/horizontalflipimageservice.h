@@ -5,12 +5,23 @@
 #ifndef _HORIZONTALFLIPIMAGESERVICE_H_
 #define _HORIZONTALFLIPIMAGESERVICE_H_
 
-#include <ssoa/service/servicestub.h>
+#include <ssoa/service/typedservicestub.h>
 
 namespace imagemanipulationprovider
 {
+    /// The name of the "HorizontalFlipImage" service.
+    struct HorizontalFlipImageName {
+        static const char * name() {
+            return "HorizontalFlipImage";
+        }
+    };
+
+    /// The signature of the "HorizontalFlipImage" service.
+    typedef ssoa::Signature<HorizontalFlipImageName,
+                            ssoa::In<ssoa::Buffer>, ssoa::Out<ssoa::Buffer>> HorizontalFlipImageSignature;
+
     /// Represents a service which flips horizontally an image.
-    class HorizontalFlipImageService: public ssoa::ServiceStub
+    class HorizontalFlipImageService: public ssoa::TypedServiceStub<HorizontalFlipImageSignature>
     {
         /// Just a shortcut.
         typedef unsigned char byte;
@@ -21,15 +32,10 @@ namespace imagemanipulationprovider
         /// @param host The remote host of the service provider.
         /// @param port The remote port on which the service is provided.
         HorizontalFlipImageService(std::string host, std::string port) :
-            ssoa::ServiceStub(ssoa::ServiceSignature(serviceSignature()), host, port)
+            ssoa::TypedServiceStub<HorizontalFlipImageSignature>(std::move(host), std::move(port))
         {
         }
 
-        /// Gets the signature of this type of service.
-        static const char * serviceSignature() {
-            return "HorizontalFlipImage(in buffer, out buffer)";
-        }
-
         /// Gets a string representing the status of the operation.
         const std::string& getStatus() const {
             return status;
@@ -40,15 +46,9 @@ namespace imagemanipulationprovider
         /// @param input The input buffer containing the image data.
         /// @param output The output buffer that will contain the flipped image.
         bool invoke(const std::vector<byte>& input, std::vector<byte>& output) {
-            using namespace std;
-            using namespace ssoa;
-
-            pushArgument(new ServiceBufferArgument(input));
-
-            unique_ptr<Response> response(ServiceStub::submit());
+            std::unique_ptr<ssoa::Response> response(call(input));
             if (response->isSuccessful()) {
-                unique_ptr<ServiceBufferArgument> arg(response->popArgument<ServiceBufferArgument>());
-                output = std::move(arg->getValue());
+                output = std::move(outputArgument<0>(*response).getValue());
             }
             status = response->getStatus();
             return response->isSuccessful();
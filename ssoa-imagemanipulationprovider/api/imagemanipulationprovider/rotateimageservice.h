@@ -5,12 +5,23 @@
 #ifndef _ROTATEIMAGESERVICE_H_
 #define _ROTATEIMAGESERVICE_H_
 
-#include <ssoa/service/servicestub.h>
+#include <ssoa/service/typedservicestub.h>
 
 namespace imagemanipulationprovider
 {
+    /// The name of the "RotateImage" service.
+    struct RotateImageName {
+        static const char * name() {
+            return "RotateImage";
+        }
+    };
+
+    /// The signature of the "RotateImage" service.
+    typedef ssoa::Signature<RotateImageName,
+                            ssoa::In<int>, ssoa::In<ssoa::Buffer>, ssoa::Out<ssoa::Buffer>> RotateImageSignature;
+
     /// Represents a service which rotates an image.
-    class RotateImageService: public ssoa::ServiceStub
+    class RotateImageService: public ssoa::TypedServiceStub<RotateImageSignature>
     {
         /// Just a shortcut.
         typedef unsigned char byte;
@@ -21,15 +32,10 @@ namespace imagemanipulationprovider
         /// @param host The remote host of the service provider.
         /// @param port The remote port on which the service is provided.
         RotateImageService(std::string host, std::string port) :
-            ssoa::ServiceStub(ssoa::ServiceSignature(serviceSignature()), host, port)
+            ssoa::TypedServiceStub<RotateImageSignature>(std::move(host), std::move(port))
         {
         }
 
-        /// Gets the signature of this type of service.
-        static const char * serviceSignature() {
-            return "RotateImage(in int, in buffer, out buffer)";
-        }
-
         /// Gets a string representing the status of the operation.
         const std::string& getStatus() const {
             return status;
@@ -41,16 +47,9 @@ namespace imagemanipulationprovider
         /// @param input The input buffer containing the image data.
         /// @param output The output buffer that will contain the rotated image.
         bool invoke(int degrees, const std::vector<byte>& input, std::vector<byte>& output) {
-            using namespace std;
-            using namespace ssoa;
-
-            pushArgument(new ServiceIntArgument(degrees));
-            pushArgument(new ServiceBufferArgument(input));
-
-            unique_ptr<Response> response(ServiceStub::submit());
+            std::unique_ptr<ssoa::Response> response(call(degrees, input));
             if (response->isSuccessful()) {
-                unique_ptr<ServiceBufferArgument> arg(response->popArgument<ServiceBufferArgument>());
-                output = std::move(arg->getValue());
+                output = std::move(outputArgument<0>(*response).getValue());
             }
             status = response->getStatus();
             return response->isSuccessful();
@@ -0,0 +1,63 @@
+/*
+ * thumbnailservice.h
+ */
+
+#ifndef _THUMBNAILSERVICE_H_
+#define _THUMBNAILSERVICE_H_
+
+#include <ssoa/service/typedservicestub.h>
+
+namespace imagemanipulationprovider
+{
+    /// The name of the "Thumbnail" service.
+    struct ThumbnailName {
+        static const char * name() {
+            return "Thumbnail";
+        }
+    };
+
+    /// The signature of the "Thumbnail" service.
+    typedef ssoa::Signature<ThumbnailName,
+                            ssoa::In<int>, ssoa::In<ssoa::Buffer>, ssoa::Out<ssoa::Buffer>> ThumbnailSignature;
+
+    /// Represents a service which produces a reduced version of an image, e.g. for previews.
+    class ThumbnailService: public ssoa::TypedServiceStub<ThumbnailSignature>
+    {
+        /// Just a shortcut.
+        typedef unsigned char byte;
+
+    public:
+        /// Constructs a new instance of ThumbnailService.
+        ///
+        /// @param host The remote host of the service provider.
+        /// @param port The remote port on which the service is provided.
+        ThumbnailService(std::string host, std::string port) :
+            ssoa::TypedServiceStub<ThumbnailSignature>(std::move(host), std::move(port))
+        {
+        }
+
+        /// Gets a string representing the status of the operation.
+        const std::string& getStatus() const {
+            return status;
+        }
+
+        /// Executes the service request, that is, shrinks the given image.
+        ///
+        /// @param maxSize The maximum length of the larger side of the thumbnail, in pixels.
+        /// @param input The input buffer containing the image data.
+        /// @param output The output buffer that will contain the thumbnail.
+        bool invoke(int maxSize, const std::vector<byte>& input, std::vector<byte>& output) {
+            std::unique_ptr<ssoa::Response> response(call(maxSize, input));
+            if (response->isSuccessful()) {
+                output = std::move(outputArgument<0>(*response).getValue());
+            }
+            status = response->getStatus();
+            return response->isSuccessful();
+        }
+
+    private:
+        std::string status;
+    };
+}
+
+#endif
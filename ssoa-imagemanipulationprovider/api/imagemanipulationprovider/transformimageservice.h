@@ -0,0 +1,66 @@
+/*
+ * transformimageservice.h
+ */
+
+#ifndef _TRANSFORMIMAGESERVICE_H_
+#define _TRANSFORMIMAGESERVICE_H_
+
+#include <ssoa/service/typedservicestub.h>
+
+namespace imagemanipulationprovider
+{
+    /// The name of the "TransformImage" service.
+    struct TransformImageName {
+        static const char * name() {
+            return "TransformImage";
+        }
+    };
+
+    /// The signature of the "TransformImage" service.
+    typedef ssoa::Signature<TransformImageName,
+                            ssoa::In<std::string>, ssoa::In<ssoa::Buffer>, ssoa::Out<ssoa::Buffer>> TransformImageSignature;
+
+    /// Represents a service which applies a list of operations to an image, decoding and
+    /// encoding it just once.
+    class TransformImageService: public ssoa::TypedServiceStub<TransformImageSignature>
+    {
+        /// Just a shortcut.
+        typedef unsigned char byte;
+
+    public:
+        /// Constructs a new instance of TransformImageService.
+        ///
+        /// @param host The remote host of the service provider.
+        /// @param port The remote port on which the service is provided.
+        TransformImageService(std::string host, std::string port) :
+            ssoa::TypedServiceStub<TransformImageSignature>(std::move(host), std::move(port))
+        {
+        }
+
+        /// Gets a string representing the status of the operation.
+        const std::string& getStatus() const {
+            return status;
+        }
+
+        /// Executes the service request, that is, transforms the given image.
+        ///
+        /// @param operations The operations to apply, in order, separated by semicolons:
+        ///        "rotate <degrees>", "flip", "scale <width> <height>",
+        ///        "crop <x> <y> <width> <height>" and "quality <quality>" (of the result).
+        /// @param input The input buffer containing the image data.
+        /// @param output The output buffer that will contain the transformed image.
+        bool invoke(std::string operations, const std::vector<byte>& input, std::vector<byte>& output) {
+            std::unique_ptr<ssoa::Response> response(call(operations, input));
+            if (response->isSuccessful()) {
+                output = std::move(outputArgument<0>(*response).getValue());
+            }
+            status = response->getStatus();
+            return response->isSuccessful();
+        }
+
+    private:
+        std::string status;
+    };
+}
+
+#endif
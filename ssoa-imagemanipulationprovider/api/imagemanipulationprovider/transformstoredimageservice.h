@@ -0,0 +1,59 @@
+/*
+ * transformstoredimageservice.h
+ */
+
+#ifndef _TRANSFORMSTOREDIMAGESERVICE_H_
+#define _TRANSFORMSTOREDIMAGESERVICE_H_
+
+#include <ssoa/service/typedservicestub.h>
+
+namespace imagemanipulationprovider
+{
+    /// The name of the "TransformStoredImage" service.
+    struct TransformStoredImageName {
+        static const char * name() {
+            return "TransformStoredImage";
+        }
+    };
+
+    /// The signature of the "TransformStoredImage" service.
+    typedef ssoa::Signature<TransformStoredImageName,
+                            ssoa::In<std::string>, ssoa::In<std::string>, ssoa::In<std::string>> TransformStoredImageSignature;
+
+    /// Represents a service which applies a list of operations to an image kept by the storage
+    /// provider, storing the result there too, so that the image data never reaches the client.
+    class TransformStoredImageService: public ssoa::TypedServiceStub<TransformStoredImageSignature>
+    {
+    public:
+        /// Constructs a new instance of TransformStoredImageService.
+        ///
+        /// @param host The remote host of the service provider.
+        /// @param port The remote port on which the service is provided.
+        TransformStoredImageService(std::string host, std::string port) :
+            ssoa::TypedServiceStub<TransformStoredImageSignature>(std::move(host), std::move(port))
+        {
+        }
+
+        /// Gets a string representing the status of the operation.
+        const std::string& getStatus() const {
+            return status;
+        }
+
+        /// Executes the service request, that is, transforms an image on the storage provider.
+        ///
+        /// @param operations The operations to apply (see TransformImageService::invoke()).
+        /// @param source The name of the image to transform.
+        /// @param destination The name under which the transformed image is stored; it may be
+        ///        equal to @c source.
+        bool invoke(std::string operations, std::string source, std::string destination) {
+            std::unique_ptr<ssoa::Response> response(call(operations, source, destination));
+            status = response->getStatus();
+            return response->isSuccessful();
+        }
+
+    private:
+        std::string status;
+    };
+}
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * admissioncontroller.cpp
+ */
+
+#include <admissioncontroller.h>
+#include <imagepipeline.h>
+#include <jpegcodec.h>
+
+#include <algorithm>
+#include <set>
+#include <utility>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace imagemanipulationprovider
+{
+    namespace
+    {
+        boost::mutex mutex;
+        boost::condition_variable released;
+
+        bool enabled = false;
+        std::size_t memoryBudget;
+        std::size_t maxRunning;
+        std::size_t maxWaiting;
+
+        std::size_t usedMemory = 0;
+        std::size_t running = 0;
+
+        /// The waiting operations, cheapest first; the sequence number keeps the arrival order
+        /// among operations with the same cost.
+        std::set<std::pair<std::size_t, uint64_t>> waiting;
+        uint64_t nextSequence = 0;
+
+        AdmissionController::Statistics statistics = { 0, 0, 0 };
+
+        bool fits(std::size_t cost)
+        {
+            return running < maxRunning && (running == 0 || usedMemory + cost <= memoryBudget);
+        }
+    }
+
+    AdmissionController::Ticket::Ticket(std::size_t estimatedCost) :
+        cost(0), counted(false)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        if (!enabled) {
+            return;
+        }
+
+        // Such an operation would never fit, and may be a tiny image claiming a huge size.
+        if (estimatedCost > memoryBudget) {
+            statistics.rejected++;
+            throw TooLargeError();
+        }
+        cost = estimatedCost;
+        if (!waiting.empty() || !fits(cost)) {
+            if (waiting.size() >= maxWaiting) {
+                statistics.rejected++;
+                throw BusyError();
+            }
+            statistics.waited++;
+            const std::pair<std::size_t, uint64_t> key(cost, nextSequence++);
+            waiting.insert(key);
+            while (*waiting.begin() != key || !fits(cost)) {
+                released.wait(lock);
+            }
+            waiting.erase(waiting.begin());
+            // The next operation may fit too.
+            released.notify_all();
+        }
+
+        statistics.admitted++;
+        usedMemory += cost;
+        running++;
+        counted = true;
+    }
+
+    AdmissionController::Ticket::~Ticket()
+    {
+        if (!counted) {
+            return;
+        }
+        boost::lock_guard<boost::mutex> lock(mutex);
+        usedMemory -= cost;
+        running--;
+        released.notify_all();
+    }
+
+    void AdmissionController::initialize(std::size_t budget, std::size_t runningLimit, std::size_t waitingLimit)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        memoryBudget = budget;
+        maxRunning = std::max<std::size_t>(1, runningLimit);
+        maxWaiting = waitingLimit;
+        enabled = true;
+    }
+
+    std::size_t AdmissionController::estimateCost(const std::vector<byte>& input)
+    {
+        int width, height, channels;
+        try {
+            JpegCodec::readSize(input, width, height, channels);
+        }
+        catch (const std::runtime_error&) {
+            return 0;
+        }
+        return 3 * static_cast<std::size_t>(width) * height * channels;
+    }
+
+    std::size_t AdmissionController::estimateCost(const std::vector<byte>& input, const ImagePipeline& pipeline)
+    {
+        int width, height, channels;
+        try {
+            JpegCodec::readSize(input, width, height, channels);
+        }
+        catch (const std::runtime_error&) {
+            return 0;
+        }
+        return 3 * pipeline.getLargestImage(width, height) * channels;
+    }
+
+    AdmissionController::Statistics AdmissionController::getStatistics()
+    {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        return statistics;
+    }
+}
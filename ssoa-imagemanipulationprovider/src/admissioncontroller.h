@@ -0,0 +1,109 @@
+/*
+ * admissioncontroller.h
+ */
+
+#ifndef _ADMISSIONCONTROLLER_H_
+#define _ADMISSIONCONTROLLER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+namespace imagemanipulationprovider
+{
+    class ImagePipeline;
+
+    /// Limits the memory and the CPU used by the image operations running at the same time.
+    ///
+    /// Each operation acquires a Ticket for its estimated memory cost before processing the
+    /// image. Operations which do not fit wait in a bounded queue, where the cheapest ones are
+    /// admitted first so that small images are not stuck behind large ones; when the queue is
+    /// full, operations are rejected right away with a BusyError, so that clients can retry on
+    /// another provider instead of waiting. Operations which would exceed the whole budget are
+    /// rejected with a TooLargeError.
+    ///
+    /// This class is not thread-safe with respect to initialize(), which should be called just
+    /// once at program startup; until then, every operation is admitted.
+    class AdmissionController
+    {
+        typedef unsigned char byte;
+
+    public:
+        /// Thrown when an operation is rejected because the provider is busy.
+        class BusyError: public std::runtime_error
+        {
+        public:
+            BusyError() :
+                std::runtime_error("Busy")
+            {
+            }
+        };
+
+        /// Thrown when an operation needs more memory than the whole budget.
+        class TooLargeError: public std::runtime_error
+        {
+        public:
+            TooLargeError() :
+                std::runtime_error("Image too large for the memory available.")
+            {
+            }
+        };
+
+        /// Admits an operation while it exists.
+        class Ticket: private boost::noncopyable
+        {
+        public:
+            /// Waits until an operation with the given cost can be admitted.
+            ///
+            /// @throws BusyError The queue of waiting operations is full.
+            /// @throws TooLargeError The cost exceeds the memory budget.
+            explicit Ticket(std::size_t cost);
+
+            /// Releases the resources of the operation, admitting waiting ones.
+            ~Ticket();
+
+        private:
+            std::size_t cost;
+            bool counted;
+        };
+
+        /// The counters of the controller.
+        struct Statistics
+        {
+            uint64_t admitted; ///< Including the operations which had to wait.
+            uint64_t waited;
+            uint64_t rejected; ///< Including the operations too large for the budget.
+        };
+
+        /// Sets the limits.
+        ///
+        /// @param memoryBudget The total estimated memory of the running operations.
+        /// @param maxRunning The maximum number of running operations, usually the number of cores.
+        /// @param maxWaiting The maximum number of operations waiting to be admitted.
+        static void initialize(std::size_t memoryBudget, std::size_t maxRunning, std::size_t maxWaiting);
+
+        /// Estimates the memory needed to process a JPEG image from the size in its header:
+        /// decoded input and output images, plus a buffer of the same size for intermediate
+        /// results.
+        ///
+        /// @return The estimated cost, or 0 if the header cannot be read (decoding will fail
+        ///         anyway).
+        static std::size_t estimateCost(const std::vector<byte>& input);
+
+        /// Estimates the memory needed to apply a pipeline to a JPEG image, as above but with
+        /// the largest of the images produced by the pipeline instead of the input.
+        ///
+        /// @return The estimated cost, or 0 if the header cannot be read.
+        ///
+        /// @throws std::runtime_error The pipeline would produce an image beyond its limits.
+        static std::size_t estimateCost(const std::vector<byte>& input, const ImagePipeline& pipeline);
+
+        /// Gets a snapshot of the counters.
+        static Statistics getStatistics();
+    };
+}
+
+#endif
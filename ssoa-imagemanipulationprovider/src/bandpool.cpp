@@ -0,0 +1,177 @@
+/*
+ * bandpool.cpp
+ */
+
+#include <bandpool.h>
+
+#include <ssoa/service/computepool.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace imagemanipulationprovider
+{
+    namespace
+    {
+        /// The bands of a single run() call.
+        struct Job
+        {
+            Job(int count, const std::function<void(int)>& task) :
+                count(count), task(task), next(0), finished(0)
+            {
+            }
+
+            /// Processes bands until none is left.
+            void work()
+            {
+                for (int band = next++; band < count; band = next++) {
+                    try {
+                        task(band);
+                    }
+                    catch (const std::exception& e) {
+                        boost::lock_guard<boost::mutex> lock(mutex);
+                        if (error.empty()) {
+                            error = e.what();
+                        }
+                    }
+                    if (++finished == count) {
+                        boost::lock_guard<boost::mutex> lock(mutex);
+                        done.notify_all();
+                    }
+                }
+            }
+
+            const int count;
+            const std::function<void(int)>& task;
+            std::atomic<int> next;
+            std::atomic<int> finished;
+            boost::mutex mutex;
+            boost::condition_variable done;
+            std::string error;
+        };
+
+        boost::mutex mutex;
+        boost::condition_variable available;
+        std::deque<std::shared_ptr<Job>> jobs;
+        boost::thread_group helpers;
+        std::size_t idleHelpers = 0;
+        std::size_t helperCount = 0;
+        bool stopping = false;
+
+        void helperLoop()
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            while (true) {
+                idleHelpers++;
+                while (jobs.empty() && !stopping) {
+                    available.wait(lock);
+                }
+                idleHelpers--;
+                if (stopping) {
+                    return;
+                }
+
+                // Leave the job queued, so that other idle helpers can join it.
+                std::shared_ptr<Job> job = jobs.front();
+                lock.unlock();
+                job->work();
+                lock.lock();
+                if (!jobs.empty() && jobs.front() == job) {
+                    jobs.pop_front();
+                }
+            }
+        }
+    }
+
+    void BandPool::initialize(std::size_t threads)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        if (helperCount > 0) {
+            throw std::logic_error("The band pool has already been initialized.");
+        }
+        for (std::size_t i = 0; i < threads; i++) {
+            helpers.create_thread(helperLoop);
+        }
+        helperCount = threads;
+        stopping = false;
+    }
+
+    void BandPool::shutdown()
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(mutex);
+            stopping = true;
+            available.notify_all();
+        }
+        helpers.join_all();
+
+        boost::lock_guard<boost::mutex> lock(mutex);
+        jobs.clear();
+        idleHelpers = 0;
+        helperCount = 0;
+    }
+
+    void BandPool::run(int count, const std::function<void(int)>& task)
+    {
+        ssoa::ComputePool *pool = ssoa::ComputePool::current();
+        if (pool != NULL) {
+            pool->run(count, task);
+            return;
+        }
+
+        std::shared_ptr<Job> job = std::make_shared<Job>(count, task);
+
+        bool shared = false;
+        if (count > 1) {
+            boost::lock_guard<boost::mutex> lock(mutex);
+            // Busy helpers would only pick the job up once the caller is almost done.
+            if (idleHelpers > jobs.size()) {
+                jobs.push_back(job);
+                available.notify_all();
+                shared = true;
+            }
+        }
+
+        job->work();
+
+        if (shared) {
+            {
+                // Stop handing the job out: all its bands have been taken.
+                boost::lock_guard<boost::mutex> lock(mutex);
+                for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+                    if (*it == job) {
+                        jobs.erase(it);
+                        break;
+                    }
+                }
+            }
+            boost::unique_lock<boost::mutex> lock(job->mutex);
+            while (job->finished < count) {
+                job->done.wait(lock);
+            }
+        }
+
+        if (!job->error.empty()) {
+            throw std::runtime_error(job->error);
+        }
+    }
+
+    std::size_t BandPool::size()
+    {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        return helperCount;
+    }
+
+    std::size_t BandPool::concurrency()
+    {
+        ssoa::ComputePool *pool = ssoa::ComputePool::current();
+        return pool != NULL ? pool->size() : size() + 1;
+    }
+}
@@ -0,0 +1,49 @@
+/*
+ * bandpool.h
+ */
+
+#ifndef _BANDPOOL_H_
+#define _BANDPOOL_H_
+
+#include <cstddef>
+#include <functional>
+
+namespace imagemanipulationprovider
+{
+    /// A pool of helper threads shared by all requests, which splits the processing of a
+    /// single large image into bands of rows.
+    ///
+    /// The thread requesting the work always processes bands itself; helpers only join in
+    /// while they are idle, so under high load every request simply runs on its own
+    /// ServiceListener thread and the pool never adds more than its size to the running
+    /// threads. Until initialize() is called, everything runs on the calling thread.
+    ///
+    /// When the caller is a thread of an ssoa::ComputePool, the bands are processed on that
+    /// pool instead, whose idle threads steal them.
+    class BandPool
+    {
+    public:
+        /// Starts the helper threads. Must be called just once, at program startup.
+        ///
+        /// @param threads The number of helper threads; 0 disables intra-request parallelism.
+        static void initialize(std::size_t threads);
+
+        /// Stops the helper threads, after they finish the bands they are processing.
+        static void shutdown();
+
+        /// Calls @c task for each band in [0, count), possibly in parallel, and returns when
+        /// all of them have been processed.
+        ///
+        /// @throws std::runtime_error The message of the first exception thrown by @c task.
+        static void run(int count, const std::function<void(int)>& task);
+
+        /// Gets the number of helper threads.
+        static std::size_t size();
+
+        /// Gets the number of threads which may process the bands of the calling thread,
+        /// including itself.
+        static std::size_t concurrency();
+    };
+}
+
+#endif
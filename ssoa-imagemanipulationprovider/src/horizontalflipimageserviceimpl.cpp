@@ -12,15 +12,11 @@ using namespace ssoa;
 
 namespace imagemanipulationprovider
 {
-    Response * HorizontalFlipImageServiceImpl::invoke()
+    Response * HorizontalFlipImageServiceImpl::process()
     {
-        std::unique_ptr<ServiceBufferArgument> inputBuffer(popArgument<ServiceBufferArgument>());
-
         vector<byte> buffer;
-        ImageHelper::flipHorizontally(inputBuffer->getValue(), buffer);
+        ImageHelper::flipHorizontally(inputArgument<0>().getValue(), buffer);
 
-        Response * response = new Response(serviceSignature(), true, "OK");
-        response->pushArgument(new ServiceBufferArgument(std::move(buffer)));
-        return response;
+        return respond(std::move(buffer));
     }
 }
@@ -5,16 +5,16 @@
 #ifndef _HORIZONTALFLIPIMAGESERVICEIMPL_H_
 #define _HORIZONTALFLIPIMAGESERVICEIMPL_H_
 
-#include <ssoa/service/servicesignature.h>
-#include <ssoa/service/serviceskeleton.h>
+#include <imageserviceskeleton.h>
+#include <imagemanipulationprovider/horizontalflipimageservice.h>
 
 namespace imagemanipulationprovider
 {
     /// Implements the "HorizontalFlipImage" service.
-    class HorizontalFlipImageServiceImpl: public ssoa::ServiceSkeleton
+    class HorizontalFlipImageServiceImpl: public ImageServiceSkeleton<HorizontalFlipImageSignature>
     {
         HorizontalFlipImageServiceImpl(arg_deque arguments) :
-            ssoa::ServiceSkeleton(ssoa::ServiceSignature(serviceSignature()), std::move(arguments))
+            ImageServiceSkeleton<HorizontalFlipImageSignature>(std::move(arguments))
         {
         }
 
@@ -24,17 +24,13 @@ namespace imagemanipulationprovider
             return new HorizontalFlipImageServiceImpl(std::move(arguments));
         }
 
-        /// Gets the signature of this type of service.
-        static const char * serviceSignature() {
-            return "HorizontalFlipImage(in buffer, out buffer)";
-        }
-
         /// Installs the creation method.
         static void install() {
             factory().install(serviceSignature(), create);
         }
 
-        virtual ssoa::Response * invoke();
+    protected:
+        virtual ssoa::Response * process();
     };
 }
 
@@ -3,76 +3,165 @@
  */
 
 #include <imagehelper.h>
+#include <admissioncontroller.h>
+#include <imagekernels.h>
+#include <jpegcodec.h>
+#include <resultcache.h>
 
-#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <sstream>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
-#include <boost/filesystem.hpp>
+#include <ssoa/logger.h>
 
-using std::ifstream;
-using std::ofstream;
-using std::string;
 using std::vector;
-
-#define cimg_use_jpeg
-#include <CImg.h>
-using cimg_library::CImg;
+using ssoa::Logger;
 
 namespace imagemanipulationprovider
 {
-    static void loadFile(string filename, vector<unsigned char>& buffer)
+    namespace
     {
-        ifstream infile(filename.c_str(), ifstream::binary | ifstream::in | ifstream::ate);
-        buffer.resize(infile.tellg());
-        infile.seekg(0, ifstream::beg);
-        infile.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
-        infile.close();
-        if (infile.fail()) {
-            throw std::runtime_error("Cannot read file '" + filename + "' (" + strerror(errno) + ").");
-        }
+        EncodeProfile encodeProfile;
+
+        std::atomic<uint64_t> operations(0);
+        std::atomic<uint64_t> inputBytes(0);
+        std::atomic<uint64_t> outputBytes(0);
     }
 
-    static void saveFile(string filename, const vector<unsigned char>& buffer)
+    void ImageHelper::setEncodeProfile(const EncodeProfile& profile)
     {
-        ofstream outfile(filename.c_str(), ofstream::binary | ofstream::out);
-        outfile.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
-        outfile.flush();
-        outfile.close();
-        if (outfile.fail()) {
-            throw std::runtime_error("Cannot write file '" + filename + "' (" + strerror(errno) + ").");
-        }
+        encodeProfile = profile;
+    }
+
+    const EncodeProfile& ImageHelper::getEncodeProfile()
+    {
+        return encodeProfile;
+    }
+
+    ImageHelper::Statistics ImageHelper::getStatistics()
+    {
+        Statistics statistics;
+        statistics.operations = operations;
+        statistics.inputBytes = inputBytes;
+        statistics.outputBytes = outputBytes;
+        return statistics;
     }
 
     void ImageHelper::rotate(const vector<byte>& input, vector<byte>& output, float degrees)
     {
-        boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
-        const char * tempfilename = path.c_str();
+        // Equivalent angles share the cached results.
+        const float angle = degrees - 360.0f * std::floor(degrees / 360.0f);
+        std::ostringstream operation;
+        operation << "rotate " << angle;
+        cached(input, operation.str(), AdmissionController::estimateCost(input), output, [&]() {
+            rotateUncached(input, output, angle);
+        });
+    }
+
+    void ImageHelper::flipHorizontally(const vector<byte>& input, vector<byte>& output)
+    {
+        cached(input, "flip", AdmissionController::estimateCost(input), output, [&]() {
+            flipHorizontallyUncached(input, output);
+        });
+    }
+
+    void ImageHelper::thumbnail(const vector<byte>& input, vector<byte>& output, int maxSize)
+    {
+        if (maxSize <= 0) {
+            throw std::runtime_error("Invalid thumbnail size.");
+        }
+        const std::size_t cost = AdmissionController::estimateCost(input);
+        cached(input, "thumbnail " + std::to_string(maxSize), cost, output, [&]() {
+            thumbnailUncached(input, output, maxSize);
+        });
+    }
 
-        saveFile(tempfilename, input);
+    void ImageHelper::transform(const ImagePipeline& pipeline, const vector<byte>& input, vector<byte>& output)
+    {
+        // Also fails if the pipeline would produce an image too large.
+        const std::size_t cost = AdmissionController::estimateCost(input, pipeline);
+        cached(input, "pipeline " + pipeline.toString(), cost, output, [&]() {
+            pipeline.apply(input, output, encodeProfile);
+        });
+    }
 
-        CImg<float> image;
-        image = image.load_jpeg(tempfilename);
-        image.rotate(degrees);
-        image.save_jpeg(tempfilename);
+    void ImageHelper::cached(const vector<byte>& input, const std::string& operation, std::size_t cost,
+                             vector<byte>& output, const std::function<void()>& compute)
+    {
+        const size_t inputSize = input.size(); // output may be the same buffer
+        std::string key;
+        bool hit = false;
+        if (ResultCache::isEnabled()) {
+            key = ResultCache::makeKey(input, operation);
+            hit = ResultCache::lookup(key, output);
+        }
+        if (!hit) {
+            // Hits are cheap: only actual processing is subject to admission control.
+            AdmissionController::Ticket ticket(cost);
+            compute();
+            if (!key.empty()) {
+                ResultCache::store(key, output);
+            }
+        }
 
-        loadFile(tempfilename, output);
-        remove(tempfilename);
+        operations++;
+        inputBytes += inputSize;
+        outputBytes += output.size();
+        Logger::debug("Operation '%1%': %2% bytes in, %3% bytes out.", operation, inputSize, output.size());
     }
 
-    void ImageHelper::flipHorizontally(const vector<byte>& input, vector<byte>& output)
+    void ImageHelper::rotateUncached(const vector<byte>& input, vector<byte>& output, float angle)
     {
-        boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
-        const char * tempfilename = path.c_str();
+        // Right angles can be handled losslessly, as long as the image size allows it.
+        if (angle == 0 || angle == 90 || angle == 180 || angle == 270) {
+            static const JpegCodec::Transform transforms[] = {
+                JpegCodec::IDENTITY, JpegCodec::ROTATE_90, JpegCodec::ROTATE_180, JpegCodec::ROTATE_270
+            };
+            if (JpegCodec::transform(input, output, transforms[static_cast<int>(angle) / 90], encodeProfile)) {
+                return;
+            }
+        }
 
-        saveFile(tempfilename, input);
+        Image image, rotated;
+        JpegCodec::decode(input, image);
+        ImageKernels::rotate(image, rotated, angle);
+        JpegCodec::encode(rotated, output, encodeProfile);
+    }
+
+    void ImageHelper::thumbnailUncached(const vector<byte>& input, vector<byte>& output, int maxSize)
+    {
+        Image image, thumbnail;
+        JpegCodec::decode(input, image, maxSize);
+
+        // The decoded image is never scaled below maxSize, so a smaller one is the original.
+        const int size = std::max(image.width, image.height);
+        if (size < maxSize) {
+            if (&output != &input) {
+                output = input;
+            }
+            return;
+        }
+        // Resize the reduced image; the scale factor of the decoding does not change the aspect ratio.
+        const int width = std::max(1, static_cast<int>(std::lround(static_cast<double>(image.width) * maxSize / size)));
+        const int height = std::max(1, static_cast<int>(std::lround(static_cast<double>(image.height) * maxSize / size)));
+        ImageKernels::resize(image, thumbnail, width, height);
+        JpegCodec::encode(thumbnail, output, encodeProfile);
+    }
 
-        CImg<float> image;
-        image = image.load_jpeg(tempfilename);
-        image.mirror('x');
-        image.save_jpeg(tempfilename);
+    void ImageHelper::flipHorizontallyUncached(const vector<byte>& input, vector<byte>& output)
+    {
+        if (JpegCodec::transform(input, output, JpegCodec::FLIP_HORIZONTAL, encodeProfile)) {
+            return;
+        }
 
-        loadFile(tempfilename, output);
-        remove(tempfilename);
+        Image image, flipped;
+        JpegCodec::decode(input, image);
+        ImageKernels::mirrorX(image, flipped);
+        JpegCodec::encode(flipped, output, encodeProfile);
     }
 }
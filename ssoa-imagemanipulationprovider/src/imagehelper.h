@@ -5,22 +5,81 @@
 #ifndef _IMAGEHELPER_H_
 #define _IMAGEHELPER_H_
 
+#include <imagepipeline.h>
+#include <jpegcodec.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 
 namespace imagemanipulationprovider
 {
     /// Provides a few image manipulation routines.
+    ///
+    /// Results are looked up in the ResultCache first, so that repeated operations on the same
+    /// images skip decoding and encoding entirely. Operations which actually process images may
+    /// throw AdmissionController::BusyError when the provider is overloaded. Images are encoded
+    /// according to a profile shared by all operations.
     class ImageHelper
     {
         typedef unsigned char byte;
 
     public:
-        /// Rotates an image by the specified angle.
+        /// The sizes of the images handled by all operations.
+        struct Statistics
+        {
+            uint64_t operations;
+            uint64_t inputBytes;
+            uint64_t outputBytes;
+        };
+
+        /// Sets the profile used to encode the results. Should be called just once at program
+        /// startup, since cached results are not invalidated.
+        static void setEncodeProfile(const EncodeProfile& profile);
+
+        /// Gets the profile used to encode the results.
+        static const EncodeProfile& getEncodeProfile();
+
+        /// Gets a snapshot of the counters.
+        static Statistics getStatistics();
+
+        /// Rotates an image clockwise by the specified angle, in degrees.
+        ///
+        /// Right angles are handled losslessly (see JpegCodec::transform()) whenever possible.
         static void rotate(const std::vector<byte>& input, std::vector<byte>& output, float degrees);
 
-        /// Flips an image horizontally.
+        /// Flips an image horizontally, losslessly whenever possible.
         static void flipHorizontally(const std::vector<byte>& input, std::vector<byte>& output);
+
+        /// Shrinks an image so that its larger side is at most @c maxSize pixels long, keeping
+        /// its aspect ratio. Large images are decoded directly at a reduced scale (see
+        /// JpegCodec::decode()) before being resized. Images whose larger side is shorter than
+        /// @c maxSize are returned unchanged.
+        ///
+        /// @throws std::runtime_error The size is not positive, or the image is not valid.
+        static void thumbnail(const std::vector<byte>& input, std::vector<byte>& output, int maxSize);
+
+        /// Applies a pipeline of operations to an image (see ImagePipeline::apply()), encoding
+        /// it with the shared profile unless the pipeline overrides it.
+        static void transform(const ImagePipeline& pipeline, const std::vector<byte>& input,
+                              std::vector<byte>& output);
+
+    private:
+        /// Looks up the result of an operation in the ResultCache, calling @c compute to
+        /// produce it into @c output (and storing it) if it is missing, once admitted by the
+        /// AdmissionController with the given cost.
+        ///
+        /// @throws AdmissionController::BusyError The operation has been rejected.
+        static void cached(const std::vector<byte>& input, const std::string& operation, std::size_t cost,
+                           std::vector<byte>& output, const std::function<void()>& compute);
+
+        static void rotateUncached(const std::vector<byte>& input, std::vector<byte>& output, float angle);
+
+        static void flipHorizontallyUncached(const std::vector<byte>& input, std::vector<byte>& output);
+
+        static void thumbnailUncached(const std::vector<byte>& input, std::vector<byte>& output, int maxSize);
     };
 }
 
@@ -0,0 +1,462 @@
+/*
+ * imagekernels.cpp
+ */
+
+#include <imagekernels.h>
+#include <imagekernelsimpl.h>
+#include <bandpool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+namespace imagemanipulationprovider
+{
+    namespace kernels
+    {
+        template<int C>
+        inline void mirrorRowScalar(const byte *src, byte *dst, int width)
+        {
+            dst += (width - 1) * C;
+            for (int x = 0; x < width; x++, src += C, dst -= C) {
+                for (int c = 0; c < C; c++) {
+                    dst[c] = src[c];
+                }
+            }
+        }
+
+        void mirrorRow1Scalar(const byte *src, byte *dst, int width)
+        {
+            mirrorRowScalar<1>(src, dst, width);
+        }
+
+        void mirrorRow3Scalar(const byte *src, byte *dst, int width)
+        {
+            mirrorRowScalar<3>(src, dst, width);
+        }
+
+        /// Gets a sample, or 0 outside the image.
+        template<int C>
+        inline float sampleAt(const Image& input, int x, int y, int c)
+        {
+            if (x < 0 || y < 0 || x >= input.width || y >= input.height) {
+                return 0;
+            }
+            return input.pixels[(static_cast<size_t>(y) * input.width + x) * C + c];
+        }
+
+        template<int C>
+        inline void rotateRowScalar(const Image& input, const RotateParams& p, int y, int xBegin, int xEnd,
+                                    byte *dst)
+        {
+            const size_t below = static_cast<size_t>(input.width) * C;
+            for (int x = xBegin; x < xEnd; x++, dst += C) {
+                // Same expressions as CImg::get_rotate() and CImg::linear_atXY().
+                const float fx = p.w2 + (x - p.dw2) * p.ca + (y - p.dh2) * p.sa;
+                const float fy = p.h2 - (x - p.dw2) * p.sa + (y - p.dh2) * p.ca;
+                const int ix = static_cast<int>(fx) - (fx >= 0 ? 0 : 1);
+                const int iy = static_cast<int>(fy) - (fy >= 0 ? 0 : 1);
+                const float dx = fx - ix, dy = fy - iy;
+
+                const bool inside = ix >= 0 && iy >= 0 && ix + 1 < input.width && iy + 1 < input.height;
+                const byte *src = inside ?
+                    input.pixels.data() + (static_cast<size_t>(iy) * input.width + ix) * C : nullptr;
+                for (int c = 0; c < C; c++) {
+                    float Icc, Inc, Icn, Inn;
+                    if (inside) {
+                        Icc = src[c];
+                        Inc = src[C + c];
+                        Icn = src[below + c];
+                        Inn = src[below + C + c];
+                    }
+                    else {
+                        Icc = sampleAt<C>(input, ix, iy, c);
+                        Inc = sampleAt<C>(input, ix + 1, iy, c);
+                        Icn = sampleAt<C>(input, ix, iy + 1, c);
+                        Inn = sampleAt<C>(input, ix + 1, iy + 1, c);
+                    }
+                    const float value = Icc + dx * (Inc - Icc + dy * (Icc + Inn - Icn - Inc)) + dy * (Icn - Icc);
+                    dst[c] = static_cast<byte>(value < 0 ? 0 : value > 255 ? 255 : value);
+                }
+            }
+        }
+
+        void rotateRow1Scalar(const Image& input, const RotateParams& params, int y, int xBegin, int xEnd, byte *dst)
+        {
+            rotateRowScalar<1>(input, params, y, xBegin, xEnd, dst);
+        }
+
+        void rotateRow3Scalar(const Image& input, const RotateParams& params, int y, int xBegin, int xEnd, byte *dst)
+        {
+            rotateRowScalar<3>(input, params, y, xBegin, xEnd, dst);
+        }
+    }
+
+    namespace
+    {
+        using namespace kernels;
+
+        /// The kernels for a specific instruction set.
+        struct KernelTable
+        {
+            MirrorRow mirrorRow1, mirrorRow3;
+            RotateRow rotateRow1, rotateRow3;
+        };
+
+        const KernelTable kernelTables[] = {
+            { mirrorRow1Scalar, mirrorRow3Scalar, rotateRow1Scalar, rotateRow3Scalar },
+#if defined(__x86_64__) || defined(__i386__)
+            { mirrorRow1Ssse3, mirrorRow3Ssse3, rotateRow1Ssse3, rotateRow3Ssse3 },
+            // 3-byte pixels do not fit the 128-bit lanes of AVX2 shuffles: mirror them with SSSE3.
+            { mirrorRow1Avx2, mirrorRow3Ssse3, rotateRow1Avx2, rotateRow3Avx2 },
+#endif
+        };
+
+        ImageKernels::InstructionSet detectInstructionSet()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                return ImageKernels::AVX2;
+            }
+            if (__builtin_cpu_supports("ssse3")) {
+                return ImageKernels::SSSE3;
+            }
+#endif
+            return ImageKernels::SCALAR;
+        }
+
+        std::atomic<int>& currentInstructionSet()
+        {
+            static std::atomic<int> instructionSet(ImageKernels::getSupportedInstructionSet());
+            return instructionSet;
+        }
+
+        const KernelTable& currentKernels()
+        {
+            return kernelTables[currentInstructionSet().load(std::memory_order_relaxed)];
+        }
+
+        /// Calls @c task(yBegin, yEnd) for bands of rows covering an output image of the given
+        /// size, on the BandPool when the image is large enough to be worth it.
+        void forEachBand(int width, int height, const std::function<void(int, int)>& task)
+        {
+            const int T = ImageKernels::tileSize;
+            const size_t pixels = static_cast<size_t>(width) * height;
+            if (pixels < ImageKernels::minParallelPixels || BandPool::concurrency() <= 1) {
+                task(0, height);
+                return;
+            }
+            // Bands of whole tiles, a few per thread to balance uneven costs.
+            const int threads = static_cast<int>(BandPool::concurrency());
+            const int tiles = (height + T - 1) / T;
+            const int tilesPerBand = std::max(1, tiles / (4 * threads));
+            const int bandHeight = tilesPerBand * T;
+            BandPool::run((height + bandHeight - 1) / bandHeight, [&](int band) {
+                task(band * bandHeight, std::min(height, (band + 1) * bandHeight));
+            });
+        }
+
+        /// Maps each output pixel (x, y) of a right-angle rotation to the input pixel
+        /// (ax * x + bx * y + cx, ay * x + by * y + cy), processing square tiles of the rows
+        /// in [yBegin, yEnd).
+        template<int C>
+        void remapTiled(const Image& input, Image& output, int yBegin, int yEnd,
+                        int ax, int bx, int cx, int ay, int by, int cy)
+        {
+            const int T = ImageKernels::tileSize;
+            const size_t inStride = static_cast<size_t>(input.width) * C;
+            const size_t outStride = static_cast<size_t>(output.width) * C;
+            const ptrdiff_t stepX = ax * C + ay * static_cast<ptrdiff_t>(inStride);
+
+            for (int ty = yBegin; ty < yEnd; ty += T) {
+                const int tyEnd = std::min(ty + T, yEnd);
+                for (int tx = 0; tx < output.width; tx += T) {
+                    const int xEnd = std::min(tx + T, output.width);
+                    for (int y = ty; y < tyEnd; y++) {
+                        const byte *src = input.pixels.data() + (ax * tx + bx * y + cx) * C
+                            + (ay * tx + by * y + cy) * inStride;
+                        byte *dst = output.pixels.data() + y * outStride + tx * C;
+                        for (int x = tx; x < xEnd; x++, src += stepX, dst += C) {
+                            for (int c = 0; c < C; c++) {
+                                dst[c] = src[c];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        /// Rotates the rows in [yBegin, yEnd) by an arbitrary angle, processing square tiles
+        /// of the output so that the source pixels being read stay within a small area.
+        void rotateTiled(const Image& input, Image& output, int yBegin, int yEnd, const RotateParams& params,
+                         RotateRow rotateRow)
+        {
+            const int T = ImageKernels::tileSize;
+            const size_t outStride = static_cast<size_t>(output.width) * output.channels;
+            for (int ty = yBegin; ty < yEnd; ty += T) {
+                const int tyEnd = std::min(ty + T, yEnd);
+                for (int tx = 0; tx < output.width; tx += T) {
+                    const int xEnd = std::min(tx + T, output.width);
+                    for (int y = ty; y < tyEnd; y++) {
+                        byte *dst = output.pixels.data() + y * outStride + tx * output.channels;
+                        rotateRow(input, params, y, tx, xEnd, dst);
+                    }
+                }
+            }
+        }
+
+        /// The input samples contributing to each output sample when resampling along one axis.
+        struct Filter
+        {
+            std::vector<int> first;      ///< The first input sample of each output sample.
+            std::vector<int> count;      ///< The number of input samples of each output sample.
+            std::vector<int> offset;     ///< The position of the first weight of each output sample.
+            std::vector<float> weights;  ///< The weights of all the contributions.
+        };
+
+        /// Builds a box filter when shrinking and a linear one when enlarging.
+        Filter makeFilter(int inSize, int outSize)
+        {
+            Filter filter;
+            const double scale = static_cast<double>(inSize) / outSize;
+            for (int i = 0; i < outSize; i++) {
+                filter.offset.push_back(filter.weights.size());
+                if (scale > 1) {
+                    // Average the input samples overlapping [i * scale, (i + 1) * scale).
+                    const double begin = i * scale, end = std::min<double>((i + 1) * scale, inSize);
+                    const int first = static_cast<int>(begin);
+                    int last = static_cast<int>(std::ceil(end)) - 1;
+                    filter.first.push_back(first);
+                    filter.count.push_back(last - first + 1);
+                    for (int j = first; j <= last; j++) {
+                        const double overlap = std::min<double>(j + 1, end) - std::max<double>(j, begin);
+                        filter.weights.push_back(static_cast<float>(overlap / scale));
+                    }
+                }
+                else {
+                    // Interpolate between the two nearest samples, aligning pixel centers.
+                    const double center = std::max(0.0, (i + 0.5) * scale - 0.5);
+                    const int first = std::min(static_cast<int>(center), inSize - 1);
+                    const float weight = static_cast<float>(center - first);
+                    filter.first.push_back(first);
+                    if (first + 1 < inSize && weight > 0) {
+                        filter.count.push_back(2);
+                        filter.weights.push_back(1 - weight);
+                        filter.weights.push_back(weight);
+                    }
+                    else {
+                        filter.count.push_back(1);
+                        filter.weights.push_back(1);
+                    }
+                }
+            }
+            return filter;
+        }
+
+        void checkChannels(const Image& image)
+        {
+            if (image.channels != 1 && image.channels != 3) {
+                throw std::runtime_error("Unsupported number of channels.");
+            }
+        }
+    }
+
+    ImageKernels::InstructionSet ImageKernels::getSupportedInstructionSet()
+    {
+        static const InstructionSet supported = detectInstructionSet();
+        return supported;
+    }
+
+    ImageKernels::InstructionSet ImageKernels::getInstructionSet()
+    {
+        return static_cast<InstructionSet>(currentInstructionSet().load());
+    }
+
+    void ImageKernels::setInstructionSet(InstructionSet instructionSet)
+    {
+        if (instructionSet > getSupportedInstructionSet()) {
+            throw std::runtime_error("Instruction set not supported by the CPU.");
+        }
+        currentInstructionSet().store(instructionSet);
+    }
+
+    void ImageKernels::mirrorX(const Image& input, Image& output)
+    {
+        checkChannels(input);
+        output = Image(input.width, input.height, input.channels);
+
+        const KernelTable& table = currentKernels();
+        MirrorRow mirrorRow = input.channels == 1 ? table.mirrorRow1 : table.mirrorRow3;
+        const size_t stride = static_cast<size_t>(input.width) * input.channels;
+        forEachBand(input.width, input.height, [&](int yBegin, int yEnd) {
+            for (int y = yBegin; y < yEnd; y++) {
+                mirrorRow(input.pixels.data() + y * stride, output.pixels.data() + y * stride, input.width);
+            }
+        });
+    }
+
+    void ImageKernels::rotate(const Image& input, Image& output, float degrees)
+    {
+        checkChannels(input);
+        const int w = input.width, h = input.height;
+        if (w == 0 || h == 0) {
+            output = input;
+            return;
+        }
+
+        // Same normalization as cimg::mod(), in [0, 360).
+        const float angle = degrees - 360.0f * std::floor(degrees / 360.0f);
+        const float remainder = angle - 90.0f * std::floor(angle / 90.0f);
+
+        if (remainder == 0) {
+            // Each case gives the input coordinates (x', y') of the output pixel (x, y).
+            int ax, bx, cx, ay, by, cy;
+            switch (static_cast<int>(angle) / 90) {
+            case 1:  // x' = y, y' = h - 1 - x
+                output = Image(h, w, input.channels);
+                ax = 0; bx = 1; cx = 0; ay = -1; by = 0; cy = h - 1;
+                break;
+            case 2:  // x' = w - 1 - x, y' = h - 1 - y
+                output = Image(w, h, input.channels);
+                ax = -1; bx = 0; cx = w - 1; ay = 0; by = -1; cy = h - 1;
+                break;
+            case 3:  // x' = w - 1 - y, y' = x
+                output = Image(h, w, input.channels);
+                ax = 0; bx = -1; cx = w - 1; ay = 1; by = 0; cy = 0;
+                break;
+            default:
+                output = input;
+                return;
+            }
+            forEachBand(output.width, output.height, [&](int yBegin, int yEnd) {
+                if (input.channels == 1) {
+                    remapTiled<1>(input, output, yBegin, yEnd, ax, bx, cx, ay, by, cy);
+                }
+                else {
+                    remapTiled<3>(input, output, yBegin, yEnd, ax, bx, cx, ay, by, cy);
+                }
+            });
+            return;
+        }
+
+        RotateParams params;
+        const float rad = static_cast<float>(angle * M_PI / 180.0);
+        params.ca = std::cos(rad);
+        params.sa = std::sin(rad);
+        const float ux = std::abs(w * params.ca), uy = std::abs(w * params.sa);
+        const float vx = std::abs(h * params.sa), vy = std::abs(h * params.ca);
+        params.w2 = 0.5f * w;
+        params.h2 = 0.5f * h;
+        params.dw2 = 0.5f * (ux + vx);
+        params.dh2 = 0.5f * (uy + vy);
+
+        int width, height;
+        rotatedSize(w, h, degrees, width, height);
+        output = Image(width, height, input.channels);
+        const KernelTable& table = currentKernels();
+        RotateRow rotateRow = input.channels == 1 ? table.rotateRow1 : table.rotateRow3;
+        forEachBand(output.width, output.height, [&](int yBegin, int yEnd) {
+            rotateTiled(input, output, yBegin, yEnd, params, rotateRow);
+        });
+    }
+
+    void ImageKernels::rotatedSize(int width, int height, float degrees, int& outputWidth, int& outputHeight)
+    {
+        const float angle = degrees - 360.0f * std::floor(degrees / 360.0f);
+        const float remainder = angle - 90.0f * std::floor(angle / 90.0f);
+        if (width == 0 || height == 0 || (remainder == 0 && static_cast<int>(angle) / 90 % 2 == 0)) {
+            outputWidth = width;
+            outputHeight = height;
+        }
+        else if (remainder == 0) {
+            outputWidth = height;
+            outputHeight = width;
+        }
+        else {
+            // Same computation as rotate(), so that the size is exactly the same.
+            const float rad = static_cast<float>(angle * M_PI / 180.0);
+            const float ca = std::cos(rad), sa = std::sin(rad);
+            outputWidth = static_cast<int>(std::abs(width * ca) + std::abs(height * sa));
+            outputHeight = static_cast<int>(std::abs(width * sa) + std::abs(height * ca));
+        }
+    }
+
+    void ImageKernels::resize(const Image& input, Image& output, int width, int height)
+    {
+        checkChannels(input);
+        if (width <= 0 || height <= 0) {
+            throw std::runtime_error("Invalid image size.");
+        }
+        if (width == input.width && height == input.height) {
+            output = input;
+            return;
+        }
+        if (input.width == 0 || input.height == 0) {
+            throw std::runtime_error("Cannot resize an empty image.");
+        }
+
+        // Resample the rows first, then the columns.
+        const int C = input.channels;
+        const Filter fx = makeFilter(input.width, width), fy = makeFilter(input.height, height);
+        std::vector<float> rows(static_cast<size_t>(width) * input.height * C);
+        forEachBand(width, input.height, [&](int yBegin, int yEnd) {
+            for (int y = yBegin; y < yEnd; y++) {
+                const byte *src = input.pixels.data() + static_cast<size_t>(y) * input.width * C;
+                float *dst = rows.data() + static_cast<size_t>(y) * width * C;
+                for (int x = 0; x < width; x++) {
+                    const float *w = fx.weights.data() + fx.offset[x];
+                    for (int c = 0; c < C; c++) {
+                        const byte *s = src + fx.first[x] * C + c;
+                        float sum = 0;
+                        for (int k = 0; k < fx.count[x]; k++, s += C) {
+                            sum += w[k] * *s;
+                        }
+                        *dst++ = sum;
+                    }
+                }
+            }
+        });
+
+        output = Image(width, height, C);
+        const size_t stride = static_cast<size_t>(width) * C;
+        forEachBand(width, height, [&](int yBegin, int yEnd) {
+            std::vector<float> sums(stride);
+            for (int y = yBegin; y < yEnd; y++) {
+                std::fill(sums.begin(), sums.end(), 0.0f);
+                const float *w = fy.weights.data() + fy.offset[y];
+                for (int k = 0; k < fy.count[y]; k++) {
+                    const float *src = rows.data() + (fy.first[y] + k) * stride;
+                    for (size_t i = 0; i < stride; i++) {
+                        sums[i] += w[k] * src[i];
+                    }
+                }
+                byte *dst = output.pixels.data() + y * stride;
+                for (size_t i = 0; i < stride; i++) {
+                    const float value = sums[i] + 0.5f;
+                    dst[i] = static_cast<byte>(value < 0 ? 0 : value > 255 ? 255 : value);
+                }
+            }
+        });
+    }
+
+    void ImageKernels::crop(const Image& input, Image& output, int x, int y, int width, int height)
+    {
+        checkChannels(input);
+        if (width <= 0 || height <= 0 || x < 0 || y < 0
+                || x > input.width - width || y > input.height - height) {
+            throw std::runtime_error("Invalid crop rectangle.");
+        }
+
+        output = Image(width, height, input.channels);
+        const size_t inStride = static_cast<size_t>(input.width) * input.channels;
+        const size_t outStride = static_cast<size_t>(width) * input.channels;
+        for (int row = 0; row < height; row++) {
+            const byte *src = input.pixels.data() + (y + row) * inStride + x * input.channels;
+            std::copy(src, src + outStride, output.pixels.data() + row * outStride);
+        }
+    }
+}
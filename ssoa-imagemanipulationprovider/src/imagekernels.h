@@ -0,0 +1,78 @@
+/*
+ * imagekernels.h
+ */
+
+#ifndef _IMAGEKERNELS_H_
+#define _IMAGEKERNELS_H_
+
+#include <jpegcodec.h>
+
+namespace imagemanipulationprovider
+{
+    /// Geometric transformations working directly on 8-bit interleaved images.
+    ///
+    /// Results match the ones of the corresponding CImg methods (with linear interpolation
+    /// and zero boundary for rotations), so that switching implementation does not change
+    /// the output of the services.
+    ///
+    /// Mirroring and rotations by arbitrary angles have vectorized implementations, selected
+    /// at runtime according to the instruction sets supported by the CPU; all of them
+    /// produce exactly the same results. Large images are split into bands of rows processed
+    /// in parallel (see BandPool).
+    class ImageKernels
+    {
+    public:
+        /// The instruction sets for which kernels are specialized.
+        enum InstructionSet
+        {
+            SCALAR,
+            SSSE3, ///< 128-bit vectors (byte shuffles are needed to move 3-byte pixels).
+            AVX2   ///< 256-bit vectors and gathers.
+        };
+
+        /// Mirrors an image along the X axis (i.e. flips it horizontally).
+        static void mirrorX(const Image& input, Image& output);
+
+        /// Rotates an image clockwise by the given angle, in degrees.
+        ///
+        /// Multiples of 90 degrees are exact; other angles enlarge the image to contain the
+        /// whole rotated one, filling the corners with black.
+        static void rotate(const Image& input, Image& output, float degrees);
+
+        /// Gets the size of the image produced by rotate() from an image of the given size.
+        static void rotatedSize(int width, int height, float degrees, int& outputWidth, int& outputHeight);
+
+        /// Scales an image to the given size, averaging the input pixels covered by each
+        /// output pixel when shrinking and interpolating linearly when enlarging.
+        ///
+        /// @throws std::runtime_error The size is not positive.
+        static void resize(const Image& input, Image& output, int width, int height);
+
+        /// Extracts the rectangle of the given size whose top-left corner is (x, y).
+        ///
+        /// @throws std::runtime_error The rectangle is empty or not contained in the image.
+        static void crop(const Image& input, Image& output, int x, int y, int width, int height);
+
+        /// Gets the best instruction set supported by the CPU.
+        static InstructionSet getSupportedInstructionSet();
+
+        /// Gets the instruction set of the kernels currently in use.
+        static InstructionSet getInstructionSet();
+
+        /// Selects the kernels to use. By default, the best ones supported by the CPU are used,
+        /// so this is mostly useful to test and compare implementations.
+        ///
+        /// @throws std::runtime_error The instruction set is not supported by the CPU.
+        static void setInstructionSet(InstructionSet instructionSet);
+
+        /// The side of square tiles in which images are processed, so that the pixels being
+        /// read and written at any time fit in the L1 cache.
+        static const int tileSize = 64;
+
+        /// The number of output pixels above which images are split into bands of rows
+        /// processed in parallel on the BandPool.
+        static const unsigned minParallelPixels = 512 * 1024;
+    };
+}
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ * imagekernelsimpl.h
+ */
+
+#ifndef _IMAGEKERNELSIMPL_H_
+#define _IMAGEKERNELSIMPL_H_
+
+#include <jpegcodec.h>
+
+namespace imagemanipulationprovider
+{
+    /// Row kernels shared by the implementations of ImageKernels for each instruction set.
+    namespace kernels
+    {
+        typedef unsigned char byte;
+
+        /// The parameters of a rotation by an arbitrary angle, as computed by CImg::get_rotate().
+        /// The output pixel (x, y) is interpolated at the input coordinates
+        /// (w2 + (x - dw2) * ca + (y - dh2) * sa, h2 - (x - dw2) * sa + (y - dh2) * ca).
+        struct RotateParams
+        {
+            float ca, sa, w2, h2, dw2, dh2;
+        };
+
+        /// Writes the mirrored pixels of a whole row.
+        typedef void (*MirrorRow)(const byte *src, byte *dst, int width);
+
+        /// Writes the output pixels [xBegin, xEnd) of row y of a rotated image.
+        typedef void (*RotateRow)(const Image& input, const RotateParams& params, int y, int xBegin, int xEnd,
+                                  byte *dst);
+
+        void mirrorRow1Scalar(const byte *src, byte *dst, int width);
+        void mirrorRow3Scalar(const byte *src, byte *dst, int width);
+        void rotateRow1Scalar(const Image& input, const RotateParams& params, int y, int xBegin, int xEnd, byte *dst);
+        void rotateRow3Scalar(const Image& input, const RotateParams& params, int y, int xBegin, int xEnd, byte *dst);
+
+#if defined(__x86_64__) || defined(__i386__)
+        void mirrorRow1Ssse3(const byte *src, byte *dst, int width);
+        void mirrorRow3Ssse3(const byte *src, byte *dst, int width);
+        void rotateRow1Ssse3(const Image& input, const RotateParams& params, int y, int xBegin, int xEnd, byte *dst);
+        void rotateRow3Ssse3(const Image& input, const RotateParams& params, int y, int xBegin, int xEnd, byte *dst);
+
+        void mirrorRow1Avx2(const byte *src, byte *dst, int width);
+        void rotateRow1Avx2(const Image& input, const RotateParams& params, int y, int xBegin, int xEnd, byte *dst);
+        void rotateRow3Avx2(const Image& input, const RotateParams& params, int y, int xBegin, int xEnd, byte *dst);
+#endif
+    }
+}
+
+#endif
@@ -0,0 +1,339 @@
+/*
+ * imagekernelsx86.cpp
+ */
+
+#include <imagekernelsimpl.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <cstdint>
+#include <cstring>
+
+#include <immintrin.h>
+
+// Functions are compiled for specific instruction sets by means of target attributes, so
+// the rest of the program keeps the baseline ones and kernels are selected at runtime.
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+
+namespace imagemanipulationprovider
+{
+    namespace kernels
+    {
+        namespace
+        {
+            /// Checks whether the vector code can address the input with 32-bit byte offsets.
+            inline bool fitsOffsets(const Image& input)
+            {
+                return input.pixels.size() <= static_cast<size_t>(INT32_MAX / 2);
+            }
+
+            /// Checks whether a 32-bit load at the given byte offset stays within the input.
+            inline bool loadsInside(const Image& input, int32_t lastOffset)
+            {
+                return lastOffset >= 0 && static_cast<size_t>(lastOffset) + 4 <= input.pixels.size();
+            }
+
+            inline uint32_t load32(const byte *p)
+            {
+                uint32_t value;
+                std::memcpy(&value, p, sizeof(value));
+                return value;
+            }
+
+            inline void store32(byte *p, uint32_t value)
+            {
+                std::memcpy(p, &value, sizeof(value));
+            }
+        }
+
+        // ----------------------------------------------------------------------------------
+        // SSSE3
+        // ----------------------------------------------------------------------------------
+
+        TARGET_SSSE3
+        void mirrorRow1Ssse3(const byte *src, byte *dst, int width)
+        {
+            const __m128i reverse = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+            int x = 0;
+            for (; x + 16 <= width; x += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + width - 16 - x), _mm_shuffle_epi8(v, reverse));
+            }
+            mirrorRow1Scalar(src + x, dst, width - x);
+        }
+
+        TARGET_SSSE3
+        void mirrorRow3Ssse3(const byte *src, byte *dst, int width)
+        {
+            // Five pixels (15 bytes) are reversed at a time and stored one byte earlier, so the
+            // spare byte falls on the pixel written by the next iteration (or by the tail).
+            const __m128i reverse = _mm_setr_epi8(-1, 12, 13, 14, 9, 10, 11, 6, 7, 8, 3, 4, 5, 0, 1, 2);
+            int x = 0;
+            for (; x + 6 <= width; x += 5) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 3));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (width - 5 - x) * 3 - 1),
+                                 _mm_shuffle_epi8(v, reverse));
+            }
+            mirrorRow3Scalar(src + x * 3, dst, width - x);
+        }
+
+        /// Computes four output pixels of a rotation with 128-bit vectors, loading the four
+        /// neighbours of each pixel with scalar loads. Returns false if some neighbour lies
+        /// outside the image, in which case nothing is written.
+        template<int C>
+        TARGET_SSSE3
+        inline bool rotate4Ssse3(const Image& input, const RotateParams& p, __m128 fy0, __m128 fx0, int x, byte *dst)
+        {
+            const __m128 xs = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(x), _mm_setr_epi32(0, 1, 2, 3)));
+            const __m128 xd = _mm_sub_ps(xs, _mm_set1_ps(p.dw2));
+            const __m128 fx = _mm_add_ps(_mm_add_ps(_mm_set1_ps(p.w2), _mm_mul_ps(xd, _mm_set1_ps(p.ca))), fx0);
+            const __m128 fy = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(p.h2), _mm_mul_ps(xd, _mm_set1_ps(p.sa))), fy0);
+
+            // Truncate, then subtract one for negative coordinates (i.e. floor).
+            const __m128 zero = _mm_setzero_ps();
+            const __m128i ix = _mm_add_epi32(_mm_cvttps_epi32(fx), _mm_castps_si128(_mm_cmplt_ps(fx, zero)));
+            const __m128i iy = _mm_add_epi32(_mm_cvttps_epi32(fy), _mm_castps_si128(_mm_cmplt_ps(fy, zero)));
+
+            int32_t ixs[4], iys[4];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(ixs), ix);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(iys), iy);
+
+            const int32_t stride = input.width * C;
+            uint32_t cc[4], nc[4], cn[4], nn[4];
+            for (int i = 0; i < 4; i++) {
+                if (ixs[i] < 0 || iys[i] < 0 || ixs[i] + 1 >= input.width || iys[i] + 1 >= input.height) {
+                    return false;
+                }
+                const int32_t offset = (iys[i] * input.width + ixs[i]) * C;
+                if (!loadsInside(input, offset + stride + C)) {
+                    return false;
+                }
+                const byte *src = input.pixels.data() + offset;
+                cc[i] = load32(src);
+                nc[i] = load32(src + C);
+                cn[i] = load32(src + stride);
+                nn[i] = load32(src + stride + C);
+            }
+
+            const __m128 dx = _mm_sub_ps(fx, _mm_cvtepi32_ps(ix));
+            const __m128 dy = _mm_sub_ps(fy, _mm_cvtepi32_ps(iy));
+            const __m128i vcc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cc));
+            const __m128i vnc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(nc));
+            const __m128i vcn = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cn));
+            const __m128i vnn = _mm_loadu_si128(reinterpret_cast<const __m128i*>(nn));
+            const __m128i mask = _mm_set1_epi32(0xFF);
+
+            __m128i packed = _mm_setzero_si128();
+            for (int c = 0; c < C; c++) {
+                const __m128 Icc = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(vcc, 8 * c), mask));
+                const __m128 Inc = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(vnc, 8 * c), mask));
+                const __m128 Icn = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(vcn, 8 * c), mask));
+                const __m128 Inn = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(vnn, 8 * c), mask));
+                // Icc + dx * (Inc - Icc + dy * (Icc + Inn - Icn - Inc)) + dy * (Icn - Icc)
+                const __m128 cross = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(Icc, Inn), Icn), Inc);
+                const __m128 inner = _mm_add_ps(_mm_sub_ps(Inc, Icc), _mm_mul_ps(dy, cross));
+                __m128 value = _mm_add_ps(_mm_add_ps(Icc, _mm_mul_ps(dx, inner)), _mm_mul_ps(dy, _mm_sub_ps(Icn, Icc)));
+                value = _mm_min_ps(_mm_max_ps(value, zero), _mm_set1_ps(255.0f));
+                packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_cvttps_epi32(value), 8 * c));
+            }
+
+            if (C == 1) {
+                const __m128i gather = _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+                store32(dst, static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_shuffle_epi8(packed, gather))));
+            }
+            else {
+                const __m128i gather = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+                const __m128i bytes = _mm_shuffle_epi8(packed, gather);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), bytes);
+                store32(dst + 8, static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(bytes, 8))));
+            }
+            return true;
+        }
+
+        template<int C>
+        TARGET_SSSE3
+        inline void rotateRowSsse3(const Image& input, const RotateParams& p, int y, int xBegin, int xEnd, byte *dst)
+        {
+            const __m128 yd = _mm_set1_ps(y - p.dh2);
+            const __m128 fx0 = _mm_mul_ps(yd, _mm_set1_ps(p.sa));
+            const __m128 fy0 = _mm_mul_ps(yd, _mm_set1_ps(p.ca));
+            const bool vectorize = fitsOffsets(input);
+            int x = xBegin;
+            for (; vectorize && x + 4 <= xEnd; x += 4, dst += 4 * C) {
+                if (!rotate4Ssse3<C>(input, p, fy0, fx0, x, dst)) {
+                    // Near the borders of the input image.
+                    if (C == 1) {
+                        rotateRow1Scalar(input, p, y, x, x + 4, dst);
+                    }
+                    else {
+                        rotateRow3Scalar(input, p, y, x, x + 4, dst);
+                    }
+                }
+            }
+            if (C == 1) {
+                rotateRow1Scalar(input, p, y, x, xEnd, dst);
+            }
+            else {
+                rotateRow3Scalar(input, p, y, x, xEnd, dst);
+            }
+        }
+
+        void rotateRow1Ssse3(const Image& input, const RotateParams& params, int y, int xBegin, int xEnd, byte *dst)
+        {
+            rotateRowSsse3<1>(input, params, y, xBegin, xEnd, dst);
+        }
+
+        void rotateRow3Ssse3(const Image& input, const RotateParams& params, int y, int xBegin, int xEnd, byte *dst)
+        {
+            rotateRowSsse3<3>(input, params, y, xBegin, xEnd, dst);
+        }
+
+        // ----------------------------------------------------------------------------------
+        // AVX2
+        // ----------------------------------------------------------------------------------
+
+        TARGET_AVX2
+        void mirrorRow1Avx2(const byte *src, byte *dst, int width)
+        {
+            const __m256i reverse = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                                     15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+            int x = 0;
+            for (; x + 32 <= width; x += 32) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x));
+                // Reverse bytes within each lane, then swap the lanes.
+                v = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, reverse), 0x4E);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + width - 32 - x), v);
+            }
+            mirrorRow1Ssse3(src + x, dst, width - x);
+        }
+
+        /// Computes eight output pixels of a rotation, loading the neighbours with gathers.
+        /// Returns false if some neighbour lies outside the image, in which case nothing is
+        /// written.
+        template<int C>
+        TARGET_AVX2
+        inline bool rotate8Avx2(const Image& input, const RotateParams& p, __m256 fy0, __m256 fx0, int x, byte *dst)
+        {
+            const __m256 xs = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(x),
+                                                                  _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+            const __m256 xd = _mm256_sub_ps(xs, _mm256_set1_ps(p.dw2));
+            const __m256 fx = _mm256_add_ps(_mm256_add_ps(_mm256_set1_ps(p.w2), _mm256_mul_ps(xd, _mm256_set1_ps(p.ca))), fx0);
+            const __m256 fy = _mm256_add_ps(_mm256_sub_ps(_mm256_set1_ps(p.h2), _mm256_mul_ps(xd, _mm256_set1_ps(p.sa))), fy0);
+
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256i ix = _mm256_add_epi32(_mm256_cvttps_epi32(fx),
+                                                _mm256_castps_si256(_mm256_cmp_ps(fx, zero, _CMP_LT_OQ)));
+            const __m256i iy = _mm256_add_epi32(_mm256_cvttps_epi32(fy),
+                                                _mm256_castps_si256(_mm256_cmp_ps(fy, zero, _CMP_LT_OQ)));
+
+            // All neighbours must be inside the image: 0 <= ix < width - 1 and 0 <= iy < height - 1
+            // (unsigned comparisons also reject negative values).
+            const __m256i bias = _mm256_set1_epi32(INT32_MIN);
+            const __m256i xLimit = _mm256_set1_epi32((input.width - 1) ^ INT32_MIN);
+            const __m256i yLimit = _mm256_set1_epi32((input.height - 1) ^ INT32_MIN);
+            const __m256i inside = _mm256_and_si256(
+                _mm256_cmpgt_epi32(xLimit, _mm256_xor_si256(ix, bias)),
+                _mm256_cmpgt_epi32(yLimit, _mm256_xor_si256(iy, bias)));
+            if (_mm256_movemask_epi8(inside) != -1) {
+                return false;
+            }
+
+            const int32_t stride = input.width * C;
+            const __m256i offset = _mm256_mullo_epi32(_mm256_add_epi32(_mm256_mullo_epi32(iy, _mm256_set1_epi32(input.width)), ix),
+                                                      _mm256_set1_epi32(C));
+            int32_t offsets[8];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(offsets), offset);
+            for (int i = 0; i < 8; i++) {
+                if (!loadsInside(input, offsets[i] + stride + C)) {
+                    return false;
+                }
+            }
+
+            const int *base = reinterpret_cast<const int*>(input.pixels.data());
+            const __m256i vcc = _mm256_i32gather_epi32(base, offset, 1);
+            const __m256i vnc = _mm256_i32gather_epi32(base, _mm256_add_epi32(offset, _mm256_set1_epi32(C)), 1);
+            const __m256i vcn = _mm256_i32gather_epi32(base, _mm256_add_epi32(offset, _mm256_set1_epi32(stride)), 1);
+            const __m256i vnn = _mm256_i32gather_epi32(base, _mm256_add_epi32(offset, _mm256_set1_epi32(stride + C)), 1);
+
+            const __m256 dx = _mm256_sub_ps(fx, _mm256_cvtepi32_ps(ix));
+            const __m256 dy = _mm256_sub_ps(fy, _mm256_cvtepi32_ps(iy));
+            const __m256i mask = _mm256_set1_epi32(0xFF);
+
+            __m256i packed = _mm256_setzero_si256();
+            for (int c = 0; c < C; c++) {
+                const __m256 Icc = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(vcc, 8 * c), mask));
+                const __m256 Inc = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(vnc, 8 * c), mask));
+                const __m256 Icn = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(vcn, 8 * c), mask));
+                const __m256 Inn = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(vnn, 8 * c), mask));
+                // Icc + dx * (Inc - Icc + dy * (Icc + Inn - Icn - Inc)) + dy * (Icn - Icc)
+                const __m256 cross = _mm256_sub_ps(_mm256_sub_ps(_mm256_add_ps(Icc, Inn), Icn), Inc);
+                const __m256 inner = _mm256_add_ps(_mm256_sub_ps(Inc, Icc), _mm256_mul_ps(dy, cross));
+                __m256 value = _mm256_add_ps(_mm256_add_ps(Icc, _mm256_mul_ps(dx, inner)),
+                                             _mm256_mul_ps(dy, _mm256_sub_ps(Icn, Icc)));
+                value = _mm256_min_ps(_mm256_max_ps(value, zero), _mm256_set1_ps(255.0f));
+                packed = _mm256_or_si256(packed, _mm256_slli_epi32(_mm256_cvttps_epi32(value), 8 * c));
+            }
+
+            if (C == 1) {
+                const __m256i gather = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                        0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+                const __m256i bytes = _mm256_shuffle_epi8(packed, gather);
+                store32(dst, static_cast<uint32_t>(_mm256_extract_epi32(bytes, 0)));
+                store32(dst + 4, static_cast<uint32_t>(_mm256_extract_epi32(bytes, 4)));
+            }
+            else {
+                const __m256i gather = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                                        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+                const __m256i bytes = _mm256_shuffle_epi8(packed, gather);
+                const __m128i low = _mm256_castsi256_si128(bytes);
+                const __m128i high = _mm256_extracti128_si256(bytes, 1);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), low);
+                store32(dst + 8, static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(low, 8))));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 12), high);
+                store32(dst + 20, static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(high, 8))));
+            }
+            return true;
+        }
+
+        template<int C>
+        TARGET_AVX2
+        inline void rotateRowAvx2(const Image& input, const RotateParams& p, int y, int xBegin, int xEnd, byte *dst)
+        {
+            const __m256 yd = _mm256_set1_ps(y - p.dh2);
+            const __m256 fx0 = _mm256_mul_ps(yd, _mm256_set1_ps(p.sa));
+            const __m256 fy0 = _mm256_mul_ps(yd, _mm256_set1_ps(p.ca));
+            const bool vectorize = fitsOffsets(input);
+            int x = xBegin;
+            for (; vectorize && x + 8 <= xEnd; x += 8, dst += 8 * C) {
+                if (!rotate8Avx2<C>(input, p, fy0, fx0, x, dst)) {
+                    // Near the borders of the input image.
+                    if (C == 1) {
+                        rotateRow1Scalar(input, p, y, x, x + 8, dst);
+                    }
+                    else {
+                        rotateRow3Scalar(input, p, y, x, x + 8, dst);
+                    }
+                }
+            }
+            if (C == 1) {
+                rotateRow1Scalar(input, p, y, x, xEnd, dst);
+            }
+            else {
+                rotateRow3Scalar(input, p, y, x, xEnd, dst);
+            }
+        }
+
+        void rotateRow1Avx2(const Image& input, const RotateParams& params, int y, int xBegin, int xEnd, byte *dst)
+        {
+            rotateRowAvx2<1>(input, params, y, xBegin, xEnd, dst);
+        }
+
+        void rotateRow3Avx2(const Image& input, const RotateParams& params, int y, int xBegin, int xEnd, byte *dst)
+        {
+            rotateRowAvx2<3>(input, params, y, xBegin, xEnd, dst);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,201 @@
+/*
+ * imagepipeline.cpp
+ */
+
+#include <imagepipeline.h>
+#include <imagekernels.h>
+#include <jpegcodec.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/algorithm/string.hpp>
+
+using std::string;
+using std::vector;
+
+namespace imagemanipulationprovider
+{
+    namespace
+    {
+        /// Throws an exception if the size is beyond the limits of ImagePipeline.
+        void checkSize(int width, int height)
+        {
+            if (width > ImagePipeline::maxSide || height > ImagePipeline::maxSide
+                    || static_cast<int64_t>(width) * height > ImagePipeline::maxPixels) {
+                throw std::runtime_error("The size of the result exceeds " + std::to_string(ImagePipeline::maxSide)
+                                         + " pixels per side or " + std::to_string(ImagePipeline::maxPixels)
+                                         + " pixels.");
+            }
+        }
+    }
+
+    ImagePipeline::ImagePipeline(const string& description)
+    {
+        vector<string> steps;
+        boost::split(steps, description, boost::is_any_of(";"));
+        for (const string& step : steps) {
+            std::istringstream stream(step);
+            string name;
+            if (!(stream >> name)) {
+                continue; // Allow empty steps, e.g. after a trailing semicolon
+            }
+
+            Operation operation;
+            int count;
+            if (name == "rotate") {
+                operation.type = Operation::ROTATE;
+                count = 1;
+            }
+            else if (name == "flip") {
+                operation.type = Operation::FLIP;
+                count = 0;
+            }
+            else if (name == "scale") {
+                operation.type = Operation::SCALE;
+                count = 2;
+            }
+            else if (name == "crop") {
+                operation.type = Operation::CROP;
+                count = 4;
+            }
+            else if (name == "quality") {
+                operation.type = Operation::QUALITY;
+                count = 1;
+            }
+            else {
+                throw std::runtime_error("Unknown operation '" + name + "'.");
+            }
+
+            for (int i = 0; i < count; i++) {
+                if (!(stream >> operation.parameters[i])) {
+                    throw std::runtime_error("Missing parameters of operation '" + name + "'.");
+                }
+            }
+            string extra;
+            if (stream >> extra) {
+                throw std::runtime_error("Too many parameters of operation '" + name + "'.");
+            }
+            if (operation.type == Operation::QUALITY
+                    && (operation.parameters[0] < 1 || operation.parameters[0] > 100)) {
+                throw std::runtime_error("The quality must be between 1 and 100.");
+            }
+            if (operation.type == Operation::SCALE) {
+                checkSize(operation.parameters[0], operation.parameters[1]);
+            }
+            else if (operation.type == Operation::CROP) {
+                checkSize(operation.parameters[2], operation.parameters[3]);
+            }
+            operations.push_back(operation);
+        }
+    }
+
+    string ImagePipeline::toString() const
+    {
+        static const char * names[] = { "rotate", "flip", "scale", "crop", "quality" };
+        static const int counts[] = { 1, 0, 2, 4, 1 };
+
+        std::ostringstream stream;
+        for (size_t i = 0; i < operations.size(); i++) {
+            stream << (i > 0 ? "; " : "") << names[operations[i].type];
+            for (int j = 0; j < counts[operations[i].type]; j++) {
+                stream << ' ' << operations[i].parameters[j];
+            }
+        }
+        return stream.str();
+    }
+
+    std::size_t ImagePipeline::getLargestImage(int width, int height) const
+    {
+        std::size_t largest = static_cast<std::size_t>(width) * height;
+        for (const Operation& operation : operations) {
+            const int * p = operation.parameters;
+            switch (operation.type) {
+            case Operation::ROTATE:
+                ImageKernels::rotatedSize(width, height, static_cast<float>(p[0]), width, height);
+                break;
+            case Operation::FLIP:
+            case Operation::QUALITY:
+                continue;
+            case Operation::SCALE:
+                width = p[0];
+                height = p[1];
+                break;
+            case Operation::CROP:
+                width = p[2];
+                height = p[3];
+                break;
+            }
+            checkSize(width, height);
+            largest = std::max(largest, static_cast<std::size_t>(width) * height);
+        }
+        return largest;
+    }
+
+    void ImagePipeline::apply(const vector<byte>& input, vector<byte>& output, const EncodeProfile& profile) const
+    {
+        // Compose flips and right angles as rotate(k * 90, flip^f(image)): since flipping after
+        // a rotation equals flipping before the opposite one, each flip negates k.
+        bool lossless = true;
+        int k = 0, f = 0;
+        for (const Operation& operation : operations) {
+            if (operation.type == Operation::FLIP) {
+                f ^= 1;
+                k = -k;
+            }
+            else if (operation.type == Operation::ROTATE && operation.parameters[0] % 90 == 0) {
+                k += operation.parameters[0] / 90;
+            }
+            else if (operation.type == Operation::QUALITY) {
+                // Lossless transformations do not quantize again.
+                continue;
+            }
+            else {
+                lossless = false;
+                break;
+            }
+        }
+        k = (k % 4 + 4) % 4;
+        if (lossless && (f == 0 || k == 0)) {
+            static const JpegCodec::Transform rotations[] = {
+                JpegCodec::IDENTITY, JpegCodec::ROTATE_90, JpegCodec::ROTATE_180, JpegCodec::ROTATE_270
+            };
+            if (JpegCodec::transform(input, output, f ? JpegCodec::FLIP_HORIZONTAL : rotations[k], profile)) {
+                return;
+            }
+        }
+
+        // Fail before allocating anything if some result would be too large.
+        int width, height, channels;
+        JpegCodec::readSize(input, width, height, channels);
+        getLargestImage(width, height);
+
+        EncodeProfile finalProfile = profile;
+        Image image, result;
+        JpegCodec::decode(input, image);
+        for (const Operation& operation : operations) {
+            const int * p = operation.parameters;
+            switch (operation.type) {
+            case Operation::ROTATE:
+                ImageKernels::rotate(image, result, static_cast<float>(p[0]));
+                break;
+            case Operation::FLIP:
+                ImageKernels::mirrorX(image, result);
+                break;
+            case Operation::SCALE:
+                ImageKernels::resize(image, result, p[0], p[1]);
+                break;
+            case Operation::CROP:
+                ImageKernels::crop(image, result, p[0], p[1], p[2], p[3]);
+                break;
+            case Operation::QUALITY:
+                finalProfile.quality = p[0];
+                continue;
+            }
+            std::swap(image, result);
+        }
+        JpegCodec::encode(image, output, finalProfile);
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * imagepipeline.h
+ */
+
+#ifndef _IMAGEPIPELINE_H_
+#define _IMAGEPIPELINE_H_
+
+#include <jpegcodec.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace imagemanipulationprovider
+{
+    /// An ordered list of operations applied to an image, decoding it once and encoding it
+    /// once.
+    ///
+    /// Pipelines are described by strings of operations separated by semicolons, each one
+    /// being a name followed by its integer parameters:
+    ///   - "rotate <degrees>" rotates clockwise (see ImageKernels::rotate());
+    ///   - "flip" flips horizontally;
+    ///   - "scale <width> <height>" resizes to the given size;
+    ///   - "crop <x> <y> <width> <height>" extracts a rectangle;
+    ///   - "quality <quality>" overrides the JPEG quality of the result, wherever it appears.
+    ///
+    /// For instance, "crop 0 0 800 600; scale 400 300; rotate 90".
+    class ImagePipeline
+    {
+        typedef unsigned char byte;
+
+    public:
+        enum
+        {
+            /// The maximum width and height of the images produced by a pipeline, as for JPEG.
+            maxSide = 65500,
+
+            /// The maximum number of pixels of the images produced by a pipeline.
+            maxPixels = JpegCodec::maxPixels
+        };
+
+        /// Parses a pipeline.
+        ///
+        /// @throws std::runtime_error The description is not valid, or it scales or crops to
+        ///         a size beyond the limits.
+        explicit ImagePipeline(const std::string& description);
+
+        /// Computes the sizes of the images produced by the operations from an image of the
+        /// given size.
+        ///
+        /// @return The number of pixels of the largest image, including the input one.
+        ///
+        /// @throws std::runtime_error Some operation would produce an image beyond the limits.
+        std::size_t getLargestImage(int width, int height) const;
+
+        /// Applies the operations to a JPEG image.
+        ///
+        /// Pipelines made only of flips and right-angle rotations which amount to a transformation
+        /// supported by JpegCodec::transform() are applied losslessly, whenever possible.
+        ///
+        /// @param profile The profile used to encode the result.
+        ///
+        /// @throws std::runtime_error The image is not valid, or some operation cannot be applied.
+        void apply(const std::vector<byte>& input, std::vector<byte>& output,
+                   const EncodeProfile& profile = EncodeProfile()) const;
+
+        /// Gets a canonical description of the pipeline, equal for all the descriptions which
+        /// parse to the same operations.
+        std::string toString() const;
+
+    private:
+        struct Operation
+        {
+            enum Type { ROTATE, FLIP, SCALE, CROP, QUALITY } type;
+            int parameters[4];
+        };
+
+        std::vector<Operation> operations;
+    };
+}
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ * imageserviceskeleton.h
+ */
+
+#ifndef _IMAGESERVICESKELETON_H_
+#define _IMAGESERVICESKELETON_H_
+
+#include <admissioncontroller.h>
+
+#include <ssoa/service/typedserviceskeleton.h>
+
+#include <utility>
+
+namespace imagemanipulationprovider
+{
+    /// A skeleton of the services which process images. When the AdmissionController rejects
+    /// an operation, the service fails with the status "Busy", so that the client can retry on
+    /// another provider, or with the reason why the image is too large, instead of reporting
+    /// an internal error.
+    ///
+    /// @tparam Sig The Signature of the service.
+    template<typename Sig>
+    class ImageServiceSkeleton: public ssoa::TypedServiceSkeleton<Sig>
+    {
+    public:
+        virtual ssoa::Response * invoke() {
+            try {
+                return process();
+            }
+            catch (const AdmissionController::BusyError& e) {
+                return this->fail(e.what());
+            }
+            catch (const AdmissionController::TooLargeError& e) {
+                return this->fail(e.what());
+            }
+        }
+
+    protected:
+        /// Constructs a new instance of ImageServiceSkeleton from the given arguments.
+        ImageServiceSkeleton(typename ssoa::TypedServiceSkeleton<Sig>::arg_deque arguments) :
+            ssoa::TypedServiceSkeleton<Sig>(std::move(arguments))
+        {
+        }
+
+        /// Processes the request, as invoke().
+        ///
+        /// @throws AdmissionController::BusyError The provider is overloaded.
+        /// @throws AdmissionController::TooLargeError The image exceeds the memory budget.
+        virtual ssoa::Response * process() = 0;
+    };
+}
+
+#endif
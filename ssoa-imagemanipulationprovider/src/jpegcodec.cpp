@@ -0,0 +1,486 @@
+/*
+ * jpegcodec.cpp
+ */
+
+#include <jpegcodec.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+extern "C" {
+#include <jpeglib.h>
+#include <jerror.h>
+}
+
+using std::string;
+using std::vector;
+
+namespace imagemanipulationprovider
+{
+    namespace
+    {
+        std::atomic<uint64_t> encodes(0);
+        std::atomic<uint64_t> transforms(0);
+        std::atomic<uint64_t> outputBytes(0);
+        std::atomic<uint64_t> encodeMicroseconds(0);
+
+        void countEncoding(std::atomic<uint64_t>& counter, const vector<unsigned char>& output,
+                           std::chrono::steady_clock::time_point start)
+        {
+            counter++;
+            outputBytes += output.size();
+            encodeMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+
+        /// Sets the entropy coding parameters of a profile, once all the others are set.
+        void applyProfile(j_compress_ptr cinfo, const EncodeProfile& profile)
+        {
+            cinfo->optimize_coding = profile.optimize ? TRUE : FALSE;
+            if (profile.progressive) {
+                jpeg_simple_progression(cinfo);
+            }
+        }
+
+        /// Reports libjpeg errors by jumping back to the caller, which throws an exception.
+        ///
+        /// Exceptions cannot be thrown directly, since they would unwind through C code.
+        struct ErrorManager
+        {
+            jpeg_error_mgr pub;
+            jmp_buf jump;
+            char message[JMSG_LENGTH_MAX];
+        };
+
+        void errorExit(j_common_ptr cinfo)
+        {
+            ErrorManager *err = reinterpret_cast<ErrorManager*>(cinfo->err);
+            (*cinfo->err->format_message)(cinfo, err->message);
+            std::longjmp(err->jump, 1);
+        }
+
+        void outputMessage(j_common_ptr /* cinfo */)
+        {
+            // Warnings are ignored, as libjpeg recovers from them.
+        }
+
+        void initErrorManager(ErrorManager& err)
+        {
+            jpeg_std_error(&err.pub);
+            err.pub.error_exit = errorExit;
+            err.pub.output_message = outputMessage;
+            err.message[0] = '\0';
+        }
+
+        /// Reads compressed data from a memory buffer.
+        struct SourceManager
+        {
+            jpeg_source_mgr pub;
+        };
+
+        void initSource(j_decompress_ptr /* cinfo */)
+        {
+        }
+
+        boolean fillInputBuffer(j_decompress_ptr cinfo)
+        {
+            // The whole buffer is provided at once: insert a fake EOI marker for truncated data.
+            static const JOCTET eoi[2] = { 0xFF, JPEG_EOI };
+            WARNMS(cinfo, JWRN_JPEG_EOF);
+            cinfo->src->next_input_byte = eoi;
+            cinfo->src->bytes_in_buffer = 2;
+            return TRUE;
+        }
+
+        void skipInputData(j_decompress_ptr cinfo, long count)
+        {
+            if (count <= 0) {
+                return;
+            }
+            while (count > static_cast<long>(cinfo->src->bytes_in_buffer)) {
+                count -= cinfo->src->bytes_in_buffer;
+                fillInputBuffer(cinfo);
+            }
+            cinfo->src->next_input_byte += count;
+            cinfo->src->bytes_in_buffer -= count;
+        }
+
+        void termSource(j_decompress_ptr /* cinfo */)
+        {
+        }
+
+        void setSource(j_decompress_ptr cinfo, SourceManager& src, const vector<unsigned char>& input)
+        {
+            src.pub.init_source = initSource;
+            src.pub.fill_input_buffer = fillInputBuffer;
+            src.pub.skip_input_data = skipInputData;
+            src.pub.resync_to_restart = jpeg_resync_to_restart;
+            src.pub.term_source = termSource;
+            src.pub.next_input_byte = input.data();
+            src.pub.bytes_in_buffer = input.size();
+            cinfo->src = &src.pub;
+        }
+
+        /// Writes compressed data to a vector, which grows as needed.
+        struct DestinationManager
+        {
+            jpeg_destination_mgr pub;
+            vector<unsigned char> *output;
+        };
+
+        void initDestination(j_compress_ptr cinfo)
+        {
+            DestinationManager *dest = reinterpret_cast<DestinationManager*>(cinfo->dest);
+            dest->pub.next_output_byte = dest->output->data();
+            dest->pub.free_in_buffer = dest->output->size();
+        }
+
+        boolean emptyOutputBuffer(j_compress_ptr cinfo)
+        {
+            // Called when the buffer is full, so its whole size has been written.
+            DestinationManager *dest = reinterpret_cast<DestinationManager*>(cinfo->dest);
+            size_t used = dest->output->size();
+            bool failed = false;
+            try {
+                dest->output->resize(used * 2);
+            }
+            catch (const std::bad_alloc&) {
+                failed = true;
+            }
+            if (failed) {
+                ERREXIT1(cinfo, JERR_OUT_OF_MEMORY, 0);
+            }
+            dest->pub.next_output_byte = dest->output->data() + used;
+            dest->pub.free_in_buffer = dest->output->size() - used;
+            return TRUE;
+        }
+
+        void termDestination(j_compress_ptr cinfo)
+        {
+            DestinationManager *dest = reinterpret_cast<DestinationManager*>(cinfo->dest);
+            dest->output->resize(dest->output->size() - dest->pub.free_in_buffer);
+        }
+
+        void setDestination(j_compress_ptr cinfo, DestinationManager& dest, vector<unsigned char>& output)
+        {
+            dest.pub.init_destination = initDestination;
+            dest.pub.empty_output_buffer = emptyOutputBuffer;
+            dest.pub.term_destination = termDestination;
+            dest.output = &output;
+            cinfo->dest = &dest.pub;
+        }
+
+        JDIMENSION roundUp(JDIMENSION value, int multiple)
+        {
+            return (value + multiple - 1) / multiple * multiple;
+        }
+
+        /// Copies a block of coefficients applying the given transformation.
+        ///
+        /// Mirroring the samples of a block along one direction negates the coefficients of
+        /// odd frequencies along that direction; rotating by 90 degrees transposes the block
+        /// and then mirrors it.
+        void transformBlock(const JCOEF *src, JCOEF *dst, JpegCodec::Transform transform)
+        {
+            for (int i = 0; i < DCTSIZE; i++) {
+                for (int j = 0; j < DCTSIZE; j++) {
+                    JCOEF value = src[i * DCTSIZE + j];
+                    switch (transform) {
+                    case JpegCodec::IDENTITY:
+                        dst[i * DCTSIZE + j] = value;
+                        break;
+                    case JpegCodec::FLIP_HORIZONTAL:
+                        dst[i * DCTSIZE + j] = (j & 1) ? -value : value;
+                        break;
+                    case JpegCodec::ROTATE_180:
+                        dst[i * DCTSIZE + j] = ((i + j) & 1) ? -value : value;
+                        break;
+                    case JpegCodec::ROTATE_90:
+                        dst[j * DCTSIZE + i] = (i & 1) ? -value : value;
+                        break;
+                    case JpegCodec::ROTATE_270:
+                        dst[j * DCTSIZE + i] = (j & 1) ? -value : value;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    void JpegCodec::decode(const vector<byte>& input, Image& image, int minSize)
+    {
+        jpeg_decompress_struct cinfo;
+        ErrorManager err;
+        SourceManager src;
+
+        // Nothing with a non-trivial destructor is created below: longjmp() would skip it.
+        initErrorManager(err);
+        cinfo.err = &err.pub;
+        if (setjmp(err.jump)) {
+            jpeg_destroy_decompress(&cinfo);
+            throw std::runtime_error(string("Cannot decode JPEG image (") + err.message + ").");
+        }
+
+        jpeg_create_decompress(&cinfo);
+        setSource(&cinfo, src, input);
+        jpeg_read_header(&cinfo, TRUE);
+
+        if (cinfo.jpeg_color_space == JCS_GRAYSCALE) {
+            cinfo.out_color_space = JCS_GRAYSCALE;
+        }
+        else if (cinfo.jpeg_color_space == JCS_YCbCr || cinfo.jpeg_color_space == JCS_RGB) {
+            cinfo.out_color_space = JCS_RGB;
+        }
+        else {
+            jpeg_destroy_decompress(&cinfo);
+            throw std::runtime_error("Cannot decode JPEG image (unsupported color space).");
+        }
+
+        if (minSize > 0) {
+            const JDIMENSION size = std::max(cinfo.image_width, cinfo.image_height);
+            for (unsigned int denom = 8; denom > 1; denom /= 2) {
+                if ((size + denom - 1) / denom >= static_cast<JDIMENSION>(minSize)) {
+                    cinfo.scale_num = 1;
+                    cinfo.scale_denom = denom;
+                    break;
+                }
+            }
+        }
+
+        // Check and allocate the image before libjpeg allocates its own buffers for it.
+        jpeg_calc_output_dimensions(&cinfo);
+        const uint64_t pixels = static_cast<uint64_t>(cinfo.output_width) * cinfo.output_height;
+        if (pixels > maxPixels) {
+            jpeg_destroy_decompress(&cinfo);
+            throw std::runtime_error("Cannot decode JPEG image (more than " + std::to_string(maxPixels)
+                                     + " pixels).");
+        }
+        image.width = cinfo.output_width;
+        image.height = cinfo.output_height;
+        image.channels = cinfo.output_components;
+        try {
+            image.pixels.resize(pixels * image.channels);
+        }
+        catch (...) {
+            jpeg_destroy_decompress(&cinfo);
+            throw;
+        }
+
+        jpeg_start_decompress(&cinfo);
+
+        size_t stride = static_cast<size_t>(image.width) * image.channels;
+        while (cinfo.output_scanline < cinfo.output_height) {
+            JSAMPROW row = image.pixels.data() + cinfo.output_scanline * stride;
+            jpeg_read_scanlines(&cinfo, &row, 1);
+        }
+
+        jpeg_finish_decompress(&cinfo);
+        jpeg_destroy_decompress(&cinfo);
+    }
+
+    void JpegCodec::readSize(const vector<byte>& input, int& width, int& height, int& channels)
+    {
+        jpeg_decompress_struct cinfo;
+        ErrorManager err;
+        SourceManager src;
+
+        initErrorManager(err);
+        cinfo.err = &err.pub;
+        if (setjmp(err.jump)) {
+            jpeg_destroy_decompress(&cinfo);
+            throw std::runtime_error(string("Cannot decode JPEG image (") + err.message + ").");
+        }
+
+        jpeg_create_decompress(&cinfo);
+        setSource(&cinfo, src, input);
+        jpeg_read_header(&cinfo, TRUE);
+        width = cinfo.image_width;
+        height = cinfo.image_height;
+        channels = cinfo.num_components;
+        jpeg_destroy_decompress(&cinfo);
+    }
+
+    void JpegCodec::encode(const Image& image, vector<byte>& output, const EncodeProfile& profile)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        if (image.channels != 1 && image.channels != 3) {
+            throw std::runtime_error("Cannot encode JPEG image (unsupported number of channels).");
+        }
+
+        jpeg_compress_struct cinfo;
+        ErrorManager err;
+        DestinationManager dest;
+
+        // Start with a buffer large enough for most images, to avoid reallocations.
+        output.resize(4096 + image.pixels.size() / 4);
+
+        // Nothing with a non-trivial destructor is created below: longjmp() would skip it.
+        initErrorManager(err);
+        cinfo.err = &err.pub;
+        if (setjmp(err.jump)) {
+            jpeg_destroy_compress(&cinfo);
+            output.clear();
+            throw std::runtime_error(string("Cannot encode JPEG image (") + err.message + ").");
+        }
+
+        jpeg_create_compress(&cinfo);
+        setDestination(&cinfo, dest, output);
+
+        cinfo.image_width = image.width;
+        cinfo.image_height = image.height;
+        cinfo.input_components = image.channels;
+        cinfo.in_color_space = image.channels == 1 ? JCS_GRAYSCALE : JCS_RGB;
+        jpeg_set_defaults(&cinfo);
+        jpeg_set_quality(&cinfo, profile.quality, TRUE);
+        if (image.channels == 3) {
+            // Only the luma channel has other than unit sampling factors.
+            cinfo.comp_info[0].h_samp_factor = profile.subsampling == EncodeProfile::SUBSAMPLING_444 ? 1 : 2;
+            cinfo.comp_info[0].v_samp_factor = profile.subsampling == EncodeProfile::SUBSAMPLING_420 ? 2 : 1;
+        }
+        applyProfile(&cinfo, profile);
+        jpeg_start_compress(&cinfo, TRUE);
+
+        size_t stride = static_cast<size_t>(image.width) * image.channels;
+        while (cinfo.next_scanline < cinfo.image_height) {
+            JSAMPROW row = const_cast<JSAMPROW>(image.pixels.data() + cinfo.next_scanline * stride);
+            jpeg_write_scanlines(&cinfo, &row, 1);
+        }
+
+        jpeg_finish_compress(&cinfo);
+        jpeg_destroy_compress(&cinfo);
+        countEncoding(encodes, output, start);
+    }
+
+    bool JpegCodec::transform(const vector<byte>& input, vector<byte>& output, Transform transform,
+                              const EncodeProfile& profile)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        jpeg_decompress_struct src;
+        jpeg_compress_struct dst;
+        ErrorManager err;
+        SourceManager srcManager;
+        DestinationManager dstManager;
+
+        const bool transposed = transform == ROTATE_90 || transform == ROTATE_270;
+        const bool mirrorsX = transform != IDENTITY;
+        const bool mirrorsY = transform == ROTATE_90 || transform == ROTATE_180 || transform == ROTATE_270;
+
+        output.resize(input.size() + 4096);
+
+        // Both structures are cleared, so that they can be safely destroyed before creation.
+        std::memset(&src, 0, sizeof(src));
+        std::memset(&dst, 0, sizeof(dst));
+        initErrorManager(err);
+        src.err = &err.pub;
+        dst.err = &err.pub;
+        if (setjmp(err.jump)) {
+            jpeg_destroy_compress(&dst);
+            jpeg_destroy_decompress(&src);
+            output.clear();
+            throw std::runtime_error(string("Cannot transform JPEG image (") + err.message + ").");
+        }
+
+        jpeg_create_decompress(&src);
+        setSource(&src, srcManager, input);
+        jpeg_read_header(&src, TRUE);
+
+        // Mirroring a partial MCU would move padding inside the image.
+        if ((mirrorsX && src.image_width % (src.max_h_samp_factor * DCTSIZE) != 0) ||
+            (mirrorsY && src.image_height % (src.max_v_samp_factor * DCTSIZE) != 0)) {
+            jpeg_destroy_decompress(&src);
+            output.clear();
+            return false;
+        }
+
+        // The arrays of the destination coefficients must be requested before reading the
+        // source ones, so that they are allocated along with them.
+        const int components = src.num_components;
+        jvirt_barray_ptr *dstArrays = static_cast<jvirt_barray_ptr*>((*src.mem->alloc_small)(
+            reinterpret_cast<j_common_ptr>(&src), JPOOL_IMAGE, sizeof(jvirt_barray_ptr) * components));
+        for (int ci = 0; ci < components; ci++) {
+            const jpeg_component_info& comp = src.comp_info[ci];
+            const int hSamp = transposed ? comp.v_samp_factor : comp.h_samp_factor;
+            const int vSamp = transposed ? comp.h_samp_factor : comp.v_samp_factor;
+            const JDIMENSION width = transposed ? comp.height_in_blocks : comp.width_in_blocks;
+            const JDIMENSION height = transposed ? comp.width_in_blocks : comp.height_in_blocks;
+            dstArrays[ci] = (*src.mem->request_virt_barray)(reinterpret_cast<j_common_ptr>(&src), JPOOL_IMAGE,
+                                                            FALSE, roundUp(width, hSamp), roundUp(height, vSamp),
+                                                            vSamp);
+        }
+
+        jvirt_barray_ptr *srcArrays = jpeg_read_coefficients(&src);
+
+        jpeg_create_compress(&dst);
+        setDestination(&dst, dstManager, output);
+        jpeg_copy_critical_parameters(&src, &dst);
+        if (transposed) {
+            std::swap(dst.image_width, dst.image_height);
+            for (int ci = 0; ci < components; ci++) {
+                std::swap(dst.comp_info[ci].h_samp_factor, dst.comp_info[ci].v_samp_factor);
+            }
+            for (int t = 0; t < NUM_QUANT_TBLS; t++) {
+                JQUANT_TBL *table = dst.quant_tbl_ptrs[t];
+                if (table == NULL) {
+                    continue;
+                }
+                for (int i = 0; i < DCTSIZE; i++) {
+                    for (int j = i + 1; j < DCTSIZE; j++) {
+                        std::swap(table->quantval[i * DCTSIZE + j], table->quantval[j * DCTSIZE + i]);
+                    }
+                }
+            }
+        }
+
+        j_common_ptr common = reinterpret_cast<j_common_ptr>(&src);
+        for (int ci = 0; ci < components; ci++) {
+            const jpeg_component_info& comp = src.comp_info[ci];
+            const JDIMENSION srcWidth = roundUp(comp.width_in_blocks, comp.h_samp_factor);
+            const JDIMENSION srcHeight = roundUp(comp.height_in_blocks, comp.v_samp_factor);
+            const JDIMENSION dstWidth = transposed ? srcHeight : srcWidth;
+            const JDIMENSION dstHeight = transposed ? srcWidth : srcHeight;
+
+            for (JDIMENSION y = 0; y < dstHeight; y++) {
+                JBLOCKROW dstRow = (*src.mem->access_virt_barray)(common, dstArrays[ci], y, 1, TRUE)[0];
+                for (JDIMENSION x = 0; x < dstWidth; x++) {
+                    // The block of the source which ends up at (x, y).
+                    JDIMENSION sx, sy;
+                    switch (transform) {
+                    case FLIP_HORIZONTAL: sx = srcWidth - 1 - x; sy = y; break;
+                    case ROTATE_90:       sx = y; sy = srcHeight - 1 - x; break;
+                    case ROTATE_180:      sx = srcWidth - 1 - x; sy = srcHeight - 1 - y; break;
+                    case ROTATE_270:      sx = srcWidth - 1 - y; sy = x; break;
+                    default:              sx = x; sy = y; break;
+                    }
+                    JBLOCKROW srcRow = (*src.mem->access_virt_barray)(common, srcArrays[ci], sy, 1, FALSE)[0];
+                    transformBlock(srcRow[sx], dstRow[x], transform);
+                }
+            }
+        }
+
+        applyProfile(&dst, profile);
+        jpeg_write_coefficients(&dst, dstArrays);
+        jpeg_finish_compress(&dst);
+        jpeg_destroy_compress(&dst);
+        jpeg_finish_decompress(&src);
+        jpeg_destroy_decompress(&src);
+        countEncoding(transforms, output, start);
+        return true;
+    }
+
+    JpegCodec::Statistics JpegCodec::getStatistics()
+    {
+        Statistics statistics;
+        statistics.encodes = encodes;
+        statistics.transforms = transforms;
+        statistics.outputBytes = outputBytes;
+        statistics.encodeMicroseconds = encodeMicroseconds;
+        return statistics;
+    }
+}
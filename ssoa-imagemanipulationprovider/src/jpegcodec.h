@@ -0,0 +1,129 @@
+/*
+ * jpegcodec.h
+ */
+
+#ifndef _JPEGCODEC_H_
+#define _JPEGCODEC_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace imagemanipulationprovider
+{
+    /// An image with 8-bit samples and interleaved channels, stored row by row.
+    struct Image
+    {
+        Image() :
+            width(0), height(0), channels(0)
+        {
+        }
+
+        Image(int width, int height, int channels) :
+            width(width), height(height), channels(channels), pixels(width * height * channels)
+        {
+        }
+
+        int width;
+        int height;
+        int channels; ///< 1 (grayscale) or 3 (RGB).
+        std::vector<unsigned char> pixels;
+    };
+
+    /// The parameters of JPEG encoding, trading output size for encoding time and quality.
+    struct EncodeProfile
+    {
+        /// The resolution of the chroma channels, relative to the luma one.
+        enum Subsampling
+        {
+            SUBSAMPLING_444, ///< Full resolution.
+            SUBSAMPLING_422, ///< Half horizontal resolution.
+            SUBSAMPLING_420  ///< Half horizontal and vertical resolution.
+        };
+
+        EncodeProfile() :
+            quality(90), subsampling(SUBSAMPLING_420), optimize(true), progressive(false)
+        {
+        }
+
+        int quality;             ///< Between 1 and 100.
+        Subsampling subsampling; ///< Ignored by grayscale images.
+        bool optimize;           ///< Whether to compute optimal Huffman tables, for smaller files.
+        bool progressive;        ///< Whether to use progressive scans, usually smaller still.
+    };
+
+    /// Decodes and encodes JPEG images directly from/to memory buffers.
+    class JpegCodec
+    {
+        typedef unsigned char byte;
+
+    public:
+        /// The maximum number of pixels of the images decoded; JPEG headers may claim sizes up
+        /// to 65535x65535, whatever the size of the data.
+        enum { maxPixels = 100000000 };
+
+        /// Decodes a JPEG image.
+        ///
+        /// @param minSize If positive, the image is decoded at the smallest among the scales
+        ///        1/8, 1/4 and 1/2 at which its larger side is still at least @c minSize pixels
+        ///        long, if any. Scaling happens in the inverse DCT, so it is much faster than
+        ///        decoding the full image and resizing it.
+        ///
+        /// @throws std::runtime_error The data is not a valid JPEG image, it uses a color space
+        ///         other than grayscale and YCbCr/RGB, or it decodes to more than maxPixels.
+        /// @throws std::bad_alloc The decoded image cannot be allocated.
+        static void decode(const std::vector<byte>& input, Image& image, int minSize = 0);
+
+        /// Reads the size of a JPEG image from its header, without decoding it.
+        ///
+        /// @throws std::runtime_error The data is not a valid JPEG image.
+        static void readSize(const std::vector<byte>& input, int& width, int& height, int& channels);
+
+        /// Encodes an image as JPEG, replacing the content of @c output.
+        ///
+        /// @throws std::runtime_error The image cannot be encoded.
+        static void encode(const Image& image, std::vector<byte>& output,
+                           const EncodeProfile& profile = EncodeProfile());
+
+        /// A lossless transformation of a JPEG image (rotations are clockwise).
+        enum Transform
+        {
+            IDENTITY,
+            FLIP_HORIZONTAL,
+            ROTATE_90,
+            ROTATE_180,
+            ROTATE_270
+        };
+
+        /// Transforms a JPEG image by rearranging its DCT coefficients, without decoding it
+        /// (as done by jpegtran). This is much faster than decoding, transforming and encoding
+        /// the image, and it introduces no generation loss.
+        ///
+        /// The transformation is performed only if the image size is a multiple of the MCU size
+        /// along the directions which are mirrored, so that no partial block ends up inside
+        /// the image; otherwise, the caller has to transform the pixels.
+        ///
+        /// Only the Huffman table optimization and the progressive mode of @c profile apply,
+        /// since the quantized coefficients are left untouched.
+        ///
+        /// @return @c true if the image has been transformed, @c false if it is not eligible.
+        ///
+        /// @throws std::runtime_error The data is not a valid JPEG image.
+        static bool transform(const std::vector<byte>& input, std::vector<byte>& output, Transform transform,
+                              const EncodeProfile& profile = EncodeProfile());
+
+        /// The counters of the encodings performed by encode() and transform(), to weigh the
+        /// size of the output against the time spent producing it.
+        struct Statistics
+        {
+            uint64_t encodes;            ///< The number of images encoded from pixels.
+            uint64_t transforms;         ///< The number of lossless transformations.
+            uint64_t outputBytes;        ///< The total size of the produced images.
+            uint64_t encodeMicroseconds; ///< The total time spent encoding and transforming.
+        };
+
+        /// Gets a snapshot of the counters.
+        static Statistics getStatistics();
+    };
+}
+
+#endif
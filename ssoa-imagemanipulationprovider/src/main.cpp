@@ -2,15 +2,24 @@
  * main.cpp
  */
 
+#include <admissioncontroller.h>
+#include <bandpool.h>
+#include <imagehelper.h>
+#include <resultcache.h>
 #include <rotateimageserviceimpl.h>
 #include <horizontalflipimageserviceimpl.h>
+#include <thumbnailserviceimpl.h>
+#include <transformimageserviceimpl.h>
+#include <transformstoredimageserviceimpl.h>
 
+#include <algorithm>
 #include <iostream>
 
 #include <boost/lexical_cast.hpp>
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/parsers.hpp>
 #include <boost/program_options/variables_map.hpp>
+#include <boost/thread/thread.hpp>
 
 #include <ssoa/logger.h>
 #include <ssoa/registry/registry.h>
@@ -38,11 +47,40 @@ void deregisterService(const string& address, const string& port)
     Logger::info("Deregistered service '%1%' from the registry.", T::serviceSignature());
 }
 
+/// Deregisters all services, so that the registry stops routing requests to this provider.
+bool deregisterServices(const string& address, const string& port)
+{
+    try {
+        deregisterService<RotateImageServiceImpl>(address, port);
+        deregisterService<HorizontalFlipImageServiceImpl>(address, port);
+        deregisterService<ThumbnailServiceImpl>(address, port);
+        deregisterService<TransformImageServiceImpl>(address, port);
+        deregisterService<TransformStoredImageServiceImpl>(address, port);
+    }
+    catch (const exception& e) {
+        Logger::error("Exception while deregistering services: %1%", e.what());
+        return false;
+    }
+    return true;
+}
+
 int main(int argc, char* argv[])
 {
     string address, port;
     string registryAddress, registryPort;
     int num_threads;
+    int computeThreads;
+    int drainTimeout;
+    int idleTimeout;
+    int maxConnections;
+    int maxPayload;
+    int maxQueued;
+    int bandThreads;
+    int cacheSize;
+    int memoryBudget;
+    int maxWaiting;
+    EncodeProfile encodeProfile;
+    string subsampling;
 
     po::options_description description("Allowed options");
     description.add_options()
@@ -57,6 +95,39 @@ int main(int argc, char* argv[])
             "Specifies the port of the registry")
         ("threads,n", po::value<int>(&num_threads)->default_value(10),
             "Specifies the number of threads in the pool")
+        ("io-service-per-thread", "Runs an io_service per thread, pinned to a core and accepting connections "
+            "on its own SO_REUSEPORT socket, instead of sharing one among all threads")
+        ("compute-threads,t", po::value<int>(&computeThreads)->default_value(
+                boost::thread::hardware_concurrency()),
+            "Specifies the number of threads invoking the services (0 invokes them on the network threads)")
+        ("drain-timeout", po::value<int>(&drainTimeout)->default_value(30),
+            "Specifies how long the requests in progress may take to complete on shutdown, in seconds")
+        ("idle-timeout", po::value<int>(&idleTimeout)->default_value(30),
+            "Specifies how long a client may take to send a request or receive the response, in seconds")
+        ("max-connections", po::value<int>(&maxConnections)->default_value(1024),
+            "Specifies the connections in progress above which new ones wait in the backlog (0: no limit)")
+        ("max-payload", po::value<int>(&maxPayload)->default_value(256),
+            "Specifies the request payloads in progress, in MiB, above which new connections wait and "
+            "requests fail (0: no limit)")
+        ("max-queued", po::value<int>(&maxQueued)->default_value(256),
+            "Specifies the requests waiting for a compute thread above which new ones are rejected as busy "
+            "(0: no limit)")
+        ("band-threads,b", po::value<int>(&bandThreads)->default_value(
+                std::max(1u, boost::thread::hardware_concurrency()) - 1),
+            "Specifies the number of threads helping to process bands of large images, when services "
+            "run on the network threads (otherwise, bands are stolen by idle compute threads)")
+        ("cache-size,c", po::value<int>(&cacheSize)->default_value(64),
+            "Specifies the memory used to cache results, in MiB (0 disables the cache)")
+        ("memory-budget,m", po::value<int>(&memoryBudget)->default_value(1024),
+            "Specifies the memory available to the images being processed, in MiB")
+        ("max-waiting,w", po::value<int>(&maxWaiting)->default_value(32),
+            "Specifies the number of requests waiting for memory before new ones are rejected as busy")
+        ("jpeg-quality,q", po::value<int>(&encodeProfile.quality)->default_value(encodeProfile.quality),
+            "Specifies the quality of encoded images, between 1 and 100")
+        ("jpeg-subsampling,s", po::value<string>(&subsampling)->default_value("420"),
+            "Specifies the chroma subsampling of encoded images: 444, 422 or 420")
+        ("jpeg-no-optimize", "Disables the optimization of Huffman tables (faster, larger images)")
+        ("jpeg-progressive", "Encodes progressive images (slower, usually smaller images)")
         ("log-marker,l", po::value<string>(&Logger::marker),
             "Specifies a string printed at the beginning of every log message");
 
@@ -85,6 +156,26 @@ int main(int argc, char* argv[])
         cerr << "Registry port not specified!" << endl;
         return EXIT_FAILURE;
     }
+    if (encodeProfile.quality < 1 || encodeProfile.quality > 100) {
+        cerr << "Invalid JPEG quality!" << endl;
+        return EXIT_FAILURE;
+    }
+    if (subsampling == "444") {
+        encodeProfile.subsampling = EncodeProfile::SUBSAMPLING_444;
+    }
+    else if (subsampling == "422") {
+        encodeProfile.subsampling = EncodeProfile::SUBSAMPLING_422;
+    }
+    else if (subsampling == "420") {
+        encodeProfile.subsampling = EncodeProfile::SUBSAMPLING_420;
+    }
+    else {
+        cerr << "Invalid chroma subsampling!" << endl;
+        return EXIT_FAILURE;
+    }
+    encodeProfile.optimize = vm.find("jpeg-no-optimize") == vm.end();
+    encodeProfile.progressive = vm.find("jpeg-progressive") != vm.end();
+    ImageHelper::setEncodeProfile(encodeProfile);
 
     // Initialize the library
     ssoa::setup();
@@ -95,16 +186,43 @@ int main(int argc, char* argv[])
     try {
         registerService<RotateImageServiceImpl>(address, port);
         registerService<HorizontalFlipImageServiceImpl>(address, port);
+        registerService<ThumbnailServiceImpl>(address, port);
+        registerService<TransformImageServiceImpl>(address, port);
+        registerService<TransformStoredImageServiceImpl>(address, port);
     }
     catch (const exception& e) {
         Logger::error("Exception while registering services: %1%", e.what());
         return EXIT_FAILURE;
     }
 
+    ResultCache::initialize(static_cast<size_t>(std::max(0, cacheSize)) << 20);
+    AdmissionController::initialize(static_cast<size_t>(std::max(1, memoryBudget)) << 20,
+                                     boost::thread::hardware_concurrency(), std::max(0, maxWaiting));
+    BandPool::initialize(computeThreads > 0 ? 0 : std::max(0, bandThreads));
+    Logger::info("Started %1% band threads.", BandPool::size());
+
+    ServiceSkeleton::setIdleTimeout(std::max(1, idleTimeout) * 1000L);
+
     int status = EXIT_SUCCESS;
+    bool deregistered = false;
     try {
         // Initialize and run the server until stopped.
-        ServiceListener server(address, port, num_threads);
+        ListenerMode mode = vm.find("io-service-per-thread") != vm.end() ?
+            IO_SERVICE_PER_THREAD : SHARED_IO_SERVICE;
+        ServiceListener server(address, port, num_threads, mode, std::max(0, computeThreads));
+        server.setLimits(std::max(0, maxConnections), static_cast<size_t>(std::max(0, maxPayload)) << 20,
+                         std::max(0, maxQueued));
+        server.setDrainTimeout(std::max(0, drainTimeout) * 1000L);
+        server.setDrainHandler([&](bool handover) {
+            // Stop receiving requests before draining. On handover, the new process registers
+            // the services on the same endpoint, which must stay registered.
+            if (!handover && !deregisterServices(address, port)) {
+                status = EXIT_FAILURE;
+            }
+            deregistered = true;
+        });
+        // SIGHUP executes a new instance, which takes over the listening sockets.
+        server.enableHotRestart(argv);
         Logger::info("Server started.");
         server.run();
     }
@@ -113,13 +231,26 @@ int main(int argc, char* argv[])
         // Do not return: deregister services.
         status = EXIT_FAILURE;
     }
+    BandPool::shutdown();
 
-    try {
-        deregisterService<RotateImageServiceImpl>(address, port);
-        deregisterService<HorizontalFlipImageServiceImpl>(address, port);
-    }
-    catch (const exception& e) {
-        Logger::error("Exception while deregistering services: %1%", e.what());
+    ResultCache::Statistics cache = ResultCache::getStatistics();
+    Logger::info("Result cache: %1% hits, %2% misses (%3%%% hit rate), %4% evictions, %5% entries, %6% bytes.",
+                 cache.hits, cache.misses,
+                 cache.hits + cache.misses > 0 ? 100 * cache.hits / (cache.hits + cache.misses) : 0,
+                 cache.evictions, cache.entries, cache.bytes);
+
+    AdmissionController::Statistics admission = AdmissionController::getStatistics();
+    Logger::info("Admission control: %1% requests admitted (%2% after waiting), %3% rejected.",
+                 admission.admitted, admission.waited, admission.rejected);
+
+    ImageHelper::Statistics images = ImageHelper::getStatistics();
+    JpegCodec::Statistics codec = JpegCodec::getStatistics();
+    Logger::info("Images: %1% operations, %2% bytes in, %3% bytes out.",
+                 images.operations, images.inputBytes, images.outputBytes);
+    Logger::info("JPEG encoding: %1% encodes, %2% lossless transforms, %3% bytes in %4% ms.",
+                 codec.encodes, codec.transforms, codec.outputBytes, codec.encodeMicroseconds / 1000);
+
+    if (!deregistered && !deregisterServices(address, port)) {
         return EXIT_FAILURE;
     }
 
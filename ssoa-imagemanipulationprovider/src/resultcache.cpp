@@ -0,0 +1,117 @@
+/*
+ * resultcache.cpp
+ */
+
+#include <resultcache.h>
+
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/uuid/detail/sha1.hpp>
+
+using std::string;
+using std::vector;
+
+namespace imagemanipulationprovider
+{
+    namespace
+    {
+        typedef std::shared_ptr<const vector<unsigned char>> Result;
+
+        /// The entries from the most to the least recently used one.
+        typedef std::list<std::pair<string, Result>> EntryList;
+
+        boost::mutex mutex;
+        EntryList entries;
+        std::unordered_map<string, EntryList::iterator> index;
+        std::size_t maxBytes = 0;
+        ResultCache::Statistics statistics = { 0, 0, 0, 0, 0 };
+
+        std::size_t entrySize(const string& key, const Result& result)
+        {
+            return key.size() + result->size();
+        }
+    }
+
+    void ResultCache::initialize(std::size_t bytes)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        maxBytes = bytes;
+    }
+
+    bool ResultCache::isEnabled()
+    {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        return maxBytes > 0;
+    }
+
+    string ResultCache::makeKey(const vector<byte>& input, const string& operation)
+    {
+        boost::uuids::detail::sha1 sha1;
+        sha1.process_bytes(input.data(), input.size());
+        unsigned int digest[5];
+        sha1.get_digest(digest);
+
+        char hex[41];
+        for (int i = 0; i < 5; i++) {
+            std::snprintf(hex + 8 * i, 9, "%08x", digest[i]);
+        }
+        return string(hex, 40) + ' ' + operation;
+    }
+
+    bool ResultCache::lookup(const string& key, vector<byte>& output)
+    {
+        Result result;
+        {
+            boost::lock_guard<boost::mutex> lock(mutex);
+            if (maxBytes == 0) {
+                return false;
+            }
+            auto it = index.find(key);
+            if (it == index.end()) {
+                statistics.misses++;
+                return false;
+            }
+            statistics.hits++;
+            entries.splice(entries.begin(), entries, it->second);
+            result = it->second->second;
+        }
+        // Copy outside the lock: the result is immutable and kept alive by the shared pointer.
+        output = *result;
+        return true;
+    }
+
+    void ResultCache::store(const string& key, const vector<byte>& output)
+    {
+        Result result = std::make_shared<const vector<byte>>(output);
+        const std::size_t size = entrySize(key, result);
+
+        boost::lock_guard<boost::mutex> lock(mutex);
+        if (size > maxBytes / 4 || index.find(key) != index.end()) {
+            return;
+        }
+        while (statistics.bytes + size > maxBytes) {
+            const EntryList::value_type& last = entries.back();
+            statistics.bytes -= entrySize(last.first, last.second);
+            statistics.evictions++;
+            index.erase(last.first);
+            entries.pop_back();
+        }
+        entries.emplace_front(key, std::move(result));
+        index[key] = entries.begin();
+        statistics.bytes += size;
+        statistics.entries = entries.size();
+    }
+
+    ResultCache::Statistics ResultCache::getStatistics()
+    {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        statistics.entries = entries.size();
+        return statistics;
+    }
+}
@@ -0,0 +1,65 @@
+/*
+ * resultcache.h
+ */
+
+#ifndef _RESULTCACHE_H_
+#define _RESULTCACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace imagemanipulationprovider
+{
+    /// A memory-bounded cache of the encoded results of image operations, keyed by the hash
+    /// of the input image and a description of the operation with its parameters.
+    ///
+    /// When full, the least recently used results are evicted. The cache is thread-safe, but
+    /// initialize() should be called just once at program startup; until then, nothing is
+    /// cached.
+    class ResultCache
+    {
+        typedef unsigned char byte;
+
+    public:
+        /// The counters of the cache.
+        struct Statistics
+        {
+            uint64_t hits;
+            uint64_t misses;
+            uint64_t evictions;
+            std::size_t entries;
+            std::size_t bytes;
+        };
+
+        /// Sets the maximum memory used by the cached results.
+        ///
+        /// @param maxBytes The maximum size of keys and results; 0 disables the cache.
+        static void initialize(std::size_t maxBytes);
+
+        /// Gets whether the cache is enabled, i.e. whether results are worth looking up.
+        static bool isEnabled();
+
+        /// Computes the key of an operation on an image.
+        ///
+        /// @param input The encoded input image.
+        /// @param operation The operation and its parameters, in a canonical form so that
+        ///        equivalent operations share their results.
+        static std::string makeKey(const std::vector<byte>& input, const std::string& operation);
+
+        /// Looks up a result, marking it as recently used.
+        ///
+        /// @return Whether the result was found, in which case it has been copied to @c output.
+        static bool lookup(const std::string& key, std::vector<byte>& output);
+
+        /// Stores a result, evicting the least recently used ones to make room for it.
+        /// Results larger than a quarter of the cache are not stored.
+        static void store(const std::string& key, const std::vector<byte>& output);
+
+        /// Gets a snapshot of the counters.
+        static Statistics getStatistics();
+    };
+}
+
+#endif
@@ -12,16 +12,14 @@ using namespace ssoa;
 
 namespace imagemanipulationprovider
 {
-    Response * RotateImageServiceImpl::invoke()
+    Response * RotateImageServiceImpl::process()
     {
-        std::unique_ptr<ServiceIntArgument> degrees(popArgument<ServiceIntArgument>());
-        std::unique_ptr<ServiceBufferArgument> inputBuffer(popArgument<ServiceBufferArgument>());
+        int degrees = inputArgument<0>().getValue();
+        const vector<byte>& input = inputArgument<1>().getValue();
 
         vector<byte> buffer;
-        ImageHelper::rotate(inputBuffer->getValue(), buffer, (float)degrees->getValue());
+        ImageHelper::rotate(input, buffer, (float)degrees);
 
-        Response * response = new Response(serviceSignature(), true, "OK");
-        response->pushArgument(new ServiceBufferArgument(std::move(buffer)));
-        return response;
+        return respond(std::move(buffer));
     }
 }
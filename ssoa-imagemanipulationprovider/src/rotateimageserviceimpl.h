@@ -5,16 +5,16 @@
 #ifndef _ROTATEIMAGESERVICEIMPL_H_
 #define _ROTATEIMAGESERVICEIMPL_H_
 
-#include <ssoa/service/servicesignature.h>
-#include <ssoa/service/serviceskeleton.h>
+#include <imageserviceskeleton.h>
+#include <imagemanipulationprovider/rotateimageservice.h>
 
 namespace imagemanipulationprovider
 {
     /// Implements the "RotateImage" service.
-    class RotateImageServiceImpl: public ssoa::ServiceSkeleton
+    class RotateImageServiceImpl: public ImageServiceSkeleton<RotateImageSignature>
     {
         RotateImageServiceImpl(arg_deque arguments) :
-            ssoa::ServiceSkeleton(ssoa::ServiceSignature(serviceSignature()), std::move(arguments))
+            ImageServiceSkeleton<RotateImageSignature>(std::move(arguments))
         {
         }
 
@@ -24,17 +24,13 @@ namespace imagemanipulationprovider
             return new RotateImageServiceImpl(std::move(arguments));
         }
 
-        /// Gets the signature of this type of service.
-        static const char * serviceSignature() {
-            return "RotateImage(in int, in buffer, out buffer)";
-        }
-
         /// Installs the creation method.
         static void install() {
             factory().install(serviceSignature(), create);
         }
 
-        virtual ssoa::Response * invoke();
+    protected:
+        virtual ssoa::Response * process();
     };
 }
 
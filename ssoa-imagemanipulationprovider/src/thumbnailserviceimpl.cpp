@@ -0,0 +1,25 @@
+/*
+ * thumbnailserviceimpl.cpp
+ */
+
+#include <thumbnailserviceimpl.h>
+#include <imagehelper.h>
+
+#include <vector>
+
+using std::vector;
+using namespace ssoa;
+
+namespace imagemanipulationprovider
+{
+    Response * ThumbnailServiceImpl::process()
+    {
+        int maxSize = inputArgument<0>().getValue();
+        const vector<byte>& input = inputArgument<1>().getValue();
+
+        vector<byte> buffer;
+        ImageHelper::thumbnail(input, buffer, maxSize);
+
+        return respond(std::move(buffer));
+    }
+}
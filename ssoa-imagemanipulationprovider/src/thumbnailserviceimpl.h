@@ -0,0 +1,37 @@
+/*
+ * thumbnailserviceimpl.h
+ */
+
+#ifndef _THUMBNAILSERVICEIMPL_H_
+#define _THUMBNAILSERVICEIMPL_H_
+
+#include <imageserviceskeleton.h>
+#include <imagemanipulationprovider/thumbnailservice.h>
+
+namespace imagemanipulationprovider
+{
+    /// Implements the "Thumbnail" service.
+    class ThumbnailServiceImpl: public ImageServiceSkeleton<ThumbnailSignature>
+    {
+        ThumbnailServiceImpl(arg_deque arguments) :
+            ImageServiceSkeleton<ThumbnailSignature>(std::move(arguments))
+        {
+        }
+
+    public:
+        /// Constructs a new instance of ThumbnailServiceImpl from the given arguments.
+        static ssoa::ServiceSkeleton* create(arg_deque&& arguments) {
+            return new ThumbnailServiceImpl(std::move(arguments));
+        }
+
+        /// Installs the creation method.
+        static void install() {
+            factory().install(serviceSignature(), create);
+        }
+
+    protected:
+        virtual ssoa::Response * process();
+    };
+}
+
+#endif
@@ -0,0 +1,25 @@
+/*
+ * transformimageserviceimpl.cpp
+ */
+
+#include <transformimageserviceimpl.h>
+#include <imagehelper.h>
+
+#include <vector>
+
+using std::vector;
+using namespace ssoa;
+
+namespace imagemanipulationprovider
+{
+    Response * TransformImageServiceImpl::process()
+    {
+        const std::string& operations = inputArgument<0>().getValue();
+        const vector<byte>& input = inputArgument<1>().getValue();
+
+        vector<byte> buffer;
+        ImageHelper::transform(ImagePipeline(operations), input, buffer);
+
+        return respond(std::move(buffer));
+    }
+}
@@ -0,0 +1,37 @@
+/*
+ * transformimageserviceimpl.h
+ */
+
+#ifndef _TRANSFORMIMAGESERVICEIMPL_H_
+#define _TRANSFORMIMAGESERVICEIMPL_H_
+
+#include <imageserviceskeleton.h>
+#include <imagemanipulationprovider/transformimageservice.h>
+
+namespace imagemanipulationprovider
+{
+    /// Implements the "TransformImage" service.
+    class TransformImageServiceImpl: public ImageServiceSkeleton<TransformImageSignature>
+    {
+        TransformImageServiceImpl(arg_deque arguments) :
+            ImageServiceSkeleton<TransformImageSignature>(std::move(arguments))
+        {
+        }
+
+    public:
+        /// Constructs a new instance of TransformImageServiceImpl from the given arguments.
+        static ssoa::ServiceSkeleton* create(arg_deque&& arguments) {
+            return new TransformImageServiceImpl(std::move(arguments));
+        }
+
+        /// Installs the creation method.
+        static void install() {
+            factory().install(serviceSignature(), create);
+        }
+
+    protected:
+        virtual ssoa::Response * process();
+    };
+}
+
+#endif
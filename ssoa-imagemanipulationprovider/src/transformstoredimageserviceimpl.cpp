@@ -0,0 +1,55 @@
+/*
+ * transformstoredimageserviceimpl.cpp
+ */
+
+#include <transformstoredimageserviceimpl.h>
+#include <imagehelper.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <ssoa/logger.h>
+#include <ssoa/registry/registry.h>
+#include <storageprovider/getimageservice.h>
+#include <storageprovider/storeimageservice.h>
+
+using std::string;
+using std::vector;
+using namespace ssoa;
+using namespace storageprovider;
+
+namespace imagemanipulationprovider
+{
+    Response * TransformStoredImageServiceImpl::process()
+    {
+        const string& operations = inputArgument<0>().getValue();
+        const string& source = inputArgument<1>().getValue();
+        const string& destination = inputArgument<2>().getValue();
+
+        // Parse the operations before wasting time retrieving the image.
+        ImagePipeline pipeline(operations);
+
+        vector<byte> input, output;
+        std::pair<string, string> provider = Registry::getProvider(GetImageService::serviceSignature());
+        GetImageService getImage(provider.first, provider.second);
+        getImage.setTimeout(getTimeout());
+        if (!getImage.invoke(source, input)) {
+            throw std::runtime_error("Cannot retrieve image '" + source + "': "
+                                     + getImage.getStatus());
+        }
+
+        ImageHelper::transform(pipeline, input, output);
+
+        provider = Registry::getProvider(StoreImageService::serviceSignature());
+        StoreImageService storeImage(provider.first, provider.second);
+        storeImage.setTimeout(getTimeout());
+        if (!storeImage.invoke(destination, std::move(output))) {
+            throw std::runtime_error("Cannot store image '" + destination + "': "
+                                     + storeImage.getStatus());
+        }
+        Logger::info("Transformed image '%1%' into '%2%'.", source, destination);
+
+        return respond();
+    }
+}
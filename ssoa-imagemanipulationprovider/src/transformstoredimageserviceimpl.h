@@ -0,0 +1,38 @@
+/*
+ * transformstoredimageserviceimpl.h
+ */
+
+#ifndef _TRANSFORMSTOREDIMAGESERVICEIMPL_H_
+#define _TRANSFORMSTOREDIMAGESERVICEIMPL_H_
+
+#include <imageserviceskeleton.h>
+#include <imagemanipulationprovider/transformstoredimageservice.h>
+
+namespace imagemanipulationprovider
+{
+    /// Implements the "TransformStoredImage" service, which reads the image from the storage
+    /// provider and writes the result back to it.
+    class TransformStoredImageServiceImpl: public ImageServiceSkeleton<TransformStoredImageSignature>
+    {
+        TransformStoredImageServiceImpl(arg_deque arguments) :
+            ImageServiceSkeleton<TransformStoredImageSignature>(std::move(arguments))
+        {
+        }
+
+    public:
+        /// Constructs a new instance of TransformStoredImageServiceImpl from the given arguments.
+        static ssoa::ServiceSkeleton* create(arg_deque&& arguments) {
+            return new TransformStoredImageServiceImpl(std::move(arguments));
+        }
+
+        /// Installs the creation method.
+        static void install() {
+            factory().install(serviceSignature(), create);
+        }
+
+    protected:
+        virtual ssoa::Response * process();
+    };
+}
+
+#endif
@@ -33,6 +33,8 @@ int main(int argc, char* argv[])
             "Listens on the given local port")
         ("threads,n", po::value<int>(&num_threads)->default_value(10),
             "Specifies the number of threads in the pool")
+        ("io-service-per-thread", "Runs an io_service per thread, pinned to a core and accepting connections "
+            "on its own SO_REUSEPORT socket, instead of sharing one among all threads")
         ("log-marker,l", po::value<string>(&Logger::marker),
             "Specifies a string printed at the beginning of every log message");
 
@@ -66,7 +68,9 @@ int main(int argc, char* argv[])
         RegistryImpl registry;
 
         // Initialize and run the server until stopped.
-        ssoa::RegistryListener server(address, port, num_threads, registry);
+        ssoa::ListenerMode mode = vm.find("io-service-per-thread") != vm.end() ?
+            ssoa::IO_SERVICE_PER_THREAD : ssoa::SHARED_IO_SERVICE;
+        ssoa::RegistryListener server(address, port, num_threads, registry, mode);
         server.run();
     }
     catch (const exception& e) {
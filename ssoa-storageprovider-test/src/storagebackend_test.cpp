@@ -0,0 +1,504 @@
+#define BOOST_TEST_MODULE storagebackend_test
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MAIN
+
+#include <dedupstoragebackend.h>
+#include <filestoragebackend.h>
+#include <segmentstoragebackend.h>
+#include <writebehindstoragebackend.h>
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+using namespace storageprovider;
+using std::string;
+using std::vector;
+
+typedef unsigned char byte;
+
+/// Creates a temporary folder for each test case and removes it at the end.
+struct TemporaryFolder
+{
+    TemporaryFolder() :
+        path((boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string())
+    {
+    }
+
+    ~TemporaryFolder() {
+        boost::system::error_code ignored_ec;
+        boost::filesystem::remove_all(path, ignored_ec);
+    }
+
+    size_t countFiles(const string& subfolder) const {
+        size_t count = 0;
+        boost::filesystem::path folder = boost::filesystem::path(path) / subfolder;
+        for (boost::filesystem::recursive_directory_iterator it(folder), end; it != end; ++it) {
+            if (boost::filesystem::is_regular_file(it->status())) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    string path;
+};
+
+/// Checks loading ranges and versions, which are common to all backends.
+void checkRangeAndVersion(IStorageBackend& storage)
+{
+    vector<byte> a { 1, 2, 3, 4, 5 }, b { 6, 7, 8, 9, 10, 11 }, result;
+
+    BOOST_CHECK_THROW(storage.getVersion("a.jpg"), std::runtime_error);
+    BOOST_CHECK_THROW(storage.loadFile("a.jpg", 0, 1, result), std::runtime_error);
+
+    storage.saveFile("a.jpg", a);
+    string version = storage.getVersion("a.jpg");
+    BOOST_CHECK_EQUAL(storage.getVersion("a.jpg"), version);
+
+    BOOST_CHECK_EQUAL(storage.loadFile("a.jpg", 1, 3, result), 5);
+    BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), a.begin() + 1, a.begin() + 4);
+    BOOST_CHECK_EQUAL(storage.loadFile("a.jpg", 3, 100, result), 5);
+    BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), a.begin() + 3, a.end());
+    BOOST_CHECK_EQUAL(storage.loadFile("a.jpg", 7, 2, result), 5);
+    BOOST_CHECK(result.empty());
+
+    storage.saveFile("a.jpg", b);
+    BOOST_CHECK_NE(storage.getVersion("a.jpg"), version);
+    BOOST_CHECK_EQUAL(storage.loadFile("a.jpg", 4, 2, result), 6);
+    BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), b.begin() + 4, b.end());
+}
+
+BOOST_FIXTURE_TEST_SUITE(files, TemporaryFolder)
+
+    BOOST_AUTO_TEST_CASE( save_load_test )
+    {
+        FileStorageBackend storage(path);
+        vector<byte> a { 1, 2, 3 }, b { 4, 5 }, result;
+
+        BOOST_CHECK(storage.getList().empty());
+        BOOST_CHECK_THROW(storage.loadFile("a.jpg", result), std::runtime_error);
+
+        storage.saveFile("a.jpg", a);
+        storage.saveFile("b.jpg", b);
+        storage.loadFile("a.jpg", result);
+        BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), a.begin(), a.end());
+
+        storage.saveFile("a.jpg", b);
+        storage.loadFile("a.jpg", result);
+        BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), b.begin(), b.end());
+
+        vector<string> list = storage.getList();
+        std::sort(list.begin(), list.end());
+        BOOST_REQUIRE_EQUAL(list.size(), 2);
+        BOOST_CHECK_EQUAL(list[0], "a.jpg");
+        BOOST_CHECK_EQUAL(list[1], "b.jpg");
+    }
+
+    BOOST_AUTO_TEST_CASE( range_version_test )
+    {
+        FileStorageBackend storage(path);
+        checkRangeAndVersion(storage);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(dedup, TemporaryFolder)
+
+    BOOST_AUTO_TEST_CASE( hash_test )
+    {
+        vector<byte> empty, abc { 'a', 'b', 'c' };
+        BOOST_CHECK_EQUAL(DedupStorageBackend::contentHash(empty), "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+        BOOST_CHECK_EQUAL(DedupStorageBackend::contentHash(abc), "a9993e364706816aba3e25717850c26c9cd0d89d");
+    }
+
+    BOOST_AUTO_TEST_CASE( deduplication_test )
+    {
+        DedupStorageBackend storage(path);
+        vector<byte> a { 1, 2, 3 }, b { 4, 5 }, result;
+
+        storage.saveFile("a.jpg", a);
+        storage.saveFile("copy/a.jpg", a);
+        storage.saveFile("b.jpg", b);
+        BOOST_CHECK_EQUAL(countFiles("blobs"), 2);
+        BOOST_CHECK_EQUAL(storage.getHash("a.jpg"), storage.getHash("copy/a.jpg"));
+        BOOST_CHECK_NE(storage.getHash("a.jpg"), storage.getHash("b.jpg"));
+
+        storage.loadFile("copy/a.jpg", result);
+        BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), a.begin(), a.end());
+        BOOST_CHECK_THROW(storage.loadFile("c.jpg", result), std::runtime_error);
+        BOOST_CHECK_THROW(storage.saveFile("", a), std::runtime_error);
+        BOOST_CHECK_EQUAL(storage.getList().size(), 3);
+    }
+
+    BOOST_AUTO_TEST_CASE( index_reload_test )
+    {
+        vector<byte> a { 1, 2, 3 }, b { 4, 5 }, result;
+        {
+            DedupStorageBackend storage(path);
+            storage.saveFile("a.jpg", a);
+            storage.saveFile("a.jpg", b);
+            storage.saveFile("a.jpg", a);
+            storage.saveFile("a.jpg", b);
+            storage.saveFile("with space.jpg", a);
+        }
+
+        DedupStorageBackend storage(path);
+        vector<string> list = storage.getList();
+        BOOST_REQUIRE_EQUAL(list.size(), 2);
+        BOOST_CHECK_EQUAL(list[1], "with space.jpg");
+        storage.loadFile("a.jpg", result);
+        BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), b.begin(), b.end());
+        storage.loadFile("with space.jpg", result);
+        BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), a.begin(), a.end());
+    }
+
+    BOOST_AUTO_TEST_CASE( missing_blob_test )
+    {
+        DedupStorageBackend storage(path);
+        vector<byte> a { 1, 2, 3 }, result;
+        storage.saveFile("a.jpg", a);
+        storage.sync();
+
+        // An entry whose blob has been lost must fail cleanly.
+        string hash = storage.getHash("a.jpg");
+        boost::filesystem::remove(boost::filesystem::path(path) / "blobs" / hash.substr(0, 2) / hash);
+        BOOST_CHECK_THROW(storage.loadFile("a.jpg", result), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_CASE( range_version_test )
+    {
+        DedupStorageBackend storage(path);
+        checkRangeAndVersion(storage);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(segments, TemporaryFolder)
+
+    BOOST_AUTO_TEST_CASE( save_load_test )
+    {
+        vector<byte> a { 1, 2, 3 }, b { 4, 5 }, empty, result;
+        {
+            SegmentStorageBackend storage(path, 1 << 20, 3600);
+            BOOST_CHECK(storage.getList().empty());
+            BOOST_CHECK_THROW(storage.loadFile("a.jpg", result), std::runtime_error);
+            BOOST_CHECK_THROW(storage.saveFile("", a), std::runtime_error);
+
+            storage.saveFile("a.jpg", a);
+            storage.saveFile("b.jpg", b);
+            storage.saveFile("a.jpg", b);
+            storage.saveFile("empty.jpg", empty);
+            storage.loadFile("a.jpg", result);
+            BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), b.begin(), b.end());
+            BOOST_CHECK_EQUAL(storage.getList().size(), 3);
+        }
+
+        // The index is rebuilt from the segments
+        SegmentStorageBackend storage(path, 1 << 20, 3600);
+        BOOST_CHECK_EQUAL(storage.getList().size(), 3);
+        storage.loadFile("a.jpg", result);
+        BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), b.begin(), b.end());
+        storage.loadFile("empty.jpg", result);
+        BOOST_CHECK(result.empty());
+    }
+
+    BOOST_AUTO_TEST_CASE( compaction_test )
+    {
+        vector<byte> data(1000), result;
+        {
+            // Each segment holds at most two records
+            SegmentStorageBackend storage(path, 2500, 3600);
+            for (int i = 0; i < 10; i++) {
+                data[0] = i;
+                storage.saveFile(i % 2 ? "odd.jpg" : "even.jpg", data);
+            }
+            BOOST_CHECK_EQUAL(countFiles("segments"), 5);
+
+            // All sealed segments contain only overwritten records
+            BOOST_CHECK_EQUAL(storage.compact(), 4);
+            BOOST_CHECK_EQUAL(countFiles("segments"), 1);
+
+            data[0] = 42;
+            storage.saveFile("new.jpg", data);
+            storage.saveFile("even.jpg", data);
+            storage.saveFile("odd.jpg", data);
+            BOOST_CHECK_EQUAL(storage.compact(), 1);
+        }
+
+        SegmentStorageBackend storage(path, 2500, 3600);
+        BOOST_CHECK_EQUAL(storage.getList().size(), 3);
+        storage.loadFile("even.jpg", result);
+        BOOST_CHECK_EQUAL(result[0], 42);
+        storage.loadFile("odd.jpg", result);
+        BOOST_CHECK_EQUAL(result[0], 42);
+        storage.loadFile("new.jpg", result);
+        BOOST_CHECK_EQUAL(result[0], 42);
+    }
+
+    BOOST_AUTO_TEST_CASE( truncated_record_test )
+    {
+        vector<byte> a { 1, 2, 3 }, result;
+        {
+            SegmentStorageBackend storage(path, 1 << 20, 3600);
+            storage.saveFile("a.jpg", a);
+        }
+        {
+            // Simulate a crash in the middle of an append
+            boost::filesystem::ofstream segment(boost::filesystem::path(path) / "segments" / "00000001.seg",
+                                                std::ios::binary | std::ios::app);
+            segment << "SSEG garbage";
+        }
+
+        SegmentStorageBackend storage(path, 1 << 20, 3600);
+        storage.saveFile("b.jpg", a);
+        BOOST_CHECK_EQUAL(storage.getList().size(), 2);
+        storage.loadFile("a.jpg", result);
+        BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), a.begin(), a.end());
+    }
+
+    BOOST_AUTO_TEST_CASE( range_version_test )
+    {
+        SegmentStorageBackend storage(path);
+        checkRangeAndVersion(storage);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+/// Keeps files in memory, counting calls and optionally blocking saveFile() until released.
+class GatedStorageBackend: public IStorageBackend
+{
+public:
+    GatedStorageBackend() :
+        saves(0), syncs(0), blocked(false), closed(false), failing(false)
+    {
+    }
+
+    virtual vector<string> getList() {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        vector<string> list;
+        for (const auto& file : files) {
+            list.push_back(file.first);
+        }
+        return list;
+    }
+
+    virtual void loadFile(const string& filename, vector<byte>& buffer) {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        auto it = files.find(filename);
+        if (it == files.end()) {
+            throw std::runtime_error("Not found");
+        }
+        buffer = it->second;
+    }
+
+    virtual uint64_t loadFile(const string& filename, uint64_t offset, size_t length, vector<byte>& buffer) {
+        loadFile(filename, buffer);
+        uint64_t size = buffer.size();
+        buffer.erase(buffer.begin(), buffer.begin() + std::min<uint64_t>(offset, size));
+        buffer.resize(std::min<uint64_t>(length, buffer.size()));
+        return size;
+    }
+
+    virtual string getVersion(const string& filename) {
+        vector<byte> buffer;
+        loadFile(filename, buffer);
+        return DedupStorageBackend::contentHash(buffer);
+    }
+
+    virtual void saveFile(const string& filename, const vector<byte>& buffer) {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        blocked = true;
+        condition.notify_all();
+        while (closed) {
+            condition.wait(lock);
+        }
+        blocked = false;
+        if (failing) {
+            throw std::runtime_error("Disk full");
+        }
+        files[filename] = buffer;
+        saves++;
+    }
+
+    virtual void sync() {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        syncs++;
+    }
+
+    /// Makes saveFile() block until open() is called.
+    void close() {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        closed = true;
+    }
+
+    void open() {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        closed = false;
+        condition.notify_all();
+    }
+
+    /// Waits until a call to saveFile() is blocked.
+    void waitBlocked() {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        while (!blocked) {
+            condition.wait(lock);
+        }
+    }
+
+    std::map<string, vector<byte>> files;
+    int saves, syncs;
+    bool blocked, closed, failing;
+    boost::mutex mutex;
+    boost::condition_variable condition;
+};
+
+BOOST_FIXTURE_TEST_SUITE(writebehind, TemporaryFolder)
+
+    BOOST_AUTO_TEST_CASE( save_load_test )
+    {
+        vector<byte> a { 1, 2, 3 }, b { 4, 5 }, result;
+        {
+            std::unique_ptr<IStorageBackend> backend(new FileStorageBackend(path));
+            WriteBehindStorageBackend storage(std::move(backend), WriteBehindStorageBackend::ACK_ON_ENQUEUE);
+
+            storage.saveFile("a.jpg", a);
+            storage.saveFile("b.jpg", b);
+            storage.loadFile("a.jpg", result);
+            BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), a.begin(), a.end());
+            BOOST_CHECK_EQUAL(storage.getList().size(), 2);
+
+            storage.sync();
+            storage.saveFile("a.jpg", b);
+        }
+
+        FileStorageBackend storage(path);
+        storage.loadFile("a.jpg", result);
+        BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), b.begin(), b.end());
+        storage.loadFile("b.jpg", result);
+        BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), b.begin(), b.end());
+    }
+
+    BOOST_AUTO_TEST_CASE( group_commit_test )
+    {
+        GatedStorageBackend* gated = new GatedStorageBackend();
+        WriteBehindStorageBackend storage(std::unique_ptr<IStorageBackend>(gated),
+                                          WriteBehindStorageBackend::ACK_ON_ENQUEUE);
+        vector<byte> a { 1 }, b { 2 }, c { 3 }, result;
+
+        gated->close();
+        storage.saveFile("a.jpg", a);
+        gated->waitBlocked();
+
+        // Queued while the first group is being written: they form a single group.
+        storage.saveFile("a.jpg", b);
+        storage.saveFile("b.jpg", b);
+        storage.saveFile("a.jpg", c);
+
+        storage.loadFile("a.jpg", result);
+        BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), c.begin(), c.end());
+        BOOST_CHECK_EQUAL(storage.getList().size(), 2);
+
+        gated->open();
+        storage.sync();
+        BOOST_CHECK_EQUAL(gated->saves, 3);
+        BOOST_CHECK_EQUAL(gated->syncs, 2);
+        BOOST_CHECK(gated->files["a.jpg"] == c);
+        BOOST_CHECK(gated->files["b.jpg"] == b);
+    }
+
+    BOOST_AUTO_TEST_CASE( failure_test )
+    {
+        GatedStorageBackend* gated = new GatedStorageBackend();
+        WriteBehindStorageBackend storage(std::unique_ptr<IStorageBackend>(gated),
+                                          WriteBehindStorageBackend::ACK_ON_SYNC);
+        vector<byte> a { 1 }, result;
+
+        storage.saveFile("a.jpg", a);
+        BOOST_CHECK_EQUAL(gated->syncs, 1);
+
+        gated->failing = true;
+        BOOST_CHECK_THROW(storage.saveFile("b.jpg", a), std::runtime_error);
+        BOOST_CHECK_THROW(storage.loadFile("b.jpg", result), std::runtime_error);
+        BOOST_CHECK_THROW(storage.sync(), std::runtime_error);
+        BOOST_CHECK_NO_THROW(storage.sync());
+    }
+
+    BOOST_AUTO_TEST_CASE( grouped_failure_test )
+    {
+        GatedStorageBackend* gated = new GatedStorageBackend();
+        WriteBehindStorageBackend storage(std::unique_ptr<IStorageBackend>(gated),
+                                          WriteBehindStorageBackend::ACK_ON_SYNC);
+        vector<byte> a { 1 }, b { 2 }, result;
+        bool failed[3] = { false, false, false };
+        auto save = [&](int i, string filename, const vector<byte>& data) {
+            try {
+                storage.saveFile(filename, data);
+            }
+            catch (const std::runtime_error&) {
+                failed[i] = true;
+            }
+        };
+
+        gated->close();
+        boost::thread first(save, 0, "x.jpg", a);
+        gated->waitBlocked();
+
+        // Two writes of the same file in the next group: only the second one is saved.
+        boost::thread second(save, 1, "a.jpg", a);
+        while (storage.getList().size() < 2) {
+            boost::this_thread::yield();
+        }
+        boost::thread third(save, 2, "a.jpg", b);
+        do {
+            boost::this_thread::yield();
+            storage.loadFile("a.jpg", result);
+        } while (result != b);
+
+        gated->failing = true;
+        gated->open();
+        first.join();
+        second.join();
+        third.join();
+        BOOST_CHECK(failed[0]);
+        BOOST_CHECK(failed[1]);
+        BOOST_CHECK(failed[2]);
+    }
+
+    BOOST_AUTO_TEST_CASE( range_version_test )
+    {
+        std::unique_ptr<IStorageBackend> backend(new SegmentStorageBackend(path));
+        WriteBehindStorageBackend storage(std::move(backend), WriteBehindStorageBackend::ACK_ON_ENQUEUE);
+        checkRangeAndVersion(storage);
+    }
+
+    BOOST_AUTO_TEST_CASE( pending_range_version_test )
+    {
+        GatedStorageBackend* gated = new GatedStorageBackend();
+        WriteBehindStorageBackend storage(std::unique_ptr<IStorageBackend>(gated),
+                                          WriteBehindStorageBackend::ACK_ON_ENQUEUE);
+        vector<byte> a { 1, 2, 3 }, result;
+
+        gated->close();
+        storage.saveFile("a.jpg", a);
+        gated->waitBlocked();
+        string version = storage.getVersion("a.jpg");
+        BOOST_CHECK_EQUAL(storage.loadFile("a.jpg", 1, 1, result), 3);
+        BOOST_REQUIRE_EQUAL(result.size(), 1);
+        BOOST_CHECK_EQUAL(result[0], 2);
+
+        gated->open();
+        storage.sync();
+        BOOST_CHECK_EQUAL(storage.getVersion("a.jpg"), version);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,113 @@
+#include <imagebatch.h>
+#include <storageservice.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+using namespace storageprovider;
+using std::string;
+using std::vector;
+
+typedef unsigned char byte;
+
+BOOST_AUTO_TEST_SUITE(imagebatch_test)
+
+    BOOST_AUTO_TEST_CASE( names_test )
+    {
+        string encoded("a.jpg\0dir/b.jpg\0c", 17);
+        vector<string> names = imagebatch::decodeNames(vector<byte>(encoded.begin(), encoded.end()));
+        BOOST_REQUIRE_EQUAL(names.size(), 3);
+        BOOST_CHECK_EQUAL(names[0], "a.jpg");
+        BOOST_CHECK_EQUAL(names[1], "dir/b.jpg");
+        BOOST_CHECK_EQUAL(names[2], "c");
+        BOOST_CHECK(imagebatch::decodeNames(vector<byte>()).empty());
+    }
+
+    BOOST_AUTO_TEST_CASE( offsets_test )
+    {
+        vector<byte> buffer;
+        imagebatch::encodeOffset(buffer, 3);
+        imagebatch::encodeOffset(buffer, 3);
+        imagebatch::encodeOffset(buffer, 0x10203);
+        BOOST_REQUIRE_EQUAL(buffer.size(), 12);
+        BOOST_CHECK_EQUAL(buffer[9], 1);
+
+        vector<uint32_t> offsets = imagebatch::decodeOffsets(buffer, 0x10203);
+        BOOST_REQUIRE_EQUAL(offsets.size(), 3);
+        BOOST_CHECK_EQUAL(offsets[1], 3);
+        BOOST_CHECK_EQUAL(offsets[2], 0x10203);
+
+        BOOST_CHECK_THROW(imagebatch::decodeOffsets(buffer, 0x10204), std::runtime_error);
+        buffer.pop_back();
+        BOOST_CHECK_THROW(imagebatch::decodeOffsets(buffer, 0x10203), std::runtime_error);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(storageservice_test)
+
+    BOOST_AUTO_TEST_CASE( batch_test )
+    {
+        boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        StorageService::initialize("files", path.string());
+
+        vector<string> names;
+        vector<vector<byte>> images, result;
+        for (int i = 0; i < 20; i++) {
+            names.push_back("image" + std::to_string(i) + ".jpg");
+            images.push_back(vector<byte>(i, static_cast<byte>(i)));
+        }
+        StorageService::saveFiles(names, images);
+        StorageService::loadFiles(names, result);
+        BOOST_CHECK(result == images);
+
+        names.push_back("missing.jpg");
+        BOOST_CHECK_THROW(StorageService::loadFiles(names, result), std::runtime_error);
+
+        // The last content given for a name wins.
+        vector<string> duplicates(8, "duplicate.jpg");
+        images.resize(duplicates.size());
+        StorageService::saveFiles(duplicates, images);
+        StorageService::loadFiles(vector<string>(1, "duplicate.jpg"), result);
+        BOOST_REQUIRE_EQUAL(result.size(), 1);
+        BOOST_CHECK(result[0] == images.back());
+
+        boost::filesystem::remove_all(path);
+    }
+
+    BOOST_AUTO_TEST_CASE( folder_lock_test )
+    {
+        boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        boost::filesystem::create_directories(path);
+
+        // Another process writing the folder, e.g. an instance still draining.
+        int other = open(path.c_str(), O_RDONLY | O_DIRECTORY);
+        BOOST_REQUIRE(other >= 0);
+        BOOST_REQUIRE_EQUAL(flock(other, LOCK_EX | LOCK_NB), 0);
+        BOOST_CHECK_THROW(StorageService::initialize("segments", path.string()), std::runtime_error);
+        close(other);
+
+        StorageService::initialize("segments", path.string(), "enqueue");
+        StorageService::saveFile("a.jpg", vector<byte>(10, 1));
+        other = open(path.c_str(), O_RDONLY | O_DIRECTORY);
+        BOOST_REQUIRE(other >= 0);
+        BOOST_CHECK(flock(other, LOCK_EX | LOCK_NB) != 0);
+
+        // Initializing again releases the folder once the queued writes are saved.
+        StorageService::initialize("segments", path.string());
+        vector<byte> result;
+        StorageService::loadFile("a.jpg", result);
+        BOOST_CHECK(result == vector<byte>(10, 1));
+        close(other);
+
+        boost::filesystem::remove_all(path);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
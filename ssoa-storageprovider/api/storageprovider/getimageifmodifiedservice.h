@@ -0,0 +1,80 @@
+/*
+ * getimageifmodifiedservice.h
+ */
+
+#ifndef _GETIMAGEIFMODIFIEDSERVICE_H_
+#define _GETIMAGEIFMODIFIEDSERVICE_H_
+
+#include <ssoa/service/servicestub.h>
+
+namespace storageprovider
+{
+    /// Represents the service of retrieving an image from the storage provider only if it has
+    /// been modified since a known version.
+    class GetImageIfModifiedService: public ssoa::ServiceStub
+    {
+        /// Just a shortcut.
+        typedef unsigned char byte;
+
+    public:
+        /// Constructs a new instance of GetImageIfModifiedService.
+        ///
+        /// @param host The remote host of the service provider.
+        /// @param port The remote port on which the service is provided.
+        GetImageIfModifiedService(std::string host, std::string port) :
+            ssoa::ServiceStub(ssoa::ServiceSignature(serviceSignature()), host, port), modified(false)
+        {
+        }
+
+        /// Gets the signature of this type of service.
+        static const char * serviceSignature() {
+            return "GetImageIfModified(in string, in string, out string, out buffer)";
+        }
+
+        /// Gets a string representing the status of the operation.
+        const std::string& getStatus() const {
+            return status;
+        }
+
+        /// Gets a value indicating whether the last invocation retrieved new image data.
+        bool isModified() const {
+            return modified;
+        }
+
+        /// Executes the service request, that is, retrieves the image with the given name
+        /// from the server unless its version matches the given one.
+        ///
+        /// @param name The name used to identify the image on the server.
+        /// @param version The version of the image held by the client, or an empty string.
+        ///        On success, it is updated to the current version.
+        /// @param buffer The buffer that will contain the image data retrieved from the server;
+        ///        it is left untouched if the image has not been modified.
+        bool invoke(std::string name, std::string& version, std::vector<byte>& buffer) {
+            using namespace std;
+            using namespace ssoa;
+
+            pushArgument(new ServiceStringArgument(name));
+            pushArgument(new ServiceStringArgument(version));
+
+            unique_ptr<Response> response(ServiceStub::submit());
+            modified = false;
+            if (response->isSuccessful()) {
+                unique_ptr<ServiceStringArgument> versionArg(response->popArgument<ServiceStringArgument>());
+                unique_ptr<ServiceBufferArgument> bufferArg(response->popArgument<ServiceBufferArgument>());
+                modified = versionArg->getValue() != version;
+                if (modified) {
+                    version = versionArg->getValue();
+                    buffer = std::move(bufferArg->getValue());
+                }
+            }
+            status = response->getStatus();
+            return response->isSuccessful();
+        }
+
+    private:
+        std::string status;
+        bool modified;
+    };
+}
+
+#endif
@@ -0,0 +1,86 @@
+/*
+ * getimagerangeservice.h
+ */
+
+#ifndef _GETIMAGERANGESERVICE_H_
+#define _GETIMAGERANGESERVICE_H_
+
+#include <ssoa/service/servicestub.h>
+
+namespace storageprovider
+{
+    /// Represents the service of retrieving a byte range of an image from the storage provider.
+    class GetImageRangeService: public ssoa::ServiceStub
+    {
+        /// Just a shortcut.
+        typedef unsigned char byte;
+
+    public:
+        /// Constructs a new instance of GetImageRangeService.
+        ///
+        /// @param host The remote host of the service provider.
+        /// @param port The remote port on which the service is provided.
+        GetImageRangeService(std::string host, std::string port) :
+            ssoa::ServiceStub(ssoa::ServiceSignature(serviceSignature()), host, port), size(0)
+        {
+        }
+
+        /// Gets the signature of this type of service.
+        static const char * serviceSignature() {
+            return "GetImageRange(in string, in int, in int, out string, out int, out buffer)";
+        }
+
+        /// Gets a string representing the status of the operation.
+        const std::string& getStatus() const {
+            return status;
+        }
+
+        /// Gets the version of the image as of the last invocation.
+        ///
+        /// Ranges retrieved with different versions must not be combined.
+        const std::string& getVersion() const {
+            return version;
+        }
+
+        /// Gets the total size of the image as of the last invocation.
+        int32_t getSize() const {
+            return size;
+        }
+
+        /// Executes the service request, that is, retrieves at most @c length bytes of the
+        /// image with the given name, starting at @c offset.
+        ///
+        /// @param name The name used to identify the image on the server.
+        /// @param offset The offset of the first byte to retrieve.
+        /// @param length The maximum number of bytes to retrieve.
+        /// @param buffer The buffer that will contain the bytes retrieved from the server
+        ///        (empty if @c offset is beyond the end of the image).
+        bool invoke(std::string name, int32_t offset, int32_t length, std::vector<byte>& buffer) {
+            using namespace std;
+            using namespace ssoa;
+
+            pushArgument(new ServiceStringArgument(name));
+            pushArgument(new ServiceIntArgument(offset));
+            pushArgument(new ServiceIntArgument(length));
+
+            unique_ptr<Response> response(ServiceStub::submit());
+            if (response->isSuccessful()) {
+                unique_ptr<ServiceStringArgument> versionArg(response->popArgument<ServiceStringArgument>());
+                unique_ptr<ServiceIntArgument> sizeArg(response->popArgument<ServiceIntArgument>());
+                unique_ptr<ServiceBufferArgument> bufferArg(response->popArgument<ServiceBufferArgument>());
+                version = versionArg->getValue();
+                size = sizeArg->getValue();
+                buffer = std::move(bufferArg->getValue());
+            }
+            status = response->getStatus();
+            return response->isSuccessful();
+        }
+
+    private:
+        std::string status;
+        std::string version;
+        int32_t size;
+    };
+}
+
+#endif
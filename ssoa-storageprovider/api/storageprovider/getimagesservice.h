@@ -0,0 +1,93 @@
+/*
+ * getimagesservice.h
+ */
+
+#ifndef _GETIMAGESSERVICE_H_
+#define _GETIMAGESSERVICE_H_
+
+#include <ssoa/service/servicestub.h>
+
+#include <arpa/inet.h>
+
+namespace storageprovider
+{
+    /// Represents the service of retrieving many images from the storage provider at once.
+    class GetImagesService: public ssoa::ServiceStub
+    {
+        /// Just a shortcut.
+        typedef unsigned char byte;
+
+    public:
+        /// Constructs a new instance of GetImagesService.
+        ///
+        /// @param host The remote host of the service provider.
+        /// @param port The remote port on which the service is provided.
+        GetImagesService(std::string host, std::string port) :
+            ssoa::ServiceStub(ssoa::ServiceSignature(serviceSignature()), host, port)
+        {
+        }
+
+        /// Gets the signature of this type of service.
+        static const char * serviceSignature() {
+            return "GetImages(in buffer, out buffer, out buffer)";
+        }
+
+        /// Gets a string representing the status of the operation.
+        const std::string& getStatus() const {
+            return status;
+        }
+
+        /// Executes the service request, that is, retrieves the images with the given names
+        /// from the server. The request fails if any of the images cannot be retrieved.
+        ///
+        /// @param names The names used to identify the images on the server.
+        /// @param images A vector that will contain the data of each image, in the same order.
+        bool invoke(const std::vector<std::string>& names, std::vector<std::vector<byte>>& images) {
+            using namespace std;
+            using namespace ssoa;
+
+            vector<byte> namesBuffer;
+            for (const string& name : names) {
+                namesBuffer.insert(namesBuffer.end(), name.begin(), name.end());
+                namesBuffer.push_back('\0');
+            }
+            pushArgument(new ServiceBufferArgument(std::move(namesBuffer)));
+
+            unique_ptr<Response> response(ServiceStub::submit());
+            status = response->getStatus();
+            if (!response->isSuccessful()) {
+                return false;
+            }
+
+            unique_ptr<ServiceBufferArgument> blobsArg(response->popArgument<ServiceBufferArgument>());
+            unique_ptr<ServiceBufferArgument> offsetsArg(response->popArgument<ServiceBufferArgument>());
+            const vector<byte>& blobs = blobsArg->getValue();
+            const vector<byte>& offsets = offsetsArg->getValue();
+            if (offsets.size() != names.size() * sizeof(uint32_t)) {
+                status = "Received an invalid response (wrong number of offsets).";
+                return false;
+            }
+
+            images.clear();
+            uint32_t begin = 0;
+            for (size_t i = 0; i < names.size(); i++) {
+                uint32_t end;
+                std::copy(offsets.begin() + i * sizeof(end), offsets.begin() + (i + 1) * sizeof(end),
+                          reinterpret_cast<byte*>(&end));
+                end = ntohl(end);
+                if (end < begin || end > blobs.size()) {
+                    status = "Received an invalid response (wrong offsets).";
+                    return false;
+                }
+                images.emplace_back(blobs.begin() + begin, blobs.begin() + end);
+                begin = end;
+            }
+            return true;
+        }
+
+    private:
+        std::string status;
+    };
+}
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ * storeimagesservice.h
+ */
+
+#ifndef _STOREIMAGESSERVICE_H_
+#define _STOREIMAGESSERVICE_H_
+
+#include <ssoa/service/servicestub.h>
+
+#include <arpa/inet.h>
+
+namespace storageprovider
+{
+    /// Represents the service of sending many images to the storage provider at once.
+    class StoreImagesService: public ssoa::ServiceStub
+    {
+        /// Just a shortcut.
+        typedef unsigned char byte;
+
+    public:
+        /// Constructs a new instance of StoreImagesService.
+        ///
+        /// @param host The remote host of the service provider.
+        /// @param port The remote port on which the service is provided.
+        StoreImagesService(std::string host, std::string port) :
+            ssoa::ServiceStub(ssoa::ServiceSignature(serviceSignature()), host, port)
+        {
+        }
+
+        /// Gets the signature of this type of service.
+        static const char * serviceSignature() {
+            return "StoreImages(in buffer, in buffer, in buffer)";
+        }
+
+        /// Gets a string representing the status of the operation.
+        const std::string& getStatus() const {
+            return status;
+        }
+
+        /// Executes the service request, that is, sends many images to the server.
+        ///
+        /// If the request fails, some of the images may have been stored anyway.
+        ///
+        /// @param names The names used to identify the images on the server.
+        /// @param images The data of each image, in the same order as @c names.
+        bool invoke(const std::vector<std::string>& names, const std::vector<std::vector<byte>>& images) {
+            using namespace std;
+            using namespace ssoa;
+
+            if (names.size() != images.size()) {
+                throw std::logic_error("The number of names and images must match.");
+            }
+
+            vector<byte> namesBuffer, blobs, offsets;
+            for (size_t i = 0; i < names.size(); i++) {
+                namesBuffer.insert(namesBuffer.end(), names[i].begin(), names[i].end());
+                namesBuffer.push_back('\0');
+                blobs.insert(blobs.end(), images[i].begin(), images[i].end());
+                uint32_t end = htonl(static_cast<uint32_t>(blobs.size()));
+                offsets.insert(offsets.end(), reinterpret_cast<byte*>(&end), reinterpret_cast<byte*>(&end + 1));
+            }
+            pushArgument(new ServiceBufferArgument(std::move(namesBuffer)));
+            pushArgument(new ServiceBufferArgument(std::move(blobs)));
+            pushArgument(new ServiceBufferArgument(std::move(offsets)));
+
+            unique_ptr<Response> response(ServiceStub::submit());
+            status = response->getStatus();
+            return response->isSuccessful();
+        }
+
+    private:
+        std::string status;
+    };
+}
+
+#endif
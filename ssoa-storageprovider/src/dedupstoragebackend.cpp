@@ -0,0 +1,236 @@
+/*
+ * dedupstoragebackend.cpp
+ */
+
+#include <dedupstoragebackend.h>
+#include <filestoragebackend.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <boost/filesystem.hpp>
+#include <boost/thread/lock_guard.hpp>
+#include <boost/uuid/detail/sha1.hpp>
+
+using std::ifstream;
+using std::ofstream;
+using std::string;
+using std::vector;
+using boost::shared_mutex;
+using boost::shared_lock;
+using boost::unique_lock;
+
+namespace storageprovider
+{
+    DedupStorageBackend::DedupStorageBackend(string path) :
+        path(std::move(path)),
+        unsyncedIndex(false)
+    {
+        boost::filesystem::create_directories(boost::filesystem::path(this->path) / "blobs");
+        loadIndex();
+
+        string indexPath = (boost::filesystem::path(this->path) / "index").string();
+        indexLog.open(indexPath.c_str(), ofstream::binary | ofstream::out | ofstream::app);
+        if (!indexLog) {
+            throw std::runtime_error("Cannot open index '" + indexPath + "' (" + strerror(errno) + ").");
+        }
+    }
+
+    void DedupStorageBackend::loadIndex()
+    {
+        boost::filesystem::path indexPath = boost::filesystem::path(path) / "index";
+        if (!boost::filesystem::exists(indexPath)) {
+            return;
+        }
+
+        size_t entries = 0;
+        ifstream infile(indexPath.c_str(), ifstream::binary | ifstream::in);
+        string line;
+        while (std::getline(infile, line)) {
+            size_t separator = line.find(' ');
+            if (separator == string::npos || separator + 1 == line.size()) {
+                continue; // Skip a truncated entry
+            }
+            index[line.substr(separator + 1)] = line.substr(0, separator);
+            entries++;
+        }
+        if (infile.bad()) {
+            throw std::runtime_error("Cannot read index '" + indexPath.string() + "' (" + strerror(errno) + ").");
+        }
+        infile.close();
+
+        // Compact the log when most entries have been overridden
+        if (entries > 2 * index.size()) {
+            boost::filesystem::path tempPath = boost::filesystem::path(path) / "index.tmp";
+            ofstream outfile(tempPath.c_str(), ofstream::binary | ofstream::out | ofstream::trunc);
+            for (auto it = index.begin(); it != index.end(); ++it) {
+                outfile << it->second << ' ' << it->first << '\n';
+            }
+            outfile.close();
+            if (outfile.fail()) {
+                throw std::runtime_error("Cannot write index '" + tempPath.string() + "' (" + strerror(errno) + ").");
+            }
+            boost::filesystem::rename(tempPath, indexPath);
+        }
+    }
+
+    string DedupStorageBackend::blobPath(const string& hash) const
+    {
+        // Spread blobs among 256 folders to keep directories small
+        return (boost::filesystem::path(path) / "blobs" / hash.substr(0, 2) / hash).string();
+    }
+
+    string DedupStorageBackend::contentHash(const vector<unsigned char>& buffer)
+    {
+        boost::uuids::detail::sha1 sha1;
+        sha1.process_bytes(buffer.data(), buffer.size());
+        unsigned int digest[5];
+        sha1.get_digest(digest);
+
+        char hex[41];
+        for (int i = 0; i < 5; i++) {
+            std::snprintf(hex + 8 * i, 9, "%08x", digest[i]);
+        }
+        return string(hex, 40);
+    }
+
+    vector<string> DedupStorageBackend::getList()
+    {
+        shared_lock<shared_mutex> readerLock(mutex);
+
+        vector<string> files;
+        files.reserve(index.size());
+        for (auto it = index.begin(); it != index.end(); ++it) {
+            files.push_back(it->first);
+        }
+        return files;
+    }
+
+    string DedupStorageBackend::getHash(const string& filename)
+    {
+        shared_lock<shared_mutex> readerLock(mutex);
+
+        auto it = index.find(filename);
+        if (it == index.end()) {
+            throw std::runtime_error("The specified file '" + filename + "' does not exist.");
+        }
+        return it->second;
+    }
+
+    void DedupStorageBackend::loadFile(const string& filename, vector<unsigned char>& buffer)
+    {
+        // Blobs are never modified once written, so they can be read without holding the lock.
+        string fullPath = blobPath(getHash(filename));
+
+        if (!boost::filesystem::exists(fullPath)) {
+            throw std::runtime_error("The blob '" + fullPath + "' of file '" + filename + "' does not exist.");
+        }
+
+        ifstream infile(fullPath.c_str(), ifstream::binary | ifstream::in | ifstream::ate);
+        buffer.resize(infile.tellg());
+        infile.seekg(0, ifstream::beg);
+        infile.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+        infile.close();
+        if (infile.fail()) {
+            throw std::runtime_error("Cannot read file '" + fullPath + "' (" + strerror(errno) + ").");
+        }
+    }
+
+    uint64_t DedupStorageBackend::loadFile(const string& filename, uint64_t offset, size_t length,
+                                           vector<unsigned char>& buffer)
+    {
+        return FileStorageBackend::readRange(blobPath(getHash(filename)), offset, length, buffer);
+    }
+
+    string DedupStorageBackend::getVersion(const string& filename)
+    {
+        return getHash(filename);
+    }
+
+    void DedupStorageBackend::saveFile(const string& filename, const vector<unsigned char>& buffer)
+    {
+        if (filename.empty() || filename.find('\n') != string::npos) {
+            throw std::runtime_error("Invalid filename '" + filename + "'.");
+        }
+
+        string hash = contentHash(buffer);
+        boost::filesystem::path fullPath(blobPath(hash));
+
+        if (!boost::filesystem::exists(fullPath)) {
+            // Write to a unique temporary file and then rename it, so that concurrent writers
+            // of the same content never expose a partially written blob.
+            bool created = boost::filesystem::create_directories(fullPath.parent_path());
+            boost::filesystem::path tempPath = fullPath.parent_path() / boost::filesystem::unique_path();
+
+            ofstream outfile(tempPath.c_str(), ofstream::binary | ofstream::out);
+            outfile.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+            outfile.flush();
+            outfile.close();
+            if (outfile.fail()) {
+                boost::system::error_code ignored_ec;
+                boost::filesystem::remove(tempPath, ignored_ec);
+                throw std::runtime_error("Cannot write file '" + tempPath.string() + "' (" + strerror(errno) + ").");
+            }
+            boost::filesystem::rename(tempPath, fullPath);
+
+            boost::lock_guard<boost::mutex> lock(unsyncedMutex);
+            unsyncedFiles.insert(fullPath.string());
+            unsyncedFolders.insert(fullPath.parent_path().string());
+            if (created) {
+                unsyncedFolders.insert(fullPath.parent_path().parent_path().string());
+            }
+        }
+
+        unique_lock<shared_mutex> writerLock(mutex);
+
+        auto it = index.find(filename);
+        if (it != index.end() && it->second == hash) {
+            return; // Same content already stored with the same name
+        }
+
+        indexLog << hash << ' ' << filename << '\n';
+        indexLog.flush();
+        if (indexLog.fail()) {
+            indexLog.clear();
+            throw std::runtime_error("Cannot update index (" + string(strerror(errno)) + ").");
+        }
+        index[filename] = hash;
+
+        boost::lock_guard<boost::mutex> lock(unsyncedMutex);
+        unsyncedIndex = true;
+    }
+
+    void DedupStorageBackend::sync()
+    {
+        // Blobs are renamed in place and the index is flushed by saveFile()
+        std::set<string> files, folders;
+        bool index = false;
+        {
+            boost::lock_guard<boost::mutex> lock(unsyncedMutex);
+            files.swap(unsyncedFiles);
+            folders.swap(unsyncedFolders);
+            std::swap(index, unsyncedIndex);
+        }
+
+        try {
+            // The blobs and their folders first, so that the index never refers to a blob
+            // lost in a crash.
+            FileStorageBackend::syncFiles(files, folders);
+            if (index) {
+                std::set<string> indexFile { (boost::filesystem::path(path) / "index").string() };
+                FileStorageBackend::syncFiles(indexFile, std::set<string>());
+            }
+        }
+        catch (...) {
+            // Try again with the next sync().
+            boost::lock_guard<boost::mutex> lock(unsyncedMutex);
+            unsyncedFiles.insert(files.begin(), files.end());
+            unsyncedFolders.insert(folders.begin(), folders.end());
+            unsyncedIndex = unsyncedIndex || index;
+            throw;
+        }
+    }
+}
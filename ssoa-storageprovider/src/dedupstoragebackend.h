@@ -0,0 +1,90 @@
+/*
+ * dedupstoragebackend.h
+ */
+
+#ifndef _DEDUPSTORAGEBACKEND_H_
+#define _DEDUPSTORAGEBACKEND_H_
+
+#include <istoragebackend.h>
+
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+
+namespace storageprovider
+{
+    /// Stores the content of each file just once, under its content hash.
+    ///
+    /// Blobs are kept in the "blobs" subfolder of the storage path, named after the SHA-1
+    /// of their content. The file "index" is an append-only log which maps filenames to
+    /// blobs: each line contains a hash and a filename, and later lines override earlier
+    /// ones. Saving a buffer which is already stored does not write any blob.
+    ///
+    /// Blobs which are no longer referenced by any filename are not removed.
+    class DedupStorageBackend: public IStorageBackend
+    {
+    public:
+        /// Constructs a new DedupStorageBackend and loads the index.
+        ///
+        /// @param path The path of the folder where blobs and index are stored.
+        ///
+        /// @throws std::runtime_error The index cannot be read or opened for writing.
+        DedupStorageBackend(std::string path);
+
+        virtual std::vector<std::string> getList();
+
+        virtual void loadFile(const std::string& filename, std::vector<unsigned char>& buffer);
+
+        virtual uint64_t loadFile(const std::string& filename, uint64_t offset, size_t length,
+                                  std::vector<unsigned char>& buffer);
+
+        /// Gets the content hash of the file (see getHash()).
+        virtual std::string getVersion(const std::string& filename);
+
+        virtual void saveFile(const std::string& filename, const std::vector<unsigned char>& buffer);
+
+        virtual void sync();
+
+        /// Gets the content hash of the given file.
+        ///
+        /// @throws std::runtime_error The file does not exist.
+        std::string getHash(const std::string& filename);
+
+        /// Computes the hash used to identify a blob (hex-encoded SHA-1).
+        static std::string contentHash(const std::vector<unsigned char>& buffer);
+
+    private:
+        /// Reads the index file and rewrites it if it contains too many stale entries.
+        void loadIndex();
+
+        /// Gets the full path of the blob with the given hash.
+        std::string blobPath(const std::string& hash) const;
+
+        std::string path;
+
+        /// Maps filenames to content hashes.
+        std::map<std::string, std::string> index;
+
+        /// Appends entries to the index file.
+        std::ofstream indexLog;
+
+        /// Protects index and indexLog.
+        boost::shared_mutex mutex;
+
+        /// Blobs written since the last sync() and the folders containing them.
+        /// Protected by unsyncedMutex.
+        std::set<std::string> unsyncedFiles, unsyncedFolders;
+
+        /// Whether any entry has been appended to the index since the last sync().
+        /// Protected by unsyncedMutex.
+        bool unsyncedIndex;
+        boost::mutex unsyncedMutex;
+    };
+}
+
+#endif
@@ -0,0 +1,240 @@
+/*
+ * filestoragebackend.cpp
+ */
+
+#include <filestoragebackend.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/thread/lock_guard.hpp>
+
+using std::ifstream;
+using std::ofstream;
+using std::string;
+using std::vector;
+using boost::shared_mutex;
+using boost::shared_lock;
+using boost::unique_lock;
+
+namespace storageprovider
+{
+    vector<string> FileStorageBackend::getList()
+    {
+        shared_lock<shared_mutex> readerLock(mutex);
+
+        vector<string> files;
+
+        if (!boost::filesystem::exists(path)) {
+            return files;
+        }
+
+        for (boost::filesystem::recursive_directory_iterator it(path), end; it != end; ++it) {
+            if (boost::filesystem::is_regular_file(it->status())) {
+                // In returned filenames skip the base path
+                boost::filesystem::path relativePath, skipPath(path);
+                skipPath.normalize();
+                auto itCombined = it->path().begin();
+                for (auto itSkip = skipPath.begin(); itSkip != skipPath.end();) {
+                    if (*itSkip == *itCombined) {
+                        ++itSkip;
+                        ++itCombined;
+                        continue;
+                    }
+                    if (itSkip->string() == ".")
+                        ++itSkip;
+                    else if (itCombined->string() == ".")
+                        ++itCombined;
+                    else
+                        break; // Something went wrong
+                }
+                while (itCombined != it->path().end()) {
+                    relativePath /= *itCombined;
+                    ++itCombined;
+                }
+                files.push_back(relativePath.string());
+            }
+        }
+        return files;
+    }
+
+    void FileStorageBackend::loadFile(const string& filename, vector<unsigned char>& buffer)
+    {
+        shared_lock<shared_mutex> readerLock(mutex);
+
+        boost::filesystem::path fullPath(path);
+        fullPath /= filename;
+
+        if (!boost::filesystem::exists(fullPath)) {
+            throw std::runtime_error("The specified file '" + string(fullPath.c_str()) + "' does not exist.");
+        }
+
+        ifstream infile(fullPath.c_str(), ifstream::binary | ifstream::in | ifstream::ate);
+        buffer.resize(infile.tellg());
+        infile.seekg(0, ifstream::beg);
+        infile.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+        infile.close();
+        if (infile.fail()) {
+            throw std::runtime_error("Cannot read file '" + string(fullPath.c_str()) + "' (" + strerror(errno) + ").");
+        }
+    }
+
+    uint64_t FileStorageBackend::loadFile(const string& filename, uint64_t offset, size_t length,
+                                          vector<unsigned char>& buffer)
+    {
+        shared_lock<shared_mutex> readerLock(mutex);
+
+        boost::filesystem::path fullPath(path);
+        fullPath /= filename;
+        return readRange(fullPath.string(), offset, length, buffer);
+    }
+
+    string FileStorageBackend::getVersion(const string& filename)
+    {
+        shared_lock<shared_mutex> readerLock(mutex);
+
+        boost::filesystem::path fullPath(path);
+        fullPath /= filename;
+
+        struct stat st;
+        if (::stat(fullPath.c_str(), &st) < 0) {
+            if (errno == ENOENT) {
+                throw std::runtime_error("The specified file '" + string(fullPath.c_str()) + "' does not exist.");
+            }
+            throw std::runtime_error("Cannot stat file '" + string(fullPath.c_str()) + "' (" + strerror(errno) + ").");
+        }
+
+        char version[64];
+        std::snprintf(version, sizeof(version), "%llu-%lld.%09ld", (unsigned long long) st.st_size,
+                      (long long) st.st_mtim.tv_sec, (long) st.st_mtim.tv_nsec);
+        return version;
+    }
+
+    void FileStorageBackend::saveFile(const string& filename, const vector<unsigned char>& buffer)
+    {
+        unique_lock<shared_mutex> writerLock(mutex);
+
+        boost::filesystem::path fullPath(path);
+        fullPath /= filename;
+
+        bool created = false;
+        if (!boost::filesystem::exists(fullPath.parent_path())) {
+            if (!boost::filesystem::create_directory(fullPath.parent_path()))
+                throw std::runtime_error("Cannot create folder '" + string(fullPath.parent_path().c_str()) + "'.");
+            created = true;
+        }
+
+        ofstream outfile(fullPath.c_str(), ofstream::binary | ofstream::out);
+        outfile.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        outfile.flush();
+        outfile.close();
+        if (outfile.fail()) {
+            throw std::runtime_error("Cannot write file '" + string(fullPath.c_str()) + "' (" + strerror(errno) + ").");
+        }
+
+        boost::lock_guard<boost::mutex> lock(unsyncedMutex);
+        unsyncedFiles.insert(fullPath.string());
+        unsyncedFolders.insert(fullPath.parent_path().string());
+        if (created) {
+            unsyncedFolders.insert(fullPath.parent_path().parent_path().string());
+        }
+    }
+
+    void FileStorageBackend::sync()
+    {
+        std::set<string> files, folders;
+        {
+            boost::lock_guard<boost::mutex> lock(unsyncedMutex);
+            files.swap(unsyncedFiles);
+            folders.swap(unsyncedFolders);
+        }
+
+        try {
+            syncFiles(files, folders);
+        }
+        catch (...) {
+            // Try again with the next sync().
+            boost::lock_guard<boost::mutex> lock(unsyncedMutex);
+            unsyncedFiles.insert(files.begin(), files.end());
+            unsyncedFolders.insert(folders.begin(), folders.end());
+            throw;
+        }
+    }
+
+    namespace
+    {
+        /// Flushes a file with fdatasync(), or a folder with fsync(), if it exists.
+        void syncPath(const string& path, bool folder)
+        {
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | (folder ? O_DIRECTORY : 0));
+            if (fd < 0) {
+                if (errno == ENOENT) {
+                    return;
+                }
+                throw std::runtime_error("Cannot open '" + path + "' (" + strerror(errno) + ").");
+            }
+            int result = folder ? ::fsync(fd) : ::fdatasync(fd);
+            int error = errno;
+            ::close(fd);
+            if (result < 0) {
+                throw std::runtime_error("Cannot sync '" + path + "' (" + strerror(error) + ").");
+            }
+        }
+    }
+
+    void FileStorageBackend::syncFiles(const std::set<string>& files, const std::set<string>& folders)
+    {
+        for (const string& file : files) {
+            syncPath(file, false);
+        }
+        for (const string& folder : folders) {
+            syncPath(folder, true);
+        }
+    }
+
+    uint64_t FileStorageBackend::readRange(const string& fullPath, uint64_t offset, size_t length,
+                                           vector<unsigned char>& buffer)
+    {
+        int fd = ::open(fullPath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            if (errno == ENOENT) {
+                throw std::runtime_error("The specified file '" + fullPath + "' does not exist.");
+            }
+            throw std::runtime_error("Cannot open file '" + fullPath + "' (" + strerror(errno) + ").");
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) < 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::runtime_error("Cannot stat file '" + fullPath + "' (" + strerror(error) + ").");
+        }
+
+        uint64_t size = st.st_size;
+        buffer.resize(offset < size ? std::min<uint64_t>(length, size - offset) : 0);
+        size_t done = 0;
+        while (done < buffer.size()) {
+            ssize_t result = ::pread(fd, buffer.data() + done, buffer.size() - done, offset + done);
+            if (result <= 0) {
+                if (result < 0 && errno == EINTR) {
+                    continue;
+                }
+                int error = result < 0 ? errno : EIO;
+                ::close(fd);
+                throw std::runtime_error("Cannot read file '" + fullPath + "' (" + strerror(error) + ").");
+            }
+            done += result;
+        }
+        ::close(fd);
+        return size;
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * filestoragebackend.h
+ */
+
+#ifndef _FILESTORAGEBACKEND_H_
+#define _FILESTORAGEBACKEND_H_
+
+#include <istoragebackend.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+
+namespace storageprovider
+{
+    /// Stores each file as a regular file inside a specific folder.
+    class FileStorageBackend: public IStorageBackend
+    {
+    public:
+        /// Constructs a new FileStorageBackend.
+        ///
+        /// @param path The path of the folder where all files are stored.
+        FileStorageBackend(std::string path) :
+            path(std::move(path))
+        {
+        }
+
+        virtual std::vector<std::string> getList();
+
+        virtual void loadFile(const std::string& filename, std::vector<unsigned char>& buffer);
+
+        virtual uint64_t loadFile(const std::string& filename, uint64_t offset, size_t length,
+                                  std::vector<unsigned char>& buffer);
+
+        /// Gets the size and the modification time of the file, e.g. "1234-1500000000.123456789".
+        ///
+        /// The version does not change if the file is saved again with the same size within
+        /// the resolution of the timestamps of the filesystem.
+        virtual std::string getVersion(const std::string& filename);
+
+        virtual void saveFile(const std::string& filename, const std::vector<unsigned char>& buffer);
+
+        virtual void sync();
+
+        /// Flushes to the disk the data of the given files, with an fdatasync() each, and the
+        /// entries of the given folders, so that files created or renamed in them are found
+        /// after a crash. Files which no longer exist are skipped.
+        ///
+        /// @throws std::runtime_error The data cannot be flushed.
+        static void syncFiles(const std::set<std::string>& files, const std::set<std::string>& folders);
+
+        /// Reads at most @c length bytes of the given file, starting at @c offset.
+        ///
+        /// @return The total size of the file.
+        ///
+        /// @throws std::runtime_error The file cannot be read.
+        static uint64_t readRange(const std::string& fullPath, uint64_t offset, size_t length,
+                                  std::vector<unsigned char>& buffer);
+
+    private:
+        std::string path;
+        boost::shared_mutex mutex;
+
+        /// Files saved since the last sync() and the folders containing them.
+        /// Protected by unsyncedMutex.
+        std::set<std::string> unsyncedFiles, unsyncedFolders;
+        boost::mutex unsyncedMutex;
+    };
+}
+
+#endif
@@ -0,0 +1,40 @@
+/*
+ * getimageifmodifiedserviceimpl.cpp
+ */
+
+#include <getimageifmodifiedserviceimpl.h>
+#include <storageservice.h>
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+using namespace ssoa;
+
+namespace storageprovider
+{
+    Response * GetImageIfModifiedServiceImpl::invoke()
+    {
+        std::unique_ptr<ServiceStringArgument> name(popArgument<ServiceStringArgument>());
+        std::unique_ptr<ServiceStringArgument> knownVersion(popArgument<ServiceStringArgument>());
+
+        // The version is read before the content, so that it is never newer than the content.
+        string version = StorageService::getVersion(name->getValue());
+
+        vector<unsigned char> buffer;
+        Response * response;
+        if (!knownVersion->getValue().empty() && knownVersion->getValue() == version) {
+            Logger::info("Image '%1%' not modified.", name->getValue());
+            response = new Response(serviceSignature(), true, "Not modified");
+        }
+        else {
+            StorageService::loadFile(name->getValue(), buffer);
+            Logger::info("Retrieved image '%1%'.", name->getValue());
+            response = new Response(serviceSignature(), true, "OK");
+        }
+        response->pushArgument(new ServiceStringArgument(version));
+        response->pushArgument(new ServiceBufferArgument(std::move(buffer)));
+        return response;
+    }
+}
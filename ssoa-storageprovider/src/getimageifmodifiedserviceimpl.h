@@ -0,0 +1,45 @@
+/*
+ * getimageifmodifiedserviceimpl.h
+ */
+
+#ifndef _GETIMAGEIFMODIFIEDSERVICEIMPL_H_
+#define _GETIMAGEIFMODIFIEDSERVICEIMPL_H_
+
+#include <ssoa/service/servicesignature.h>
+#include <ssoa/service/serviceskeleton.h>
+
+namespace storageprovider
+{
+    /// Implements the "GetImageIfModified" service.
+    ///
+    /// Input arguments are the image name and the version already held by the client (possibly
+    /// empty). Output arguments are the current version and the image data; if the version has
+    /// not changed, the status is "Not modified" and the image data is empty.
+    class GetImageIfModifiedServiceImpl: public ssoa::ServiceSkeleton
+    {
+        GetImageIfModifiedServiceImpl(arg_deque arguments) :
+            ssoa::ServiceSkeleton(ssoa::ServiceSignature(serviceSignature()), std::move(arguments))
+        {
+        }
+
+    public:
+        /// Constructs a new instance of GetImageIfModifiedServiceImpl from the given arguments.
+        static ssoa::ServiceSkeleton* create(arg_deque&& arguments) {
+            return new GetImageIfModifiedServiceImpl(std::move(arguments));
+        }
+
+        /// Gets the signature of this type of service.
+        static const char * serviceSignature() {
+            return "GetImageIfModified(in string, in string, out string, out buffer)";
+        }
+
+        /// Installs the creation method.
+        static void install() {
+            factory().install(serviceSignature(), create);
+        }
+
+        virtual ssoa::Response * invoke();
+    };
+}
+
+#endif
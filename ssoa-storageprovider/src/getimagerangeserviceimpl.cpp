@@ -0,0 +1,62 @@
+/*
+ * getimagerangeserviceimpl.cpp
+ */
+
+#include <getimagerangeserviceimpl.h>
+#include <storageservice.h>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+using namespace ssoa;
+
+namespace storageprovider
+{
+    namespace
+    {
+        /// The number of reads of a range before giving up on an image which keeps changing.
+        const int maxAttempts = 3;
+    }
+
+    Response * GetImageRangeServiceImpl::invoke()
+    {
+        std::unique_ptr<ServiceStringArgument> name(popArgument<ServiceStringArgument>());
+        std::unique_ptr<ServiceIntArgument> offset(popArgument<ServiceIntArgument>());
+        std::unique_ptr<ServiceIntArgument> length(popArgument<ServiceIntArgument>());
+
+        if (offset->getValue() < 0 || length->getValue() < 0) {
+            return new Response(serviceSignature(), false, "Invalid range.");
+        }
+
+        // The version is read again after the content: if the file has been saved in between,
+        // the range might come from either content, so it is read again.
+        string version = StorageService::getVersion(name->getValue());
+        vector<unsigned char> buffer;
+        uint64_t size;
+        for (int attempt = 1; ; attempt++) {
+            size = StorageService::loadFile(name->getValue(), offset->getValue(), length->getValue(), buffer);
+            string current = StorageService::getVersion(name->getValue());
+            if (current == version) {
+                break;
+            }
+            if (attempt == maxAttempts) {
+                return new Response(serviceSignature(), false, "Image modified while reading it.");
+            }
+            version = std::move(current);
+        }
+        if (size > static_cast<uint64_t>(std::numeric_limits<int32_t>::max())) {
+            return new Response(serviceSignature(), false, "Image too large for range requests.");
+        }
+        Logger::info("Retrieved %1% bytes of image '%2%' at offset %3%.", buffer.size(), name->getValue(),
+                     offset->getValue());
+
+        Response * response = new Response(serviceSignature(), true, "OK");
+        response->pushArgument(new ServiceStringArgument(version));
+        response->pushArgument(new ServiceIntArgument(static_cast<int32_t>(size)));
+        response->pushArgument(new ServiceBufferArgument(std::move(buffer)));
+        return response;
+    }
+}
@@ -0,0 +1,45 @@
+/*
+ * getimagerangeserviceimpl.h
+ */
+
+#ifndef _GETIMAGERANGESERVICEIMPL_H_
+#define _GETIMAGERANGESERVICEIMPL_H_
+
+#include <ssoa/service/servicesignature.h>
+#include <ssoa/service/serviceskeleton.h>
+
+namespace storageprovider
+{
+    /// Implements the "GetImageRange" service.
+    ///
+    /// Input arguments are the image name, the offset and the maximum length of the range.
+    /// Output arguments are the version of the image, its total size and the requested bytes,
+    /// so that a client fetching many ranges can check that they belong to the same version.
+    class GetImageRangeServiceImpl: public ssoa::ServiceSkeleton
+    {
+        GetImageRangeServiceImpl(arg_deque arguments) :
+            ssoa::ServiceSkeleton(ssoa::ServiceSignature(serviceSignature()), std::move(arguments))
+        {
+        }
+
+    public:
+        /// Constructs a new instance of GetImageRangeServiceImpl from the given arguments.
+        static ssoa::ServiceSkeleton* create(arg_deque&& arguments) {
+            return new GetImageRangeServiceImpl(std::move(arguments));
+        }
+
+        /// Gets the signature of this type of service.
+        static const char * serviceSignature() {
+            return "GetImageRange(in string, in int, in int, out string, out int, out buffer)";
+        }
+
+        /// Installs the creation method.
+        static void install() {
+            factory().install(serviceSignature(), create);
+        }
+
+        virtual ssoa::Response * invoke();
+    };
+}
+
+#endif
@@ -0,0 +1,45 @@
+/*
+ * getimagesserviceimpl.cpp
+ */
+
+#include <getimagesserviceimpl.h>
+#include <imagebatch.h>
+#include <storageservice.h>
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+using namespace ssoa;
+
+namespace storageprovider
+{
+    Response * GetImagesServiceImpl::invoke()
+    {
+        std::unique_ptr<ServiceBufferArgument> namesArg(popArgument<ServiceBufferArgument>());
+        vector<string> names = imagebatch::decodeNames(namesArg->getValue());
+
+        vector<vector<unsigned char>> images;
+        StorageService::loadFiles(names, images);
+
+        size_t total = 0;
+        for (const auto& image : images) {
+            total += image.size();
+        }
+
+        vector<unsigned char> blobs, offsets;
+        blobs.reserve(total);
+        offsets.reserve(images.size() * sizeof(uint32_t));
+        for (const auto& image : images) {
+            blobs.insert(blobs.end(), image.begin(), image.end());
+            imagebatch::encodeOffset(offsets, blobs.size());
+        }
+        Logger::info("Retrieved %1% images (%2% bytes).", images.size(), total);
+
+        Response * response = new Response(serviceSignature(), true, "OK");
+        response->pushArgument(new ServiceBufferArgument(std::move(blobs)));
+        response->pushArgument(new ServiceBufferArgument(std::move(offsets)));
+        return response;
+    }
+}
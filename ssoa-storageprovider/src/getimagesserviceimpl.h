@@ -0,0 +1,45 @@
+/*
+ * getimagesserviceimpl.h
+ */
+
+#ifndef _GETIMAGESSERVICEIMPL_H_
+#define _GETIMAGESSERVICEIMPL_H_
+
+#include <ssoa/service/servicesignature.h>
+#include <ssoa/service/serviceskeleton.h>
+
+namespace storageprovider
+{
+    /// Implements the "GetImages" service.
+    ///
+    /// The input argument contains the image names, each terminated by a NUL character.
+    /// Output arguments are the concatenated image data and, for each image, the offset
+    /// at which its data ends (a 32-bit integer in network byte order).
+    class GetImagesServiceImpl: public ssoa::ServiceSkeleton
+    {
+        GetImagesServiceImpl(arg_deque arguments) :
+            ssoa::ServiceSkeleton(ssoa::ServiceSignature(serviceSignature()), std::move(arguments))
+        {
+        }
+
+    public:
+        /// Constructs a new instance of GetImagesServiceImpl from the given arguments.
+        static ssoa::ServiceSkeleton* create(arg_deque&& arguments) {
+            return new GetImagesServiceImpl(std::move(arguments));
+        }
+
+        /// Gets the signature of this type of service.
+        static const char * serviceSignature() {
+            return "GetImages(in buffer, out buffer, out buffer)";
+        }
+
+        /// Installs the creation method.
+        static void install() {
+            factory().install(serviceSignature(), create);
+        }
+
+        virtual ssoa::Response * invoke();
+    };
+}
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * imagebatch.h
+ */
+
+#ifndef _IMAGEBATCH_H_
+#define _IMAGEBATCH_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+
+namespace storageprovider
+{
+    /// Encodes and decodes the arguments of the "GetImages" and "StoreImages" services.
+    namespace imagebatch
+    {
+        /// Splits a buffer containing NUL-terminated names (the last terminator may be missing).
+        inline std::vector<std::string> decodeNames(const std::vector<unsigned char>& buffer) {
+            std::vector<std::string> names;
+            auto begin = buffer.begin();
+            while (begin != buffer.end()) {
+                auto end = std::find(begin, buffer.end(), '\0');
+                names.emplace_back(begin, end);
+                begin = end == buffer.end() ? end : end + 1;
+            }
+            return names;
+        }
+
+        /// Appends the given end offset to a buffer of offsets.
+        inline void encodeOffset(std::vector<unsigned char>& buffer, uint64_t offset) {
+            if (offset > UINT32_MAX) {
+                throw std::runtime_error("Batch too large.");
+            }
+            uint32_t value = htonl(static_cast<uint32_t>(offset));
+            const unsigned char *bytes = reinterpret_cast<const unsigned char*>(&value);
+            buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+        }
+
+        /// Decodes a buffer of end offsets, checking that they are not decreasing and that
+        /// the last one is equal to the given data size.
+        ///
+        /// @throws std::runtime_error The offsets are not valid.
+        inline std::vector<uint32_t> decodeOffsets(const std::vector<unsigned char>& buffer, size_t dataSize) {
+            if (buffer.size() % sizeof(uint32_t) != 0) {
+                throw std::runtime_error("Invalid offsets.");
+            }
+            std::vector<uint32_t> offsets(buffer.size() / sizeof(uint32_t));
+            uint32_t previous = 0;
+            for (size_t i = 0; i < offsets.size(); i++) {
+                uint32_t value;
+                std::copy(buffer.begin() + i * sizeof(value), buffer.begin() + (i + 1) * sizeof(value),
+                          reinterpret_cast<unsigned char*>(&value));
+                offsets[i] = ntohl(value);
+                if (offsets[i] < previous || offsets[i] > dataSize) {
+                    throw std::runtime_error("Invalid offsets.");
+                }
+                previous = offsets[i];
+            }
+            if (previous != dataSize) {
+                throw std::runtime_error("Invalid offsets.");
+            }
+            return offsets;
+        }
+    }
+}
+
+#endif
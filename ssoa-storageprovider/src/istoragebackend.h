@@ -0,0 +1,62 @@
+/*
+ * istoragebackend.h
+ */
+
+#ifndef _ISTORAGEBACKEND_H_
+#define _ISTORAGEBACKEND_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace storageprovider
+{
+    /// Represents the actual implementation of the storage used by StorageService.
+    ///
+    /// All methods may be called concurrently from many threads, so implementations must
+    /// take care of their own synchronization.
+    class IStorageBackend
+    {
+    public:
+        /// Gets the list of all files.
+        virtual std::vector<std::string> getList() = 0;
+
+        /// Loads the file with the given file name.
+        ///
+        /// @throws std::runtime_error The file does not exist or cannot be read.
+        virtual void loadFile(const std::string& filename, std::vector<unsigned char>& buffer) = 0;
+
+        /// Loads at most @c length bytes of the file with the given file name, starting at
+        /// @c offset. The buffer is empty if @c offset is beyond the end of the file.
+        ///
+        /// @return The total size of the file.
+        ///
+        /// @throws std::runtime_error The file does not exist or cannot be read.
+        virtual uint64_t loadFile(const std::string& filename, uint64_t offset, size_t length,
+                                  std::vector<unsigned char>& buffer) = 0;
+
+        /// Gets a string identifying the current content of the file with the given name.
+        ///
+        /// The format depends on the backend, and so does the guarantee: a content hash or a
+        /// sequence number changes whenever the content does, while the modification time used
+        /// by FileStorageBackend may miss a save shortly after the previous one.
+        ///
+        /// @throws std::runtime_error The file does not exist.
+        virtual std::string getVersion(const std::string& filename) = 0;
+
+        /// Saves a file with the given filename, replacing any previous content.
+        ///
+        /// @throws std::runtime_error The file cannot be written.
+        virtual void saveFile(const std::string& filename, const std::vector<unsigned char>& buffer) = 0;
+
+        /// Makes all files saved so far durable, flushing them to the disk.
+        ///
+        /// @throws std::runtime_error The data cannot be flushed.
+        virtual void sync() = 0;
+
+        virtual ~IStorageBackend() {
+        }
+    };
+}
+
+#endif
@@ -3,9 +3,15 @@
  */
 
 #include <storeimageserviceimpl.h>
+#include <storeimagesserviceimpl.h>
 #include <getimageserviceimpl.h>
+#include <getimageifmodifiedserviceimpl.h>
+#include <getimagerangeserviceimpl.h>
+#include <getimagesserviceimpl.h>
 #include <getlistserviceimpl.h>
+#include <storageservice.h>
 
+#include <algorithm>
 #include <iostream>
 
 #include <boost/lexical_cast.hpp>
@@ -39,11 +45,36 @@ void deregisterService(const string& address, const string& port)
     Logger::info("Deregistered service '%1%' from the registry.", T::serviceSignature());
 }
 
+/// Deregisters all services, so that the registry stops routing requests to this provider.
+bool deregisterServices(const string& address, const string& port)
+{
+    try {
+        deregisterService<StoreImageServiceImpl>(address, port);
+        deregisterService<StoreImagesServiceImpl>(address, port);
+        deregisterService<GetImageServiceImpl>(address, port);
+        deregisterService<GetImageIfModifiedServiceImpl>(address, port);
+        deregisterService<GetImageRangeServiceImpl>(address, port);
+        deregisterService<GetImagesServiceImpl>(address, port);
+        deregisterService<GetListServiceImpl>(address, port);
+    }
+    catch (const exception& e) {
+        Logger::error("Exception while deregistering services: %1%", e.what());
+        return false;
+    }
+    return true;
+}
+
 int main(int argc, char* argv[])
 {
     string address, port;
     string registryAddress, registryPort;
+    string storagePath, storageBackend, durability;
     int num_threads;
+    int computeThreads;
+    int drainTimeout;
+    int idleTimeout;
+    int maxConnections;
+    int maxPayload;
 
     po::options_description description("Allowed options");
     description.add_options()
@@ -58,6 +89,24 @@ int main(int argc, char* argv[])
             "Specifies the port of the registry")
         ("threads,n", po::value<int>(&num_threads)->default_value(10),
             "Specifies the number of threads in the pool")
+        ("io-service-per-thread", "Runs an io_service per thread, pinned to a core and accepting connections "
+            "on its own SO_REUSEPORT socket, instead of sharing one among all threads")
+        ("compute-threads,t", po::value<int>(&computeThreads)->default_value(0),
+            "Specifies the number of threads invoking the services (0 invokes them on the network threads)")
+        ("drain-timeout", po::value<int>(&drainTimeout)->default_value(30),
+            "Specifies how long the requests in progress may take to complete on shutdown, in seconds")
+        ("idle-timeout", po::value<int>(&idleTimeout)->default_value(30),
+            "Specifies how long a client may take to send a request or receive the response, in seconds")
+        ("max-connections", po::value<int>(&maxConnections)->default_value(1024),
+            "Specifies the connections in progress above which new ones wait in the backlog (0: no limit)")
+        ("max-payload", po::value<int>(&maxPayload)->default_value(256),
+            "Specifies the request payloads in progress, in MiB, above which new connections wait (0: no limit)")
+        ("storage-path,d", po::value<string>(&storagePath)->default_value("database"),
+            "Specifies the folder where images are stored")
+        ("storage-backend,b", po::value<string>(&storageBackend)->default_value("files"),
+            "Specifies the storage backend (files, dedup, segments)")
+        ("durability,D", po::value<string>(&durability)->default_value("none"),
+            "Specifies when stored images are acknowledged (none, enqueue, fsync)")
         ("log-marker,l", po::value<string>(&Logger::marker),
             "Specifies a string printed at the beginning of every log message");
 
@@ -87,6 +136,16 @@ int main(int argc, char* argv[])
         return EXIT_FAILURE;
     }
 
+    try {
+        StorageService::initialize(storageBackend, storagePath, durability);
+        Logger::info("Initialized storage '%1%' in '%2%' with durability '%3%'.",
+                     storageBackend, storagePath, durability);
+    }
+    catch (const exception& e) {
+        Logger::error("Exception while initializing storage: %1%", e.what());
+        return EXIT_FAILURE;
+    }
+
     // Initialize the library
     ssoa::setup();
 
@@ -95,7 +154,11 @@ int main(int argc, char* argv[])
 
     try {
         registerService<StoreImageServiceImpl>(address, port);
+        registerService<StoreImagesServiceImpl>(address, port);
         registerService<GetImageServiceImpl>(address, port);
+        registerService<GetImageIfModifiedServiceImpl>(address, port);
+        registerService<GetImageRangeServiceImpl>(address, port);
+        registerService<GetImagesServiceImpl>(address, port);
         registerService<GetListServiceImpl>(address, port);
     }
     catch (const exception& e) {
@@ -103,10 +166,26 @@ int main(int argc, char* argv[])
         return EXIT_FAILURE;
     }
 
+    ServiceSkeleton::setIdleTimeout(std::max(1, idleTimeout) * 1000L);
+
     int status = EXIT_SUCCESS;
+    bool deregistered = false;
     try {
         // Initialize and run the server until stopped.
-        ServiceListener server(address, port, num_threads);
+        ListenerMode mode = vm.find("io-service-per-thread") != vm.end() ?
+            IO_SERVICE_PER_THREAD : SHARED_IO_SERVICE;
+        ServiceListener server(address, port, num_threads, mode, std::max(0, computeThreads));
+        server.setLimits(std::max(0, maxConnections), static_cast<size_t>(std::max(0, maxPayload)) << 20);
+        server.setDrainTimeout(std::max(0, drainTimeout) * 1000L);
+        server.setDrainHandler([&](bool) {
+            // Stop receiving requests before draining.
+            if (!deregisterServices(address, port)) {
+                status = EXIT_FAILURE;
+            }
+            deregistered = true;
+        });
+        // No hot restart: the new process would write the storage folder while this one
+        // still drains, and the folder is locked by a single process anyway.
         Logger::info("Server started.");
         server.run();
     }
@@ -116,13 +195,7 @@ int main(int argc, char* argv[])
         status = EXIT_FAILURE;
     }
 
-    try {
-        deregisterService<StoreImageServiceImpl>(address, port);
-        deregisterService<GetImageServiceImpl>(address, port);
-        deregisterService<GetListServiceImpl>(address, port);
-    }
-    catch (const exception& e) {
-        Logger::error("Exception while deregistering services: %1%", e.what());
+    if (!deregistered && !deregisterServices(address, port)) {
         return EXIT_FAILURE;
     }
 
@@ -0,0 +1,405 @@
+/*
+ * segmentstoragebackend.cpp
+ */
+
+#include <segmentstoragebackend.h>
+
+#include <ssoa/logger.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+using boost::shared_mutex;
+using boost::shared_lock;
+using boost::unique_lock;
+using ssoa::Logger;
+
+namespace storageprovider
+{
+    /// The header of each record, followed by the filename and by the file content.
+    /// Fields are stored in host byte order.
+    struct RecordHeader
+    {
+        uint32_t magic;
+        uint32_t nameLength;
+        uint64_t dataLength;
+        uint64_t sequence;
+    };
+
+    static const uint32_t recordMagic = 0x47455353; // "SSEG"
+
+    SegmentStorageBackend::Segment::~Segment()
+    {
+        ::close(fd);
+    }
+
+    SegmentStorageBackend::SegmentStorageBackend(string path, uint64_t maxSegmentSize, int compactionInterval) :
+        path(std::move(path)), maxSegmentSize(maxSegmentSize), compactionInterval(compactionInterval),
+        nextSequence(0), stopping(false)
+    {
+        recover();
+        compactionThread = boost::thread(&SegmentStorageBackend::compactionLoop, this);
+    }
+
+    SegmentStorageBackend::~SegmentStorageBackend()
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(stopMutex);
+            stopping = true;
+        }
+        stopCondition.notify_all();
+        compactionThread.join();
+    }
+
+    string SegmentStorageBackend::segmentPath(uint32_t id) const
+    {
+        char name[16];
+        std::snprintf(name, sizeof(name), "%08u.seg", id);
+        return (boost::filesystem::path(path) / "segments" / name).string();
+    }
+
+    void SegmentStorageBackend::readAt(const Segment& segment, void *data, uint64_t length, uint64_t offset)
+    {
+        char *ptr = static_cast<char*>(data);
+        while (length > 0) {
+            ssize_t count = ::pread(segment.fd, ptr, length, offset);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                throw std::runtime_error("Cannot read segment " + boost::lexical_cast<string>(segment.id) + " ("
+                                         + (count < 0 ? strerror(errno) : "unexpected end of file") + ").");
+            }
+            ptr += count;
+            offset += count;
+            length -= count;
+        }
+    }
+
+    void SegmentStorageBackend::recover()
+    {
+        boost::filesystem::path folder = boost::filesystem::path(path) / "segments";
+        boost::filesystem::create_directories(folder);
+
+        vector<uint32_t> ids;
+        for (boost::filesystem::directory_iterator it(folder), end; it != end; ++it) {
+            unsigned int id;
+            char extra;
+            if (std::sscanf(it->path().filename().c_str(), "%8u.seg%c", &id, &extra) == 1) {
+                ids.push_back(id);
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+
+        for (auto it = ids.begin(); it != ids.end(); ++it) {
+            string name = segmentPath(*it);
+            int fd = ::open(name.c_str(), O_RDWR | O_CLOEXEC);
+            if (fd < 0) {
+                throw std::runtime_error("Cannot open segment '" + name + "' (" + strerror(errno) + ").");
+            }
+            shared_ptr<Segment> segment(new Segment(*it, fd));
+
+            struct stat st;
+            if (::fstat(fd, &st) < 0) {
+                throw std::runtime_error("Cannot stat segment '" + name + "' (" + strerror(errno) + ").");
+            }
+            segment->size = scanSegment(segment, st.st_size);
+            if (segment->size < (uint64_t)st.st_size) {
+                Logger::error("Segment '%1%' is corrupted after offset %2%.", name, segment->size);
+                if (*it == ids.back() && ::ftruncate(fd, segment->size) < 0) {
+                    throw std::runtime_error("Cannot truncate segment '" + name + "' (" + strerror(errno) + ").");
+                }
+            }
+            segments[*it] = segment;
+        }
+
+        for (auto it = index.begin(); it != index.end(); ++it) {
+            it->second.segment->liveBytes += it->second.recordSize;
+        }
+
+        if (segments.empty()) {
+            openSegment(1);
+        }
+        else {
+            active = segments.rbegin()->second;
+        }
+    }
+
+    uint64_t SegmentStorageBackend::scanSegment(const shared_ptr<Segment>& segment, uint64_t fileSize)
+    {
+        uint64_t offset = 0;
+        while (offset + sizeof(RecordHeader) <= fileSize) {
+            RecordHeader header;
+            readAt(*segment, &header, sizeof(header), offset);
+            if (header.magic != recordMagic || header.nameLength == 0
+                || header.nameLength > fileSize || header.dataLength > fileSize) {
+                break;
+            }
+            uint64_t recordSize = sizeof(header) + header.nameLength + header.dataLength;
+            if (offset + recordSize > fileSize) {
+                break; // Truncated record
+            }
+
+            string name(header.nameLength, '\0');
+            readAt(*segment, &name[0], header.nameLength, offset + sizeof(header));
+
+            auto it = index.find(name);
+            if (it == index.end() || it->second.sequence <= header.sequence) {
+                Location location = { segment, offset, recordSize, header.dataLength, header.sequence };
+                index[name] = location;
+            }
+            nextSequence = std::max(nextSequence, header.sequence + 1);
+            offset += recordSize;
+        }
+        return offset;
+    }
+
+    void SegmentStorageBackend::openSegment(uint32_t id)
+    {
+        string name = segmentPath(id);
+        int fd = ::open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot create segment '" + name + "' (" + strerror(errno) + ").");
+        }
+        shared_ptr<Segment> segment(new Segment(id, fd));
+        {
+            unique_lock<shared_mutex> writerLock(mutex);
+            segments[id] = segment;
+        }
+        active = segment;
+    }
+
+    SegmentStorageBackend::Location SegmentStorageBackend::appendRecord(
+        const string& filename, const unsigned char *data, uint64_t length, uint64_t sequence)
+    {
+        uint64_t recordSize = sizeof(RecordHeader) + filename.size() + length;
+        if (active->size > 0 && active->size + recordSize > maxSegmentSize) {
+            openSegment(active->id + 1);
+        }
+
+        RecordHeader header = { recordMagic, (uint32_t)filename.size(), length, sequence };
+        struct iovec iov[3] = {
+            { &header, sizeof(header) },
+            { const_cast<char*>(filename.data()), filename.size() },
+            { const_cast<unsigned char*>(data), length }
+        };
+
+        // A failed or short write leaves the size unchanged, so that the next record
+        // overwrites the partial one.
+        ssize_t written;
+        do {
+            written = ::pwritev(active->fd, iov, 3, active->size);
+        } while (written < 0 && errno == EINTR);
+        if (written != (ssize_t)recordSize) {
+            throw std::runtime_error("Cannot append to segment " + boost::lexical_cast<string>(active->id) + " ("
+                                     + (written < 0 ? strerror(errno) : "short write") + ").");
+        }
+
+        Location location = { active, active->size, recordSize, length, sequence };
+        active->size += recordSize;
+        if (unsynced.empty() || unsynced.back() != active) {
+            unsynced.push_back(active);
+        }
+        return location;
+    }
+
+    vector<string> SegmentStorageBackend::getList()
+    {
+        shared_lock<shared_mutex> readerLock(mutex);
+
+        vector<string> files;
+        files.reserve(index.size());
+        for (auto it = index.begin(); it != index.end(); ++it) {
+            files.push_back(it->first);
+        }
+        return files;
+    }
+
+    SegmentStorageBackend::Location SegmentStorageBackend::find(const string& filename)
+    {
+        shared_lock<shared_mutex> readerLock(mutex);
+        auto it = index.find(filename);
+        if (it == index.end()) {
+            throw std::runtime_error("The specified file '" + filename + "' does not exist.");
+        }
+        return it->second;
+    }
+
+    void SegmentStorageBackend::loadFile(const string& filename, vector<unsigned char>& buffer)
+    {
+        // The segment is kept open by location.segment even if it is compacted meanwhile.
+        Location location = find(filename);
+        buffer.resize(location.dataLength);
+        readAt(*location.segment, buffer.data(), location.dataLength,
+               location.offset + location.recordSize - location.dataLength);
+    }
+
+    uint64_t SegmentStorageBackend::loadFile(const string& filename, uint64_t offset, size_t length,
+                                             vector<unsigned char>& buffer)
+    {
+        Location location = find(filename);
+        buffer.resize(offset < location.dataLength ? std::min<uint64_t>(length, location.dataLength - offset) : 0);
+        readAt(*location.segment, buffer.data(), buffer.size(),
+               location.offset + location.recordSize - location.dataLength + offset);
+        return location.dataLength;
+    }
+
+    string SegmentStorageBackend::getVersion(const string& filename)
+    {
+        return boost::lexical_cast<string>(find(filename).sequence);
+    }
+
+    void SegmentStorageBackend::saveFile(const string& filename, const vector<unsigned char>& buffer)
+    {
+        if (filename.empty()) {
+            throw std::runtime_error("Invalid filename '" + filename + "'.");
+        }
+
+        boost::lock_guard<boost::mutex> appendLock(appendMutex);
+        Location location = appendRecord(filename, buffer.data(), buffer.size(), nextSequence++);
+
+        unique_lock<shared_mutex> writerLock(mutex);
+        auto it = index.find(filename);
+        if (it != index.end()) {
+            it->second.segment->liveBytes -= it->second.recordSize;
+        }
+        location.segment->liveBytes += location.recordSize;
+        index[filename] = location;
+    }
+
+    void SegmentStorageBackend::sync()
+    {
+        vector<shared_ptr<Segment>> pending;
+        {
+            boost::lock_guard<boost::mutex> appendLock(appendMutex);
+            pending.swap(unsynced);
+        }
+        for (auto it = pending.begin(); it != pending.end(); ++it) {
+            if (::fdatasync((*it)->fd) < 0) {
+                int error = errno;
+
+                // Try again with the next sync(), keeping the segments in order: the active
+                // one may have been added back in the meantime.
+                boost::lock_guard<boost::mutex> appendLock(appendMutex);
+                vector<shared_ptr<Segment>> failed(it, pending.end());
+                for (auto segment = unsynced.begin(); segment != unsynced.end(); ++segment) {
+                    if (std::find(failed.begin(), failed.end(), *segment) == failed.end()) {
+                        failed.push_back(*segment);
+                    }
+                }
+                unsynced.swap(failed);
+
+                throw std::runtime_error("Cannot sync segment " + boost::lexical_cast<string>((*it)->id)
+                                         + " (" + strerror(error) + ").");
+            }
+        }
+    }
+
+    int SegmentStorageBackend::compact()
+    {
+        vector<shared_ptr<Segment>> victims;
+        {
+            shared_lock<shared_mutex> readerLock(mutex);
+            // The last segment is the active one
+            for (auto it = segments.begin(); it != segments.end() && it->second != segments.rbegin()->second; ++it) {
+                if (it->second->liveBytes * 2 < it->second->size) {
+                    victims.push_back(it->second);
+                }
+            }
+        }
+
+        int removed = 0;
+        for (auto victim = victims.begin(); victim != victims.end(); ++victim) {
+            vector<std::pair<string, Location>> live;
+            {
+                shared_lock<shared_mutex> readerLock(mutex);
+                for (auto it = index.begin(); it != index.end(); ++it) {
+                    if (it->second.segment == *victim) {
+                        live.push_back(*it);
+                    }
+                }
+            }
+
+            std::set<shared_ptr<Segment>> written;
+            for (auto it = live.begin(); it != live.end(); ++it) {
+                const Location& old = it->second;
+                vector<unsigned char> data(old.dataLength);
+                readAt(*old.segment, data.data(), old.dataLength, old.offset + old.recordSize - old.dataLength);
+
+                // Holding appendMutex, the index cannot be modified by saveFile()
+                boost::lock_guard<boost::mutex> appendLock(appendMutex);
+                {
+                    shared_lock<shared_mutex> readerLock(mutex);
+                    auto current = index.find(it->first);
+                    if (current == index.end() || current->second.segment != old.segment
+                        || current->second.offset != old.offset) {
+                        continue; // Overwritten in the meantime
+                    }
+                }
+                Location copy = appendRecord(it->first, data.data(), data.size(), old.sequence);
+                written.insert(copy.segment);
+
+                unique_lock<shared_mutex> writerLock(mutex);
+                old.segment->liveBytes -= old.recordSize;
+                copy.segment->liveBytes += copy.recordSize;
+                index[it->first] = copy;
+            }
+
+            // Copies must be on disk before the old records are removed
+            for (auto it = written.begin(); it != written.end(); ++it) {
+                if (::fdatasync((*it)->fd) < 0) {
+                    throw std::runtime_error("Cannot sync segment " + boost::lexical_cast<string>((*it)->id)
+                                             + " (" + strerror(errno) + ").");
+                }
+            }
+
+            {
+                unique_lock<shared_mutex> writerLock(mutex);
+                if ((*victim)->liveBytes != 0) {
+                    continue;
+                }
+                segments.erase((*victim)->id);
+            }
+            ::unlink(segmentPath((*victim)->id).c_str());
+            removed++;
+        }
+        return removed;
+    }
+
+    void SegmentStorageBackend::compactionLoop()
+    {
+        boost::unique_lock<boost::mutex> lock(stopMutex);
+        while (!stopping) {
+            stopCondition.timed_wait(lock, boost::posix_time::seconds(compactionInterval));
+            if (stopping) {
+                break;
+            }
+            lock.unlock();
+            try {
+                int removed = compact();
+                if (removed > 0) {
+                    Logger::info("Compacted %1% segment(s).", removed);
+                }
+            }
+            catch (const std::exception& e) {
+                Logger::error("Exception while compacting segments: %1%", e.what());
+            }
+            lock.lock();
+        }
+    }
+}
@@ -0,0 +1,158 @@
+/*
+ * segmentstoragebackend.h
+ */
+
+#ifndef _SEGMENTSTORAGEBACKEND_H_
+#define _SEGMENTSTORAGEBACKEND_H_
+
+#include <istoragebackend.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace storageprovider
+{
+    /// Stores files as records appended to large segment files.
+    ///
+    /// Segments are kept in the "segments" subfolder of the storage path. Each record
+    /// contains a fixed-size header, the filename and the file content; saving a file
+    /// always appends a new record to the active segment, which is sealed once it grows
+    /// beyond a maximum size. An in-memory index maps each filename to the location of
+    /// its latest record, so that loading a file requires a single @c pread() and listing
+    /// files does not touch the disk. The index is rebuilt by scanning all segments when
+    /// the backend is constructed.
+    ///
+    /// A background thread compacts sealed segments in which most records have been
+    /// overwritten, by copying their live records to the active segment.
+    class SegmentStorageBackend: public IStorageBackend
+    {
+    public:
+        /// Constructs a new SegmentStorageBackend, rebuilds the index and starts the
+        /// compaction thread.
+        ///
+        /// @param path The path of the folder where segments are stored.
+        /// @param maxSegmentSize The size (in bytes) beyond which a segment is sealed.
+        /// @param compactionInterval The number of seconds between two compaction runs.
+        ///
+        /// @throws std::runtime_error The segments cannot be opened or read.
+        SegmentStorageBackend(std::string path, uint64_t maxSegmentSize = 64 << 20, int compactionInterval = 30);
+
+        /// Stops the compaction thread.
+        virtual ~SegmentStorageBackend();
+
+        virtual std::vector<std::string> getList();
+
+        virtual void loadFile(const std::string& filename, std::vector<unsigned char>& buffer);
+
+        virtual uint64_t loadFile(const std::string& filename, uint64_t offset, size_t length,
+                                  std::vector<unsigned char>& buffer);
+
+        /// Gets the sequence number of the latest record of the file.
+        virtual std::string getVersion(const std::string& filename);
+
+        virtual void saveFile(const std::string& filename, const std::vector<unsigned char>& buffer);
+
+        virtual void sync();
+
+        /// Rewrites sealed segments whose live data is less than half of their size.
+        ///
+        /// @return The number of segments removed.
+        int compact();
+
+    private:
+        /// An open segment file.
+        struct Segment
+        {
+            Segment(uint32_t id, int fd) :
+                id(id), fd(fd), size(0), liveBytes(0)
+            {
+            }
+
+            /// Closes the file descriptor.
+            ~Segment();
+
+            uint32_t id;
+            int fd;
+            uint64_t size;      ///< Protected by appendMutex for the active segment.
+            uint64_t liveBytes; ///< Protected by mutex.
+        };
+
+        /// The location of the latest record of a file.
+        struct Location
+        {
+            std::shared_ptr<Segment> segment;
+            uint64_t offset;     ///< Offset of the record within the segment.
+            uint64_t recordSize; ///< Size of the whole record (header, name and data).
+            uint64_t dataLength; ///< Size of the file content (at the end of the record).
+            uint64_t sequence;   ///< Increasing write number, used to order records.
+        };
+
+        /// Opens all existing segments and rebuilds the index.
+        void recover();
+
+        /// Scans a segment, adding its records to the index. Returns the size of its valid prefix.
+        uint64_t scanSegment(const std::shared_ptr<Segment>& segment, uint64_t fileSize);
+
+        /// Creates a new empty segment and makes it the active one.
+        void openSegment(uint32_t id);
+
+        /// Appends a record to the active segment. Must be called with appendMutex held.
+        Location appendRecord(const std::string& filename, const unsigned char *data, uint64_t length,
+                              uint64_t sequence);
+
+        /// Gets the location of the latest record of the given file.
+        ///
+        /// @throws std::runtime_error The file does not exist.
+        Location find(const std::string& filename);
+
+        /// Reads part of a segment, retrying on short reads.
+        static void readAt(const Segment& segment, void *data, uint64_t length, uint64_t offset);
+
+        /// Gets the path of the segment file with the given id.
+        std::string segmentPath(uint32_t id) const;
+
+        /// Body of the compaction thread.
+        void compactionLoop();
+
+        std::string path;
+        uint64_t maxSegmentSize;
+        int compactionInterval;
+
+        /// Maps filenames to the location of their latest record.
+        std::unordered_map<std::string, Location> index;
+
+        /// All segments, ordered by id. The last one is the active segment.
+        std::map<uint32_t, std::shared_ptr<Segment>> segments;
+
+        /// The segment to which new records are appended.
+        std::shared_ptr<Segment> active;
+
+        /// Segments written since the last sync(). Protected by appendMutex.
+        std::vector<std::shared_ptr<Segment>> unsynced;
+
+        /// The sequence number of the next record.
+        uint64_t nextSequence;
+
+        /// Protects index, segments and liveBytes of all segments.
+        boost::shared_mutex mutex;
+
+        /// Serializes appends. When both are needed, it must be acquired before mutex.
+        boost::mutex appendMutex;
+
+        boost::thread compactionThread;
+        boost::mutex stopMutex;
+        boost::condition_variable stopCondition;
+        bool stopping;
+    };
+}
+
+#endif
@@ -4,107 +4,150 @@
 
 #include "storageservice.h"
 
-#include <fstream>
+#include <dedupstoragebackend.h>
+#include <filestoragebackend.h>
+#include <segmentstoragebackend.h>
+#include <writebehindstoragebackend.h>
+
+#include <ssoa/service/computepool.h>
+
+#include <stdexcept>
+#include <unordered_map>
 
 #include <boost/filesystem.hpp>
 
-using std::ifstream;
-using std::ofstream;
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
 using std::string;
 using std::vector;
-using boost::shared_mutex;
-using boost::shared_lock;
-using boost::unique_lock;
 
 namespace storageprovider
 {
-    string StorageService::path = "database";
-    shared_mutex StorageService::mutex;
-
-    void StorageService::setPath(string path)
-    {
-        unique_lock<shared_mutex> writerLock(mutex);
-        StorageService::path = path;
-    }
+    std::unique_ptr<IStorageBackend> StorageService::backend;
+    std::unique_ptr<ssoa::ComputePool> StorageService::ioPool;
+    int StorageService::folderLock = -1;
 
-    vector<string> StorageService::getList()
+    void StorageService::initialize(const string& backend, const string& path, const string& durability)
     {
-        shared_lock<shared_mutex> readerLock(mutex);
+        if (durability != "none" && durability != "enqueue" && durability != "fsync") {
+            throw std::runtime_error("Unknown durability '" + durability + "'.");
+        }
 
-        vector<string> files;
+        // Release the previous backend, flushing its writes, before its folder.
+        StorageService::backend.reset();
+        if (folderLock >= 0) {
+            close(folderLock);
+            folderLock = -1;
+        }
 
-        if (!boost::filesystem::exists(path)) {
-            return files;
+        // Lock the folder before the backend starts, since it may recover and rewrite files.
+        boost::filesystem::create_directories(path);
+        int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open the storage folder '" + path + "'.");
+        }
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            close(fd);
+            throw std::runtime_error("The storage folder '" + path + "' is used by another process.");
         }
 
-        for (boost::filesystem::recursive_directory_iterator it(path), end; it != end; ++it) {
-            if (boost::filesystem::is_regular_file(it->status())) {
-                // In returned filenames skip the base path
-                boost::filesystem::path relativePath, skipPath(path);
-                skipPath.normalize();
-                auto itCombined = it->path().begin();
-                for (auto itSkip = skipPath.begin(); itSkip != skipPath.end();) {
-                    if (*itSkip == *itCombined) {
-                        ++itSkip;
-                        ++itCombined;
-                        continue;
-                    }
-                    if (itSkip->string() == ".")
-                        ++itSkip;
-                    else if (itCombined->string() == ".")
-                        ++itCombined;
-                    else
-                        break; // Something went wrong
-                }
-                while (itCombined != it->path().end()) {
-                    relativePath /= *itCombined;
-                    ++itCombined;
-                }
-                files.push_back(relativePath.string());
+        std::unique_ptr<IStorageBackend> storage;
+        try {
+            if (backend == "files") {
+                storage.reset(new FileStorageBackend(path));
+            }
+            else if (backend == "dedup") {
+                storage.reset(new DedupStorageBackend(path));
+            }
+            else if (backend == "segments") {
+                storage.reset(new SegmentStorageBackend(path));
+            }
+            else {
+                throw std::runtime_error("Unknown storage backend '" + backend + "'.");
+            }
+
+            if (durability != "none") {
+                storage.reset(new WriteBehindStorageBackend(std::move(storage), durability == "fsync" ?
+                    WriteBehindStorageBackend::ACK_ON_SYNC : WriteBehindStorageBackend::ACK_ON_ENQUEUE));
             }
         }
-        return files;
+        catch (...) {
+            close(fd);
+            throw;
+        }
+        StorageService::backend = std::move(storage);
+        folderLock = fd;
+        if (!ioPool) {
+            ioPool.reset(new ssoa::ComputePool(maxParallelIO - 1));
+        }
     }
 
-    void StorageService::loadFile(string filename, vector<unsigned char>& buffer)
+    IStorageBackend& StorageService::getBackend()
     {
-        shared_lock<shared_mutex> readerLock(mutex);
+        if (!backend) {
+            throw std::logic_error("StorageService not initialized!");
+        }
+        return *backend;
+    }
 
-        boost::filesystem::path fullPath(path);
-        fullPath /= filename;
+    vector<string> StorageService::getList()
+    {
+        return getBackend().getList();
+    }
 
-        if (!boost::filesystem::exists(fullPath)) {
-            throw std::runtime_error("The specified file '" + string(fullPath.c_str()) + "' does not exist.");
-        }
+    void StorageService::loadFile(string filename, vector<unsigned char>& buffer)
+    {
+        getBackend().loadFile(filename, buffer);
+    }
 
-        ifstream infile(fullPath.c_str(), ifstream::binary | ifstream::in | ifstream::ate);
-        buffer.resize(infile.tellg());
-        infile.seekg(0, ifstream::beg);
-        infile.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
-        infile.close();
-        if (infile.fail()) {
-            throw std::runtime_error("Cannot read file '" + string(fullPath.c_str()) + "' (" + strerror(errno) + ").");
-        }
+    uint64_t StorageService::loadFile(string filename, uint64_t offset, size_t length, vector<unsigned char>& buffer)
+    {
+        return getBackend().loadFile(filename, offset, length, buffer);
+    }
+
+    string StorageService::getVersion(string filename)
+    {
+        return getBackend().getVersion(filename);
     }
 
     void StorageService::saveFile(string filename, const vector<unsigned char>& buffer)
     {
-        unique_lock<shared_mutex> writerLock(mutex);
+        getBackend().saveFile(filename, buffer);
+    }
 
-        boost::filesystem::path fullPath(path);
-        fullPath /= filename;
+    void StorageService::loadFiles(const vector<string>& filenames, vector<vector<unsigned char>>& buffers)
+    {
+        IStorageBackend& storage = getBackend();
+        buffers.clear();
+        buffers.resize(filenames.size());
+        ioPool->run(static_cast<int>(filenames.size()), [&](int i) {
+            storage.loadFile(filenames[i], buffers[i]);
+        });
+    }
 
-        if (!boost::filesystem::exists(fullPath.parent_path())) {
-            if (!boost::filesystem::create_directory(fullPath.parent_path()))
-                throw std::runtime_error("Cannot create folder '" + string(fullPath.parent_path().c_str()) + "'.");
+    void StorageService::saveFiles(const vector<string>& filenames, const vector<vector<unsigned char>>& buffers)
+    {
+        if (filenames.size() != buffers.size()) {
+            throw std::logic_error("The number of filenames and buffers must match.");
         }
+        IStorageBackend& storage = getBackend();
 
-        ofstream outfile(fullPath.c_str(), ofstream::binary | ofstream::out);
-        outfile.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
-        outfile.flush();
-        outfile.close();
-        if (outfile.fail()) {
-            throw std::runtime_error("Cannot write file '" + string(fullPath.c_str()) + "' (" + strerror(errno) + ").");
+        // Writing the same name concurrently would leave an arbitrary content: keep the last.
+        std::unordered_map<string, size_t> last;
+        for (size_t i = 0; i < filenames.size(); i++) {
+            last[filenames[i]] = i;
+        }
+        vector<size_t> indices;
+        for (size_t i = 0; i < filenames.size(); i++) {
+            if (last[filenames[i]] == i) {
+                indices.push_back(i);
+            }
         }
+
+        ioPool->run(static_cast<int>(indices.size()), [&](int i) {
+            storage.saveFile(filenames[indices[i]], buffers[indices[i]]);
+        });
     }
 }
@@ -5,19 +5,45 @@
 #ifndef _STORAGESERVICE_H_
 #define _STORAGESERVICE_H_
 
+#include <istoragebackend.h>
+
+#include <memory>
 #include <string>
 #include <vector>
 
-#include <boost/thread/shared_mutex.hpp>
+namespace ssoa
+{
+    // Forward declaration.
+    class ComputePool;
+}
 
 namespace storageprovider
 {
     /// Reads and writes files from/to a specific folder.
+    ///
+    /// The actual storage is delegated to an IStorageBackend. This class is not thread-safe
+    /// with respect to initialize(), which should be called just once at program startup.
     class StorageService
     {
     public:
-        /// Sets the path of the folder where all files are stored.
-        static void setPath(std::string path);
+        /// Selects the storage backend and the path of the folder where all files are stored.
+        ///
+        /// The folder is locked until the process exits, or initialize() is called again:
+        /// two processes writing the same folder would corrupt it.
+        ///
+        /// @param backend The name of the backend: "files" stores each file as a regular
+        ///        file; "dedup" stores each distinct content just once (see DedupStorageBackend);
+        ///        "segments" appends files to large segment files (see SegmentStorageBackend).
+        /// @param path The path of the folder where all files are stored.
+        /// @param durability "none" saves files synchronously without syncing them;
+        ///        "enqueue" and "fsync" queue writes to a background thread which syncs them
+        ///        in groups (see WriteBehindStorageBackend), returning as soon as the write is
+        ///        queued or once it has been synced to the disk, respectively.
+        ///
+        /// @throws std::runtime_error The backend or the durability is unknown, the folder is
+        ///         locked by another process, or the backend cannot be initialized.
+        static void initialize(const std::string& backend, const std::string& path,
+                               const std::string& durability = "none");
 
         /// Gets the list of all files.
         static std::vector<std::string> getList();
@@ -25,15 +51,58 @@ namespace storageprovider
         /// Loads the file with the given file name.
         static void loadFile(std::string filename, std::vector<unsigned char>& buffer);
 
+        /// Loads at most @c length bytes of the file with the given file name, starting at @c offset.
+        ///
+        /// @return The total size of the file.
+        static uint64_t loadFile(std::string filename, uint64_t offset, size_t length,
+                                 std::vector<unsigned char>& buffer);
+
+        /// Gets a string which changes whenever the file with the given name is modified.
+        static std::string getVersion(std::string filename);
+
         /// Saves a file with the given filename.
         static void saveFile(std::string filename, const std::vector<unsigned char>& buffer);
 
+        /// Loads many files, reading them in parallel on threads shared by all the calls.
+        ///
+        /// @param filenames The names of the files to load.
+        /// @param buffers Replaced by the content of each file, in the same order.
+        ///
+        /// @throws std::runtime_error Some file does not exist or cannot be read.
+        static void loadFiles(const std::vector<std::string>& filenames,
+                              std::vector<std::vector<unsigned char>>& buffers);
+
+        /// Saves many files, writing them in parallel on threads shared by all the calls.
+        ///
+        /// Files are saved independently: if an exception is thrown, some of them may have
+        /// been saved anyway. A name given more than once is saved once, with its last
+        /// content.
+        ///
+        /// @throws std::runtime_error Some file cannot be written.
+        static void saveFiles(const std::vector<std::string>& filenames,
+                              const std::vector<std::vector<unsigned char>>& buffers);
+
+        /// The maximum number of threads performing the I/O of a single loadFiles() or saveFiles(),
+        /// including the calling one; the others are shared by all the calls.
+        static const unsigned maxParallelIO = 8;
+
     private:
         StorageService() {
         }
 
-        static boost::shared_mutex mutex;
-        static std::string path;
+        /// Gets the current backend.
+        ///
+        /// @throws std::logic_error initialize() has not been called yet.
+        static IStorageBackend& getBackend();
+
+        static std::unique_ptr<IStorageBackend> backend;
+
+        /// The threads helping loadFiles() and saveFiles(), so that concurrent batches do not
+        /// start threads of their own.
+        static std::unique_ptr<ssoa::ComputePool> ioPool;
+
+        /// The descriptor of the folder of the backend, locked with flock(); -1 if none.
+        static int folderLock;
     };
 }
 
@@ -0,0 +1,43 @@
+/*
+ * storeimagesserviceimpl.cpp
+ */
+
+#include <storeimagesserviceimpl.h>
+#include <imagebatch.h>
+#include <storageservice.h>
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+using namespace ssoa;
+
+namespace storageprovider
+{
+    Response * StoreImagesServiceImpl::invoke()
+    {
+        std::unique_ptr<ServiceBufferArgument> namesArg(popArgument<ServiceBufferArgument>());
+        std::unique_ptr<ServiceBufferArgument> blobsArg(popArgument<ServiceBufferArgument>());
+        std::unique_ptr<ServiceBufferArgument> offsetsArg(popArgument<ServiceBufferArgument>());
+
+        const vector<unsigned char>& blobs = blobsArg->getValue();
+        vector<string> names = imagebatch::decodeNames(namesArg->getValue());
+        vector<uint32_t> offsets = imagebatch::decodeOffsets(offsetsArg->getValue(), blobs.size());
+        if (names.size() != offsets.size()) {
+            return new Response(serviceSignature(), false, "The number of names and offsets must match.");
+        }
+
+        vector<vector<unsigned char>> images(names.size());
+        uint32_t begin = 0;
+        for (size_t i = 0; i < images.size(); i++) {
+            images[i].assign(blobs.begin() + begin, blobs.begin() + offsets[i]);
+            begin = offsets[i];
+        }
+
+        StorageService::saveFiles(names, images);
+        Logger::info("Stored %1% images (%2% bytes).", images.size(), blobs.size());
+
+        return new Response(serviceSignature(), true, "OK");
+    }
+}
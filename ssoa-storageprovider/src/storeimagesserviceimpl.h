@@ -0,0 +1,44 @@
+/*
+ * storeimagesserviceimpl.h
+ */
+
+#ifndef _STOREIMAGESSERVICEIMPL_H_
+#define _STOREIMAGESSERVICEIMPL_H_
+
+#include <ssoa/service/servicesignature.h>
+#include <ssoa/service/serviceskeleton.h>
+
+namespace storageprovider
+{
+    /// Implements the "StoreImages" service.
+    ///
+    /// Input arguments use the same format as the output of the "GetImages" service: the
+    /// NUL-terminated image names, the concatenated image data and the end offsets.
+    class StoreImagesServiceImpl: public ssoa::ServiceSkeleton
+    {
+        StoreImagesServiceImpl(arg_deque arguments) :
+            ssoa::ServiceSkeleton(ssoa::ServiceSignature(serviceSignature()), std::move(arguments))
+        {
+        }
+
+    public:
+        /// Constructs a new instance of StoreImagesServiceImpl from the given arguments.
+        static ssoa::ServiceSkeleton* create(arg_deque&& arguments) {
+            return new StoreImagesServiceImpl(std::move(arguments));
+        }
+
+        /// Gets the signature of this type of service.
+        static const char * serviceSignature() {
+            return "StoreImages(in buffer, in buffer, in buffer)";
+        }
+
+        /// Installs the creation method.
+        static void install() {
+            factory().install(serviceSignature(), create);
+        }
+
+        virtual ssoa::Response * invoke();
+    };
+}
+
+#endif
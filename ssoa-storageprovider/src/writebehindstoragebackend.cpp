@@ -0,0 +1,216 @@
+/*
+ * writebehindstoragebackend.cpp
+ */
+
+#include <writebehindstoragebackend.h>
+#include <dedupstoragebackend.h>
+
+#include <ssoa/logger.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+using boost::unique_lock;
+using ssoa::Logger;
+
+namespace storageprovider
+{
+    WriteBehindStorageBackend::WriteBehindStorageBackend(std::unique_ptr<IStorageBackend> backend,
+                                                         Durability durability, size_t maxQueuedBytes) :
+        backend(std::move(backend)), durability(durability), maxQueuedBytes(maxQueuedBytes),
+        queuedBytes(0), takenGroup(0), completedGroup(0), stopping(false)
+    {
+        writerThread = boost::thread(&WriteBehindStorageBackend::writeLoop, this);
+    }
+
+    WriteBehindStorageBackend::~WriteBehindStorageBackend()
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(mutex);
+            stopping = true;
+        }
+        queueCondition.notify_all();
+        writerThread.join();
+    }
+
+    vector<string> WriteBehindStorageBackend::getList()
+    {
+        std::set<string> names;
+        {
+            boost::lock_guard<boost::mutex> lock(mutex);
+            for (const auto& write : pending) {
+                names.insert(write.first);
+            }
+        }
+
+        // Files completed after the snapshot above are listed by the backend too.
+        vector<string> list = backend->getList();
+        for (const string& name : list) {
+            names.erase(name);
+        }
+        list.insert(list.end(), names.begin(), names.end());
+        return list;
+    }
+
+    shared_ptr<WriteBehindStorageBackend::Write> WriteBehindStorageBackend::findPending(const string& filename)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        auto it = pending.find(filename);
+        return it != pending.end() ? it->second : shared_ptr<Write>();
+    }
+
+    void WriteBehindStorageBackend::loadFile(const string& filename, vector<unsigned char>& buffer)
+    {
+        // The data of a queued write is never modified, so it can be read without the lock.
+        shared_ptr<Write> write = findPending(filename);
+        if (write) {
+            buffer = write->data;
+            return;
+        }
+        backend->loadFile(filename, buffer);
+    }
+
+    uint64_t WriteBehindStorageBackend::loadFile(const string& filename, uint64_t offset, size_t length,
+                                                 vector<unsigned char>& buffer)
+    {
+        shared_ptr<Write> write = findPending(filename);
+        if (!write) {
+            return backend->loadFile(filename, offset, length, buffer);
+        }
+
+        const vector<unsigned char>& data = write->data;
+        if (offset < data.size()) {
+            size_t count = std::min<uint64_t>(length, data.size() - offset);
+            buffer.assign(data.begin() + offset, data.begin() + offset + count);
+        }
+        else {
+            buffer.clear();
+        }
+        return data.size();
+    }
+
+    string WriteBehindStorageBackend::getVersion(const string& filename)
+    {
+        shared_ptr<Write> write = findPending(filename);
+        if (!write) {
+            return backend->getVersion(filename);
+        }
+        return DedupStorageBackend::contentHash(write->data);
+    }
+
+    void WriteBehindStorageBackend::saveFile(const string& filename, const vector<unsigned char>& buffer)
+    {
+        shared_ptr<Write> write(new Write{filename, buffer, 0, string()});
+
+        unique_lock<boost::mutex> lock(mutex);
+        while (queuedBytes > 0 && queuedBytes + buffer.size() > maxQueuedBytes) {
+            completedCondition.wait(lock);
+        }
+
+        queue.push_back(write);
+        pending[filename] = write;
+        queuedBytes += buffer.size();
+        queueCondition.notify_one();
+
+        if (durability == ACK_ON_SYNC) {
+            while (write->group == 0 || completedGroup < write->group) {
+                completedCondition.wait(lock);
+            }
+            if (!write->error.empty()) {
+                throw std::runtime_error(write->error);
+            }
+        }
+    }
+
+    void WriteBehindStorageBackend::sync()
+    {
+        unique_lock<boost::mutex> lock(mutex);
+
+        // The I/O thread takes the whole queue as the next group.
+        uint64_t group = queue.empty() ? takenGroup : takenGroup + 1;
+        while (completedGroup < group) {
+            completedCondition.wait(lock);
+        }
+
+        if (!lastError.empty()) {
+            string error;
+            error.swap(lastError);
+            throw std::runtime_error(error);
+        }
+    }
+
+    void WriteBehindStorageBackend::writeLoop()
+    {
+        unique_lock<boost::mutex> lock(mutex);
+        while (true) {
+            while (queue.empty() && !stopping) {
+                queueCondition.wait(lock);
+            }
+            if (queue.empty()) {
+                break;
+            }
+
+            std::deque<shared_ptr<Write>> group;
+            group.swap(queue);
+            uint64_t id = ++takenGroup;
+            for (const auto& write : group) {
+                write->group = id;
+            }
+            lock.unlock();
+
+            // Only the last write of each file in the group needs to reach the disk, and its
+            // outcome is also the outcome of the earlier writes of the same file.
+            std::map<string, string> saved;
+            string error;
+            for (auto it = group.rbegin(); it != group.rend(); ++it) {
+                Write& write = **it;
+                if (saved.count(write.filename) > 0) {
+                    continue;
+                }
+                string& result = saved[write.filename];
+                try {
+                    backend->saveFile(write.filename, write.data);
+                }
+                catch (const std::exception& e) {
+                    result = e.what();
+                    error = result;
+                    Logger::error("Exception while saving file '%1%': %2%", write.filename, result);
+                }
+            }
+            for (const auto& write : group) {
+                write->error = saved[write->filename];
+            }
+            try {
+                backend->sync();
+            }
+            catch (const std::exception& e) {
+                error = e.what();
+                Logger::error("Exception while syncing storage: %1%", error);
+                for (const auto& write : group) {
+                    if (write->error.empty()) {
+                        write->error = error;
+                    }
+                }
+            }
+
+            lock.lock();
+            completedGroup = id;
+            for (const auto& write : group) {
+                queuedBytes -= write->data.size();
+                auto it = pending.find(write->filename);
+                if (it != pending.end() && it->second == write) {
+                    pending.erase(it);
+                }
+            }
+            if (!error.empty()) {
+                lastError = error;
+            }
+            completedCondition.notify_all();
+        }
+    }
+}
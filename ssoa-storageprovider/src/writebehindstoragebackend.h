@@ -0,0 +1,115 @@
+/*
+ * writebehindstoragebackend.h
+ */
+
+#ifndef _WRITEBEHINDSTORAGEBACKEND_H_
+#define _WRITEBEHINDSTORAGEBACKEND_H_
+
+#include <istoragebackend.h>
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace storageprovider
+{
+    /// Queues writes and performs them on a dedicated I/O thread.
+    ///
+    /// The I/O thread takes all queued writes as a group, saves them through the wrapped
+    /// backend and then calls its sync() method just once for the whole group (group
+    /// commit). Files which are still queued are served from memory, so a loadFile() always
+    /// returns the content of the latest saveFile().
+    class WriteBehindStorageBackend: public IStorageBackend
+    {
+    public:
+        /// Specifies when saveFile() returns.
+        enum Durability
+        {
+            ACK_ON_ENQUEUE, ///< As soon as the write is queued; errors are only logged.
+            ACK_ON_SYNC     ///< When the write has been saved and synced to the disk.
+        };
+
+        /// Constructs a new WriteBehindStorageBackend and starts the I/O thread.
+        ///
+        /// @param backend The backend which actually stores the files.
+        /// @param durability Specifies when saveFile() returns.
+        /// @param maxQueuedBytes The maximum size of queued data: when it is exceeded,
+        ///        saveFile() blocks until some writes are completed.
+        WriteBehindStorageBackend(std::unique_ptr<IStorageBackend> backend, Durability durability,
+                                  size_t maxQueuedBytes = 256 << 20);
+
+        /// Completes all queued writes and stops the I/O thread.
+        virtual ~WriteBehindStorageBackend();
+
+        virtual std::vector<std::string> getList();
+
+        virtual void loadFile(const std::string& filename, std::vector<unsigned char>& buffer);
+
+        virtual uint64_t loadFile(const std::string& filename, uint64_t offset, size_t length,
+                                  std::vector<unsigned char>& buffer);
+
+        /// Gets the version from the wrapped backend or, for queued files, the content hash.
+        virtual std::string getVersion(const std::string& filename);
+
+        virtual void saveFile(const std::string& filename, const std::vector<unsigned char>& buffer);
+
+        /// Waits until all writes queued so far have been saved and synced.
+        ///
+        /// @throws std::runtime_error Some of those writes failed.
+        virtual void sync();
+
+    private:
+        /// A queued write.
+        struct Write
+        {
+            std::string filename;
+            std::vector<unsigned char> data;
+            uint64_t group;    ///< The group commit including this write (0 if not taken yet).
+            std::string error; ///< Set if the write failed.
+        };
+
+        /// Gets the latest queued write of the given file, or NULL if there is none.
+        std::shared_ptr<Write> findPending(const std::string& filename);
+
+        /// Body of the I/O thread.
+        void writeLoop();
+
+        std::unique_ptr<IStorageBackend> backend;
+        Durability durability;
+        size_t maxQueuedBytes;
+
+        /// Writes not yet taken by the I/O thread.
+        std::deque<std::shared_ptr<Write>> queue;
+
+        /// The latest write of each file which is not completed yet.
+        std::map<std::string, std::shared_ptr<Write>> pending;
+
+        /// The size of data of all writes in pending.
+        size_t queuedBytes;
+
+        /// The last group taken by the I/O thread, and the last one completed.
+        uint64_t takenGroup;
+        uint64_t completedGroup;
+
+        /// The error of the last failed write since the last call to sync().
+        std::string lastError;
+
+        bool stopping;
+
+        /// Protects all the fields above.
+        boost::mutex mutex;
+        boost::condition_variable queueCondition;
+        boost::condition_variable completedCondition;
+
+        boost::thread writerThread;
+    };
+}
+
+#endif